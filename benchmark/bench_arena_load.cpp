@@ -0,0 +1,156 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+  Allocations and time of the containers of an application, in its arena
+  and on the heap, and of whole loads. Build it twice, the second time
+  without the arena of the applications, and compare the whole loads.
+  Build and run from the root of the repository:
+    g++ -std=c++17 -O2 -I include -I . benchmark/bench_arena_load.cpp \
+        -o bench_arena_load -pthread
+    g++ -std=c++17 -O2 -DOPT_COMMON_WITHOUT_APPLICATION_ARENA -I include \
+        -I . benchmark/bench_arena_load.cpp -o bench_heap_load -pthread
+    ./bench_arena_load [NUMBER_OF_JOBS] && ./bench_heap_load [NUMBER_OF_JOBS]
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <opt_common/Application.hpp>
+#include <opt_common/configuration.hpp>
+#include <string>
+#include "test/trace_fixture.hpp"
+
+namespace {
+
+std::atomic<std::size_t> number_of_allocations(0);
+
+struct Measure {
+  std::size_t allocations;
+  double milliseconds;
+};
+
+template <typename Function>
+Measure measure(Function&& function) {
+  const std::size_t allocations_before = number_of_allocations;
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return Measure{number_of_allocations - allocations_before, elapsed.count()};
+}
+
+void print(const char* name, const Measure& measure) {
+  std::cout << name << ": " << measure.allocations << " allocations, "
+            << measure.milliseconds << " ms\n";
+}
+
+}  // namespace
+
+// Count the allocations (the pmr resources allocate with the aligned form)
+void* operator new(std::size_t size) {
+  ++number_of_allocations;
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  ++number_of_allocations;
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  if (void* pointer = std::aligned_alloc(
+          align, (size + align - 1) / align * align)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+// Not inlined, the compiler cannot pair them with the allocations
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+__attribute__((noinline)) void operator delete(void* pointer,
+                                               std::size_t) noexcept {
+  std::free(pointer);
+}
+__attribute__((noinline)) void operator delete(void* pointer,
+                                               std::align_val_t) noexcept {
+  std::free(pointer);
+}
+__attribute__((noinline)) void operator delete(void* pointer, std::size_t,
+                                               std::align_val_t) noexcept {
+  std::free(pointer);
+}
+
+int main(int argc, char* argv[]) {
+  using opt_common::Application;
+
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = argc > 1 ? std::stoul(argv[1]) : 20000;
+  spec.stages_per_job = 4;
+  spec.tasks_per_stage = 8;
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  std::cout << "Trace: " << spec.number_of_jobs << " jobs, "
+            << spec.number_of_jobs * spec.stages_per_job << " stages\n";
+#ifdef OPT_COMMON_WITHOUT_APPLICATION_ARENA
+  std::cout << "Applications on the heap\n";
+#else
+  std::cout << "Applications in their arena\n";
+#endif
+
+  // Whole loads: parse, build and release an application
+  constexpr unsigned REPETITIONS = 5;
+  opt_common::Configuration configuration;
+  configuration.read_configuration_from_file(dir.get_path() + "/config.txt");
+  const Measure loads = measure([&]() {
+    opt_common_test::QuietStdout quiet;
+    for (unsigned i = 0; i < REPETITIONS; ++i) {
+      Application::create_application(input, configuration);
+    }
+  });
+  print("load and release (average)",
+        Measure{loads.allocations / REPETITIONS,
+                loads.milliseconds / REPETITIONS});
+
+  Application app;
+  print("load", measure([&]() {
+          opt_common_test::QuietStdout quiet;
+          app = Application::create_application(input, configuration);
+        }));
+
+  // The same containers, built and destroyed in an arena or on the heap
+  const auto copy_containers = [&](std::pmr::memory_resource* resource) {
+    Application::JobsMap jobs(app.get_all_jobs(), resource);
+    Application::StagesMap stages(app.get_all_stages(), resource);
+  };
+  print("containers in arena", measure([&]() {
+          std::pmr::monotonic_buffer_resource arena;
+          copy_containers(&arena);
+        }));
+  print("containers on heap", measure([&]() {
+          copy_containers(std::pmr::new_delete_resource());
+        }));
+
+  print("teardown", measure([&]() { app = Application(); }));
+  return 0;
+}
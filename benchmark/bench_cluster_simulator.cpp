@@ -0,0 +1,97 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+  Throughput of the cluster simulator: applications simulated per second
+  with each policy, on a workload arriving at a steady rate that keeps the
+  pool busy for about LOAD of its time.
+  Build and run from the root of the repository:
+    g++ -std=c++17 -O2 -I include -I . benchmark/bench_cluster_simulator.cpp \
+        -o bench_cluster_simulator -pthread
+    ./bench_cluster_simulator [NUMBER_OF_APPLICATIONS] [LOAD]
+*/
+
+#include <chrono>
+#include <iostream>
+#include <opt_common/Application.hpp>
+#include <opt_common/ClusterSimulator.hpp>
+#include <opt_common/configuration.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::ClusterSimulator;
+using opt_common::TimeInstant;
+
+int main(int argc, char* argv[]) {
+  const std::size_t number_of_applications =
+      argc > 1 ? std::stoul(argv[1]) : 20000;
+  const double load = argc > 2 ? std::stod(argv[2]) : 0.9;
+  constexpr unsigned NUMBER_OF_CONTAINERS = 256;
+
+  // A few different applications of 15 stages and 600 tasks
+  std::vector<Application> applications;
+  double work_ms = 0;  // Average core time of an application
+  for (std::uint64_t seed = 1; seed <= 4; ++seed) {
+    opt_common_test::TraceSpec spec;
+    spec.number_of_jobs = 5;
+    spec.tasks_per_stage = 40;
+    spec.seed = seed;
+
+    opt_common_test::TemporaryDirectory dir;
+    const std::string input =
+        opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+    opt_common_test::QuietStdout quiet;
+    applications.push_back(
+        Application::create_application(input, dir.get_path() + "/config.txt"));
+    for (const auto& stage_pair : applications.back().get_all_stages()) {
+      work_ms += stage_pair.second.get_number_of_tasks() *
+                 stage_pair.second.get_avg_time().to_milliseconds();
+    }
+  }
+  work_ms /= applications.size();
+
+  // Arrivals spaced to offer `load` of the containers
+  const double interarrival_ms = work_ms / (NUMBER_OF_CONTAINERS * load);
+  ClusterSimulator simulator(NUMBER_OF_CONTAINERS);
+  for (std::size_t i = 0; i < number_of_applications; ++i) {
+    simulator.add_application(
+        applications[i % applications.size()],
+        TimeInstant::from_milliseconds(
+            static_cast<TimeInstant::Rep>(i * interarrival_ms)));
+  }
+  std::cout << "Workload: " << number_of_applications << " applications on "
+            << NUMBER_OF_CONTAINERS << " containers, offered load " << load
+            << "\n";
+
+  const std::pair<const char*, ClusterSimulator::Policy> policies[] = {
+      {"fifo", ClusterSimulator::Policy::FIFO},
+      {"weighted_fair", ClusterSimulator::Policy::WEIGHTED_FAIR},
+      {"edf", ClusterSimulator::Policy::EDF}};
+  for (const auto& policy : policies) {
+    const auto start = std::chrono::steady_clock::now();
+    const ClusterSimulator::Report report = simulator.run(policy.second);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << policy.first << ": " << elapsed.count() * 1000 << " ms, "
+              << number_of_applications / elapsed.count()
+              << " applications/s, utilization " << report.utilization
+              << ", events " << report.number_of_events << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+  Error of the estimates of the execution time at the recorded cores, on a
+  trace of many small jobs with the driver idling between them: the stages
+  flattened (Application::compute_avg_execution_time) and the job model
+  (JobExecutionModel), against the real execution time of the trace.
+  Build and run from the root of the repository:
+    g++ -std=c++17 -O2 -I include -I . benchmark/bench_job_model.cpp \
+        -o bench_job_model -pthread
+    ./bench_job_model [NUMBER_OF_JOBS] [JOBS_GAP_MS]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <opt_common/Application.hpp>
+#include <opt_common/JobExecutionModel.hpp>
+#include <string>
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::JobExecutionModel;
+
+namespace {
+
+double percentage_error(double estimate, double real) {
+  return std::abs(estimate - real) / real * 100;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = argc > 1 ? std::stoul(argv[1]) : 3000;
+  spec.stages_per_job = 2;
+  spec.tasks_per_stage = 12;
+  spec.recorded_cores = 8;
+  spec.jobs_gap_ms = argc > 2 ? std::stoul(argv[2]) : 800;
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  Application app;
+  {
+    opt_common_test::QuietStdout quiet;
+    app = Application::create_application(input,
+                                          dir.get_path() + "/config.txt");
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const JobExecutionModel model(app);
+  const std::chrono::duration<double, std::milli> compile_ms =
+      std::chrono::steady_clock::now() - start;
+
+  const double real_ms = app.get_real_execution_time().to_milliseconds();
+  const double flattened_ms =
+      app.compute_avg_execution_time(spec.recorded_cores).to_milliseconds();
+  const double job_model_ms =
+      model.compute_execution_time(spec.recorded_cores).to_milliseconds();
+
+  std::cout << "Trace: " << spec.number_of_jobs << " jobs of "
+            << spec.stages_per_job << " stages of " << spec.tasks_per_stage
+            << " tasks, " << spec.jobs_gap_ms << " ms between the jobs, "
+            << spec.recorded_cores << " cores\n"
+            << "real: " << real_ms << " ms\n"
+            << "flattened stages: " << flattened_ms << " ms (error "
+            << percentage_error(flattened_ms, real_ms) << "%)\n"
+            << "job model: " << job_model_ms << " ms (error "
+            << percentage_error(job_model_ms, real_ms) << "%), compiled in "
+            << compile_ms.count() << " ms\n";
+  return 0;
+}
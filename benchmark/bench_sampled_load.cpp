@@ -0,0 +1,90 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+  Load time of a trace with all the tasks and with a sample of them.
+  Build and run from the root of the repository:
+    g++ -std=c++17 -O2 -I include -I . benchmark/bench_sampled_load.cpp \
+        -o bench_sampled_load -pthread
+    ./bench_sampled_load [NUMBER_OF_TASKS]
+*/
+
+#include <chrono>
+#include <iostream>
+#include <opt_common/Application.hpp>
+#include <opt_common/configuration.hpp>
+#include <string>
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::TasksSamplingOptions;
+
+namespace {
+
+double load_milliseconds(const std::string& input,
+                         const opt_common::Configuration& configuration,
+                         const TasksSamplingOptions& sampling,
+                         Application* app) {
+  constexpr unsigned REPETITIONS = 5;
+  opt_common_test::QuietStdout quiet;
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < REPETITIONS; ++i) {
+    *app = Application::create_application(input, configuration, sampling);
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / REPETITIONS;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = 1000;
+  spec.stages_per_job = 3;
+  spec.tasks_per_stage =
+      (argc > 1 ? std::stoul(argv[1]) : 600000) / (1000 * 3);
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  opt_common::Configuration configuration;
+  configuration.read_configuration_from_file(dir.get_path() + "/config.txt");
+  std::cout << "Trace: "
+            << spec.number_of_jobs * spec.stages_per_job *
+                   spec.tasks_per_stage
+            << " tasks\n";
+
+  Application app;
+  const double full_ms =
+      load_milliseconds(input, configuration, TasksSamplingOptions(), &app);
+  const auto full_time = app.compute_avg_execution_time(spec.recorded_cores);
+  std::cout << "all the tasks: " << full_ms << " ms\n";
+
+  for (const double rate : {0.1, 0.01}) {
+    TasksSamplingOptions sampling;
+    sampling.sampling_rate = rate;
+    const double sampled_ms =
+        load_milliseconds(input, configuration, sampling, &app);
+    const auto interval =
+        app.compute_avg_execution_time_interval(spec.recorded_cores);
+    std::cout << "rate " << rate << ": " << sampled_ms << " ms ("
+              << full_ms / sampled_ms << "x), T = " << interval.estimate
+              << " [" << interval.lower << ", " << interval.upper
+              << "], all the tasks " << full_time << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+  Load time of an application parsed from the trace files and taken from
+  the shared memory cache (as another process would).
+  Build and run from the root of the repository:
+    g++ -std=c++17 -O2 -I include -I . benchmark/bench_shared_cache.cpp \
+        -o bench_shared_cache -pthread -lrt
+    ./bench_shared_cache [NUMBER_OF_TASKS]
+*/
+
+#include <chrono>
+#include <iostream>
+#include <opt_common/SharedApplicationCache.hpp>
+#include <string>
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::SharedApplicationCache;
+
+namespace {
+
+template <typename Function>
+double milliseconds(Function&& function) {
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = 1000;
+  spec.stages_per_job = 3;
+  spec.tasks_per_stage =
+      (argc > 1 ? std::stoul(argv[1]) : 600000) / (1000 * 3);
+
+  opt_common_test::TemporaryDirectory dir;
+  opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  opt_common::Configuration configuration;
+  configuration.read_configuration_from_file(dir.get_path() + "/config.txt");
+  const Application::FileResources resources{
+      "app.csv", "jobs.csv", "stages.csv", "tasks.csv", "app.lua", "infra.txt"};
+  std::cout << "Trace: "
+            << spec.number_of_jobs * spec.stages_per_job *
+                   spec.tasks_per_stage
+            << " tasks\n";
+
+  Application app;
+  opt_common::SharedApplicationView view;
+  double parse_ms, cold_ms, warm_ms, map_ms;
+  {
+    opt_common_test::QuietStdout quiet;
+    SharedApplicationCache::remove_application(resources, configuration);
+    parse_ms = milliseconds([&]() {
+      app = Application::create_application(resources, configuration,
+                                            "50000");
+    });
+    cold_ms = milliseconds([&]() {
+      app = SharedApplicationCache::load_application(resources, configuration,
+                                                     "50000");
+    });
+    warm_ms = milliseconds([&]() {
+      app = SharedApplicationCache::load_application(resources, configuration,
+                                                     "50000");
+    });
+    map_ms = milliseconds([&]() {
+      view = SharedApplicationCache::map_application(resources, configuration);
+    });
+    SharedApplicationCache::remove_application(resources, configuration);
+  }
+
+  std::cout << "parse: " << parse_ms << " ms\n"
+            << "cold load (parse and publish): " << cold_ms << " ms\n"
+            << "warm load (application from the segment): " << warm_ms
+            << " ms\n"
+            << "warm map (view of the segment): " << map_ms << " ms\n"
+            << "T(8) " << app.compute_avg_execution_time(8) << " "
+            << view.compute_avg_execution_time(8) << "\n";
+  return 0;
+}
@@ -0,0 +1,142 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+  Simulations run by the surrogate-guided search and by a plain bisection
+  on the simulator, finding the minimum number of cores for a range of
+  deadlines. The simulator differs from the analytic model by a bias and a
+  noise (fixed for each number of cores), as a real simulator would.
+  Build and run from the root of the repository:
+    g++ -std=c++17 -O2 -I include -I . benchmark/bench_surrogate_search.cpp \
+        -o bench_surrogate_search -pthread
+    ./bench_surrogate_search [NUMBER_OF_TASKS] [BIAS] [NOISE]
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <opt_common/Application.hpp>
+#include <opt_common/SurrogateSearch.hpp>
+#include <opt_common/configuration.hpp>
+#include <random>
+#include <set>
+#include <string>
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::SurrogateGuidedSearch;
+using opt_common::TimeInstant;
+
+namespace {
+
+constexpr unsigned MAX_CORES = 2048;
+constexpr std::size_t NUMBER_OF_DEADLINES = 50;
+
+/*! \return the minimum cores meeting `deadline` (0 if none), as
+    find_min_cores but calling the simulator for each probe. The cores
+    simulated are added to `simulated_cores`.
+ */
+unsigned bisect_min_cores(const SurrogateGuidedSearch::Simulator& simulator,
+                          const TimeInstant& deadline,
+                          std::size_t* number_of_simulations,
+                          std::set<unsigned>* simulated_cores) {
+  const auto meets_deadline = [&](unsigned n_cores) {
+    ++*number_of_simulations;
+    simulated_cores->insert(n_cores);
+    return simulator(n_cores) <= deadline;
+  };
+  if (!meets_deadline(MAX_CORES)) {
+    return 0;
+  }
+  unsigned low = 1, high = MAX_CORES;
+  while (low < high) {
+    const unsigned middle = low + (high - low) / 2;
+    if (meets_deadline(middle)) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return high;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const double bias = argc > 2 ? std::stod(argv[2]) : 0.2;
+  const double noise = argc > 3 ? std::stod(argv[3]) : 0.03;
+
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = 1000;
+  spec.stages_per_job = 3;
+  spec.tasks_per_stage =
+      (argc > 1 ? std::stoul(argv[1]) : 600000) / (1000 * 3);
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  Application app;
+  {
+    opt_common_test::QuietStdout quiet;
+    app = Application::create_application(input,
+                                          dir.get_path() + "/config.txt");
+  }
+
+  const SurrogateGuidedSearch::Simulator simulator = [&](unsigned n_cores) {
+    std::mt19937_64 random_engine(n_cores);
+    std::normal_distribution<double> log_noise(0, noise);
+    const double analytic_ms =
+        app.compute_avg_execution_time(n_cores).to_milliseconds();
+    return TimeInstant::from_milliseconds(
+        analytic_ms * (1 + bias) * std::exp(log_noise(random_engine)));
+  };
+
+  // Deadlines spaced geometrically between the fastest and slowest runs
+  const double fastest_ms = simulator(MAX_CORES).to_milliseconds();
+  const double slowest_ms = simulator(1).to_milliseconds();
+
+  SurrogateGuidedSearch search(app, simulator);
+  std::size_t bisection_simulations = 0, mismatches = 0;
+  std::set<unsigned> bisection_cores_simulated;
+  for (std::size_t i = 0; i < NUMBER_OF_DEADLINES; ++i) {
+    const double fraction = (i + 0.5) / NUMBER_OF_DEADLINES;
+    const TimeInstant deadline = TimeInstant::from_milliseconds(
+        fastest_ms * std::pow(slowest_ms / fastest_ms, fraction));
+    const unsigned bisection_cores =
+        bisect_min_cores(simulator, deadline, &bisection_simulations,
+                         &bisection_cores_simulated);
+    const unsigned hybrid_cores = search.find_min_cores(deadline, 1, MAX_CORES);
+    if (hybrid_cores != bisection_cores) {
+      ++mismatches;
+    }
+  }
+
+  std::cout << "Trace: "
+            << spec.number_of_jobs * spec.stages_per_job *
+                   spec.tasks_per_stage
+            << " tasks, simulator bias " << bias << ", noise " << noise
+            << "\n"
+            << NUMBER_OF_DEADLINES << " deadlines, cores in [1, " << MAX_CORES
+            << "]\n"
+            << "bisection: " << bisection_simulations << " simulations ("
+            << bisection_cores_simulated.size()
+            << " if cached across deadlines)\n"
+            << "surrogate-guided: " << search.get_number_of_simulations()
+            << " simulations (" << search.get_number_of_probes()
+            << " probes)\n"
+            << "different minimum cores: " << mismatches << "\n";
+  return 0;
+}
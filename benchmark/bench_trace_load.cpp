@@ -0,0 +1,125 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+  Time to read the tasks file of a trace: split in rows of strings (as the
+  loader did before CsvRowDecoder) and decoded in place, and the load time
+  of the whole application.
+  Build and run from the root of the repository:
+    g++ -std=c++17 -O2 -I include -I . benchmark/bench_trace_load.cpp \
+        -o bench_trace_load -pthread
+    ./bench_trace_load [NUMBER_OF_TASKS]
+*/
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <opt_common/Application.hpp>
+#include <opt_common/CsvSchema.hpp>
+#include <opt_common/configuration.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+
+namespace {
+
+constexpr unsigned REPETITIONS = 5;
+
+using StageTimes = std::map<unsigned, std::vector<unsigned long>>;
+
+template <typename Function>
+double milliseconds(Function function) {
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < REPETITIONS; ++i) {
+    function();
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / REPETITIONS;
+}
+
+// Each row is a vector of strings, the values are converted with stoul
+void read_split_rows(const std::string& tasks_file, StageTimes* times) {
+  opt_common::CSV_Data rows;
+  opt_common::read_csv_file(tasks_file, &rows);
+  times->clear();
+  for (std::size_t i = 1; i < rows.size(); ++i) {
+    const auto& row = rows[i];
+    (*times)[std::stoul(row.at(16))].push_back(std::stoul(row.at(5)) -
+                                                std::stoul(row.at(4)));
+  }
+}
+
+void read_decoded_rows(const std::string& tasks_file, StageTimes* times) {
+  opt_common::CsvRowDecoder<unsigned long, unsigned long, unsigned> decoder(
+      std::array<opt_common::CsvColumn, 3>{
+          {{"Launch Time", 4}, {"Finish Time", 5}, {"Stage ID", 16}}});
+  unsigned long launch_time, finish_time;
+  unsigned stage_id;
+
+  times->clear();
+  std::uint64_t offset = 0;
+  opt_common::for_each_csv_row_from_offset(
+      tasks_file, &offset, &decoder, [&](std::string_view line) {
+        if (decoder.decode(line, &launch_time, &finish_time, &stage_id)) {
+          (*times)[stage_id].push_back(finish_time - launch_time);
+        }
+      });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = 1000;
+  spec.stages_per_job = 3;
+  spec.tasks_per_stage =
+      (argc > 1 ? std::stoul(argv[1]) : 600000) / (1000 * 3);
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  const std::string tasks_file = dir.get_path() + "/tasks.csv";
+  opt_common::Configuration configuration;
+  configuration.read_configuration_from_file(dir.get_path() + "/config.txt");
+  std::cout << "Trace: "
+            << spec.number_of_jobs * spec.stages_per_job *
+                   spec.tasks_per_stage
+            << " tasks\n";
+
+  StageTimes split_times, decoded_times;
+  const double split_ms =
+      milliseconds([&]() { read_split_rows(tasks_file, &split_times); });
+  const double decoded_ms =
+      milliseconds([&]() { read_decoded_rows(tasks_file, &decoded_times); });
+  std::cout << "tasks file, rows of strings: " << split_ms << " ms\n"
+            << "tasks file, decoded rows: " << decoded_ms << " ms ("
+            << split_ms / decoded_ms << "x), same times: "
+            << (split_times == decoded_times ? "yes" : "no") << "\n";
+
+  Application app;
+  const double load_ms = milliseconds([&]() {
+    opt_common_test::QuietStdout quiet;
+    app = Application::create_application(input, configuration);
+  });
+  std::cout << "whole application: " << load_ms << " ms\n";
+  return 0;
+}
@@ -17,21 +17,61 @@ limitations under the License.
 #ifndef __OPT_COMMON__APPLICATION__HPP
 #define __OPT_COMMON__APPLICATION__HPP
 #include <cassert>
+#include <cmath>
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <opt_common/CsvSchema.hpp>
 #include <opt_common/InfrastructureConfiguration.hpp>
 #include <opt_common/Job.hpp>
 #include <opt_common/MachineLearningModel.hpp>
 #include <opt_common/Stage.hpp>
 #include <opt_common/configuration.hpp>
+#include <random>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace opt_common {
+
+/*! Approximate loading of the tasks file: the statistics of each stage are
+    computed on a uniform sample of its tasks, either a Bernoulli sample
+    (`sampling_rate`) or a fixed-size reservoir (`reservoir_size`). The
+    rows which are not sampled are not parsed.
+    The default options read all the tasks.
+ */
+struct TasksSamplingOptions {
+  //! Probability to keep each task (1 keeps all the tasks)
+  double sampling_rate = 1.0;
+
+  //! If not 0, keep this number of tasks per stage, chosen uniformly (the
+  //! sampling rate must be 1)
+  std::size_t reservoir_size = 0;
+
+  //! A stage whose Bernoulli sample is smaller takes a uniform sample of
+  //! this size instead (at least 2 tasks are needed to estimate the
+  //! variance)
+  std::size_t min_tasks_per_stage = 2;
+
+  //! Quantile of the normal distribution for the confidence intervals
+  double confidence_z = 1.96;  // 95%
+
+  std::uint64_t seed = 0;
+
+  bool is_sampling() const noexcept {
+    return sampling_rate < 1.0 || reservoir_size != 0;
+  }
+};
+
 class Application {
  public:
   using ApplicationID = std::string;
+  using JobsMap = std::pmr::map<Job::JobID, Job>;
+  using StagesMap = std::pmr::map<Stage::StageID, Stage>;
 
   //! Only file name without absolute path
   struct FileResources {
@@ -43,7 +83,140 @@ class Application {
     std::string m_Infrastructure_File;
   };
 
-  Application() = default;
+  //! Bytes of the trace files read so far
+  struct TraceOffsets {
+    std::uint64_t m_Jobs_File = 0;
+    std::uint64_t m_Stages_File = 0;
+    std::uint64_t m_Tasks_File = 0;
+  };
+
+  /*! The data loaded from the trace of an application.
+      The copies of an application share their trace, and a trace is never
+      modified while it is shared (see mutable_trace): it can be read from
+      any thread without locks, and copying an application is cheap.
+   */
+  class Trace {
+   public:
+    //! An empty trace (jobs and stages are allocated in bulk from an arena)
+    Trace();
+
+    //! Copy the trace into a new arena
+    Trace(const Trace& other);
+
+    // Not assignable: the maps would keep the arena of the assigned trace
+    // (the pmr allocators do not propagate), which can be released before
+    // them. An application is assigned by sharing its trace instead.
+    Trace& operator=(const Trace&) = delete;
+
+    // The arena must outlive (so be declared before) the containers using it
+    std::shared_ptr<std::pmr::memory_resource> m_arena;
+
+    ApplicationID m_app_id;
+    JobsMap m_jobs;
+    StagesMap m_stages;
+
+    TimeInstant m_real_execution_time;
+
+    std::string m_lua_filename;
+    std::string m_infrastructure_filename;
+
+    opt_common::InfrastructureConfiguration m_infr_config;
+    opt_common::MachineLearningModel m_mlm;
+
+    Configuration m_app_configuration;
+
+    FileResources m_files_resources;
+
+    TraceOffsets m_trace_offsets;
+
+    // Standard error (milliseconds) of the average task time of sampled
+    // stages
+    std::map<Stage::StageID, double> m_stages_avg_time_std_error;
+    double m_sampling_confidence_z = 0.0;
+
+   private:
+    friend class Application;
+    friend class SharedApplicationCache;
+    friend class SharedApplicationView;
+
+    /*! \return the arena of a new trace. Define
+        OPT_COMMON_WITHOUT_APPLICATION_ARENA to allocate jobs and stages
+        one by one on the heap instead (e.g. to measure the arena, see
+        benchmark/bench_arena_load.cpp)
+     */
+    static std::shared_ptr<std::pmr::memory_resource> make_arena();
+
+    //! A job whose row has not all the information yet
+    struct PartialJob {
+      bool has_submission_time = false;
+      bool has_completion_time = false;
+      TimeInstant submission_time;
+      TimeInstant completion_time;
+      std::vector<Stage::StageID> id_stages;
+    };
+
+    std::map<Job::JobID, PartialJob> m_partial_jobs;
+    std::map<Stage::StageID, std::vector<TimeInstant>> m_pending_tasks_times;
+
+    // Columns of the trace files, with their positions in the traces
+    // written without names (see CsvRowDecoder)
+    using JobsRowDecoder = CsvRowDecoder<Job::JobID, std::string_view,
+                                         std::string_view, std::string_view>;
+    static constexpr std::array<CsvColumn, 4> JOBS_COLUMNS{
+        {{"Job ID", 0},
+         {"Submission Time", 1},
+         {"Stage IDs", 2},
+         {"Completion Time", 3}}};
+
+    using StagesRowDecoder =
+        CsvRowDecoder<Stage::StageID, std::string_view, unsigned>;
+    static constexpr std::array<CsvColumn, 3> STAGES_COLUMNS{
+        {{"Stage ID", 0}, {"Parent IDs", 2}, {"Number of Tasks", 3}}};
+
+    using TasksRowDecoder =
+        CsvRowDecoder<unsigned long, unsigned long, Stage::StageID>;
+    static constexpr std::array<CsvColumn, 3> TASKS_COLUMNS{
+        {{"Launch Time", 4}, {"Finish Time", 5}, {"Stage ID", 16}}};
+
+    /*! Read the rows of a trace file from the byte `*offset` (see
+        for_each_csv_row_from_offset), moving `offset` after the last row.
+        The rows of the jobs and stages files have the size of the header.
+        \return the number of rows read (without the header)
+     */
+    std::size_t add_jobs_rows(const std::string& jobs_filename,
+                              std::uint64_t* offset, bool read_incomplete_row);
+    std::size_t add_stages_rows(const std::string& stages_filename,
+                                std::uint64_t* offset,
+                                bool read_incomplete_row);
+    std::size_t add_tasks_rows(const std::string& tasks_filename,
+                               std::uint64_t* offset,
+                               bool read_incomplete_row);
+
+    /*! Read the identifier and, once the application has completed, the
+        real execution time from the application file.
+        \return true if the application has completed
+     */
+    bool read_application_file(const std::string& application_filename);
+
+    //! \throw std::runtime_error if a stage has no task (for a completed
+    //! application)
+    void check_stages_have_tasks(const std::string& tasks_filename) const;
+
+    //! Parse a time (in milliseconds) of the jobs file
+    static void parse_job_time(std::string_view time_str,
+                               const std::string& jobs_filename,
+                               TimeInstant* time);
+
+    //! Read a sample of the tasks file (the stages must be already read)
+    void add_sampled_tasks_file(const std::string& tasks_filename,
+                                const TasksSamplingOptions& sampling);
+  };
+
+  //! An application with an empty trace
+  Application();
+
+  //! \return the trace of the application (not modified while it is held)
+  std::shared_ptr<const Trace> get_trace() const noexcept { return m_trace; }
 
   /*! Compute the approximate execution time instant.
    * This method uses the following formula:
@@ -55,7 +228,32 @@ class Application {
 
   TimeInstant compute_avg_execution_time(const std::size_t n) const noexcept;
 
+  struct TimeInterval {
+    TimeInstant lower;
+    TimeInstant estimate;
+    TimeInstant upper;
+  };
+
+  /*! Confidence interval of compute_avg_execution_time(n) for an application
+      loaded with sampled tasks (the stages are assumed independent).
+      For an application fully loaded the interval is a single point.
+   */
+  TimeInterval compute_avg_execution_time_interval(const std::size_t n) const;
+
+  //! Confidence interval of the average task time of a stage
+  TimeInterval get_stage_avg_time_interval(Stage::StageID stage_id) const;
+
+  //! \return true if the stages statistics are computed on sampled tasks
+  bool is_sampled() const noexcept {
+    return m_trace->m_sampling_confidence_z > 0;
+  }
+
   const TimeInstant& get_deadline() const noexcept { return m_deadline; }
+
+  //! \return the duration of the run in the trace (0 if still running)
+  const TimeInstant& get_real_execution_time() const noexcept {
+    return m_trace->m_real_execution_time;
+  }
   void set_deadline(const TimeInstant& deadline) noexcept {
     m_deadline = deadline;
   }
@@ -63,7 +261,9 @@ class Application {
   std::size_t compute_max_number_of_task() const noexcept;
 
   //! \return the absolute lua filename (with absolute path)
-  const std::string& get_lua_name() const noexcept { return m_lua_filename; }
+  const std::string& get_lua_name() const noexcept {
+    return m_trace->m_lua_filename;
+  }
 
   static Application create_application(const std::string& data_input_namefile,
                                         const std::string& config_namefile);
@@ -72,19 +272,37 @@ class Application {
                                         std::string config_namefile,
                                         std::string deadline_str);
 
+  /*! Same as above, but with a configuration already read.
+      The infrastructure configuration and the ML model read are written on
+      `log` (nothing is written if nullptr)
+   */
+  static Application create_application(
+      const std::string& data_input_namefile,
+      const Configuration& configuration,
+      const TasksSamplingOptions& sampling = TasksSamplingOptions(),
+      std::ostream* log = &std::cout);
+
+  static Application create_application(
+      FileResources resources_filename, const Configuration& configuration,
+      const std::string& deadline_str,
+      const TasksSamplingOptions& sampling = TasksSamplingOptions(),
+      std::ostream* log = &std::cout);
+
   void set_alpha_beta(unsigned int n1, unsigned int n2);
 
   double get_alpha() const noexcept { return m_alpha; }
   double get_beta() const noexcept { return m_beta; }
 
-  const auto& get_machine_learning_model() const noexcept { return m_mlm; }
+  const auto& get_machine_learning_model() const noexcept {
+    return m_trace->m_mlm;
+  }
 
   const auto& get_infrastructure_config() const noexcept {
-    return m_infr_config;
+    return m_trace->m_infr_config;
   }
 
   const auto& get_dagsim_path() const noexcept {
-    return m_app_configuration.get_dagsim_path();
+    return m_trace->m_app_configuration.get_dagsim_path();
   }
 
   unsigned int get_number_of_core() const noexcept { return m_number_of_cores; }
@@ -92,63 +310,214 @@ class Application {
     m_number_of_cores = num_cors;
   }
 
-  const std::map<Stage::StageID, Stage>& get_all_stages() const noexcept {
-    return m_stages;
+  const StagesMap& get_all_stages() const noexcept {
+    return m_trace->m_stages;
   }
 
+  const JobsMap& get_all_jobs() const noexcept { return m_trace->m_jobs; }
+
   void set_weight(double w) noexcept { m_weight = w; }
   double get_weight() const noexcept { return m_weight; }
 
-  const ApplicationID& get_application_id() const noexcept { return m_app_id; }
+  const ApplicationID& get_application_id() const noexcept {
+    return m_trace->m_app_id;
+  }
 
   //! \note FileResources have not absolute path
-  const FileResources& get_files_resources() const noexcept { return m_files_resources; }
+  const FileResources& get_files_resources() const noexcept {
+    return m_trace->m_files_resources;
+  }
+
+  const TraceOffsets& get_trace_offsets() const noexcept {
+    return m_trace->m_trace_offsets;
+  }
+
+  /*! Read the rows appended to the application, jobs, stages and tasks
+      files since the last reading (e.g. the logs of a running application)
+      and update the real execution time, the stages statistics and
+      alpha/beta in place.
+      The cost is proportional to the new rows only.
+      \return the number of rows read (0 if no row has been appended: the
+      statistics are not changed)
+      \throw std::runtime_error if the application has completed with a
+      stage without tasks
+      \note Not available for applications loaded with sampled tasks
+   */
+  std::size_t update_from_appended_rows();
 
  private:
-  ApplicationID m_app_id;
-  std::map<Job::JobID, Job> m_jobs;
-  std::map<Stage::StageID, Stage> m_stages;
+  friend class ApplicationHistory;
+  friend class SharedApplicationCache;
+  friend class SharedApplicationView;
+
+  /*! Set the files, the configuration and the deadline of the application.
+      \return the resources with the absolute paths
+   */
+  FileResources set_files_resources(FileResources resources_filename,
+                                    const Configuration& configuration,
+                                    const std::string& deadline_str);
+
+  //! \return the trace to modify, copied first if it is shared
+  //! (copy-on-write)
+  Trace& mutable_trace();
+
+  std::shared_ptr<Trace> m_trace;
 
-  TimeInstant m_submission_time = 0;
-  TimeInstant m_deadline = 0;
-  TimeInstant m_real_execution_time = 0;
+  // The state of this application on the trace
 
-  std::string m_lua_filename;
-  std::string m_infrastructure_filename;
+  TimeInstant m_submission_time;
+  TimeInstant m_deadline;
 
   double m_alpha = 0.0;
   double m_beta = 0.0;
 
+  // Number of cores alpha and beta have been fitted on (to refit them)
+  unsigned int m_alpha_beta_n1 = 0;
+  unsigned int m_alpha_beta_n2 = 0;
+
   double m_weight = 0.0;
 
   unsigned int m_number_of_cores = 0;
+};
 
-  opt_common::InfrastructureConfiguration m_infr_config;
-  opt_common::MachineLearningModel m_mlm;
+inline std::shared_ptr<std::pmr::memory_resource>
+Application::Trace::make_arena() {
+#ifdef OPT_COMMON_WITHOUT_APPLICATION_ARENA
+  return std::shared_ptr<std::pmr::memory_resource>(
+      std::pmr::new_delete_resource(), [](std::pmr::memory_resource*) {});
+#else
+  return std::make_shared<std::pmr::monotonic_buffer_resource>();
+#endif
+}
 
-  Configuration m_app_configuration;
+inline Application::Trace::Trace()
+    : m_arena(make_arena()),
+      m_jobs(m_arena.get()),
+      m_stages(m_arena.get()) {}
+
+inline Application::Trace::Trace(const Trace& other)
+    : m_arena(make_arena()),
+      m_app_id(other.m_app_id),
+      m_jobs(other.m_jobs, m_arena.get()),
+      m_stages(other.m_stages, m_arena.get()),
+      m_real_execution_time(other.m_real_execution_time),
+      m_lua_filename(other.m_lua_filename),
+      m_infrastructure_filename(other.m_infrastructure_filename),
+      m_infr_config(other.m_infr_config),
+      m_mlm(other.m_mlm),
+      m_app_configuration(other.m_app_configuration),
+      m_files_resources(other.m_files_resources),
+      m_trace_offsets(other.m_trace_offsets),
+      m_stages_avg_time_std_error(other.m_stages_avg_time_std_error),
+      m_sampling_confidence_z(other.m_sampling_confidence_z),
+      m_partial_jobs(other.m_partial_jobs),
+      m_pending_tasks_times(other.m_pending_tasks_times) {}
+
+inline Application::Application() : m_trace(std::make_shared<Trace>()) {}
+
+inline Application::Trace& Application::mutable_trace() {
+  // Another application (or a holder of get_trace) may be reading it
+  if (m_trace.use_count() != 1) {
+    m_trace = std::make_shared<Trace>(*m_trace);
+  }
+  return *m_trace;
+}
 
-  FileResources m_files_resources;
-};
+inline Application::FileResources Application::set_files_resources(
+    FileResources resources_filename, const Configuration& configuration,
+    const std::string& deadline_str) {
+  Trace& trace = mutable_trace();
+
+  // Set all filenames resouces
+  trace.m_files_resources = resources_filename;
+
+  // Set the configuration
+  trace.m_app_configuration = configuration;
+
+  // Add path to the file names
+  const std::string& data_path = trace.m_app_configuration.get_data_path();
+  resources_filename.m_Application_File =
+      data_path + "/" + resources_filename.m_Application_File;
+  resources_filename.m_Jobs_File =
+      data_path + "/" + resources_filename.m_Jobs_File;
+  resources_filename.m_Stages_File =
+      data_path + "/" + resources_filename.m_Stages_File;
+  resources_filename.m_Tasks_File =
+      data_path + "/" + resources_filename.m_Tasks_File;
+  resources_filename.m_Infrastructure_File =
+      data_path + "/" + resources_filename.m_Infrastructure_File;
+  resources_filename.m_Lua_File = trace.m_app_configuration.get_lua_path() +
+                                  "/" + resources_filename.m_Lua_File;
+
+  // Set some information in application
+  trace.m_lua_filename = resources_filename.m_Lua_File;
+  trace.m_infrastructure_filename = resources_filename.m_Infrastructure_File;
+  m_submission_time = TimeInstant();
+  m_deadline = TimeInstant::from_milliseconds(std::stoul(deadline_str));
+  m_number_of_cores = 1;
+
+  return resources_filename;
+}
 
 inline TimeInstant Application::compute_avg_execution_time(
     const std::size_t n) const noexcept {
-  TimeInstant time_execution = 0;
-  for (const auto& stage_pair : m_stages) {
+  TimeInstant time_execution;
+  for (const auto& stage_pair : m_trace->m_stages) {
     const Stage& stage = stage_pair.second;
     if (stage.get_number_of_tasks() % n != 0) {
       time_execution += stage.get_avg_time();
     }
 
-    const unsigned coeff = stage.get_number_of_tasks() / n;
+    const TimeInstant::Rep coeff = stage.get_number_of_tasks() / n;
     time_execution += coeff * stage.get_avg_time();
   }
   return time_execution;
 }
 
+inline Application::TimeInterval
+Application::compute_avg_execution_time_interval(const std::size_t n) const {
+  // Each stage contributes (number of waves * average time)
+  double variance = 0;
+  for (const auto& error_pair : m_trace->m_stages_avg_time_std_error) {
+    const auto stage_finder = m_trace->m_stages.find(error_pair.first);
+    if (stage_finder == m_trace->m_stages.cend()) {
+      continue;
+    }
+    const double waves =
+        (stage_finder->second.get_number_of_tasks() + n - 1) / n;
+    variance += waves * waves * error_pair.second * error_pair.second;
+  }
+
+  const TimeInstant estimate = compute_avg_execution_time(n);
+  const auto margin = TimeInstant::from_milliseconds(
+      m_trace->m_sampling_confidence_z * std::sqrt(variance));
+  return TimeInterval{std::max(estimate - margin, TimeInstant()), estimate,
+                      estimate + margin};
+}
+
+inline Application::TimeInterval Application::get_stage_avg_time_interval(
+    Stage::StageID stage_id) const {
+  const auto stage_finder = m_trace->m_stages.find(stage_id);
+  if (stage_finder == m_trace->m_stages.cend()) {
+    THROW_RUNTIME_ERROR("In application: unknown stage '" +
+                        std::to_string(stage_id) + "'");
+  }
+  const TimeInstant estimate = stage_finder->second.get_avg_time();
+
+  const auto error_finder = m_trace->m_stages_avg_time_std_error.find(stage_id);
+  if (error_finder == m_trace->m_stages_avg_time_std_error.cend()) {
+    return TimeInterval{estimate, estimate, estimate};
+  }
+
+  const auto margin = TimeInstant::from_milliseconds(
+      m_trace->m_sampling_confidence_z * error_finder->second);
+  return TimeInterval{std::max(estimate - margin, TimeInstant()), estimate,
+                      estimate + margin};
+}
+
 inline std::size_t Application::compute_max_number_of_task() const noexcept {
   std::size_t max = 0;
-  for (const auto& stage_pair : m_stages) {
+  for (const auto& stage_pair : m_trace->m_stages) {
     const Stage& stage = stage_pair.second;
     if (stage.get_number_of_tasks() > max) {
       max = stage.get_number_of_tasks();
@@ -162,190 +531,472 @@ inline void Application::set_alpha_beta(unsigned int n1, unsigned int n2) {
     THROW_RUNTIME_ERROR("In setting alpha beta for application: n1 == n2");
   }
 
-  TimeInstant r1 = this->compute_avg_execution_time(n1);
-  TimeInstant r2 = this->compute_avg_execution_time(n2);
+  m_alpha_beta_n1 = n1;
+  m_alpha_beta_n2 = n2;
+
+  // Alpha and beta are expressed in milliseconds
+  const double r1 = this->compute_avg_execution_time(n1).to_milliseconds();
+  const double r2 = this->compute_avg_execution_time(n2).to_milliseconds();
 
   if (n1 > n2) {
-    m_alpha = static_cast<double>(r2 - r1) * n1 * n2 / (n1 - n2);
-    m_beta = static_cast<double>(r1) - m_alpha / n1;
+    m_alpha = (r2 - r1) * n1 * n2 / (n1 - n2);
+    m_beta = r1 - m_alpha / n1;
   } else {
-    m_alpha = static_cast<double>(r1 - r2) * n1 * n2 / (n2 - n1);
-    m_beta = static_cast<double>(r1) - m_alpha / n1;
+    m_alpha = (r1 - r2) * n1 * n2 / (n2 - n1);
+    m_beta = r1 - m_alpha / n1;
   }
 }
 
-inline Application Application::create_application(
-    FileResources resources_filename, std::string config_namefile,
-    std::string deadline_str) {
+inline std::size_t Application::Trace::add_jobs_rows(
+    const std::string& jobs_filename, std::uint64_t* offset,
+    bool read_incomplete_row) {
   using namespace std::string_literals;
 
-  if (deadline_str.empty()) {
-    THROW_RUNTIME_ERROR("In creation application: some missing information");
+  JobsRowDecoder decoder(JOBS_COLUMNS, true);
+  Job::JobID job_id;
+  std::string_view submission_time_str, set_of_deps, completion_time_str;
+
+  const auto handle_row = [&](std::string_view line) {
+    if (decoder.decode(line, &job_id, &submission_time_str, &set_of_deps,
+                       &completion_time_str) == false) {
+      THROW_RUNTIME_ERROR("In creation application: file '"s + jobs_filename +
+                          "' " + decoder.get_error());
+    }
+    if (m_jobs.count(job_id) != 0) {
+      // The job is already complete: keep the first information
+      return;
+    }
+
+    // Merge the row with what has been read so far for the job
+    PartialJob& partial_job = m_partial_jobs[job_id];
+
+    // Get submission time
+    if (!partial_job.has_submission_time && submission_time_str != "NOVAL") {
+      parse_job_time(submission_time_str, jobs_filename,
+                     &partial_job.submission_time);
+      partial_job.has_submission_time = true;
+    }
+
+    // Get the completion time
+    if (!partial_job.has_completion_time && completion_time_str != "NOVAL") {
+      parse_job_time(completion_time_str, jobs_filename,
+                     &partial_job.completion_time);
+      partial_job.has_completion_time = true;
+    }
+
+    // Get the stage dependency of the job
+    if (partial_job.id_stages.empty() && set_of_deps != "NOVAL") {
+      if (parse_list_of_numbers(set_of_deps, &partial_job.id_stages) ==
+          false) {
+        THROW_RUNTIME_ERROR("In creation application: file '"s +
+                            jobs_filename +
+                            "' has an invalid list of stages '" +
+                            std::string(set_of_deps) + "'");
+      }
+    }
+
+    // Insert the job into the application once its times are known (the job
+    // is built in place, so it takes the application arena)
+    if (partial_job.has_submission_time && partial_job.has_completion_time) {
+      const auto job_inserted =
+          m_jobs.try_emplace(job_id, job_id, partial_job.submission_time,
+                             partial_job.completion_time);
+      job_inserted.first->second.set_id_stages(partial_job.id_stages);
+      m_partial_jobs.erase(job_id);
+    }
+  };
+
+  return for_each_csv_row_from_offset(jobs_filename, offset, &decoder,
+                                      handle_row, read_incomplete_row);
+}
+
+inline void Application::Trace::parse_job_time(
+    std::string_view time_str, const std::string& jobs_filename,
+    TimeInstant* time) {
+  using namespace std::string_literals;
+
+  unsigned long time_ms;
+  if (parse_number(time_str, &time_ms) == false) {
+    THROW_RUNTIME_ERROR("In creation application: file '"s + jobs_filename +
+                        "' has an invalid time '" + std::string(time_str) +
+                        "'");
   }
+  *time = TimeInstant::from_milliseconds(time_ms);
+}
 
-  // Create empty application object
-  Application app;
+inline std::size_t Application::Trace::add_stages_rows(
+    const std::string& stages_filename, std::uint64_t* offset,
+    bool read_incomplete_row) {
+  using namespace std::string_literals;
 
-  // Set all filenames resouces
-  app.m_files_resources = resources_filename;
+  StagesRowDecoder decoder(STAGES_COLUMNS, true);
+  Stage::StageID stage_id;
+  std::string_view parents_str;
+  unsigned number_of_tasks;
 
-  // Read the configuration file
-  app.m_app_configuration.read_configuration_from_file(config_namefile);
+  // Buffer reused to parse the dependencies of each stage
+  std::vector<Stage::StageID> parentIDs;
 
-  // Add path to the file names
-  resources_filename.m_Application_File =
-      app.m_app_configuration.get_data_path() + "/" +
-      resources_filename.m_Application_File;
-  resources_filename.m_Jobs_File = app.m_app_configuration.get_data_path() +
-                                   "/" + resources_filename.m_Jobs_File;
-  resources_filename.m_Stages_File = app.m_app_configuration.get_data_path() +
-                                     "/" + resources_filename.m_Stages_File;
-  resources_filename.m_Tasks_File = app.m_app_configuration.get_data_path() +
-                                    "/" + resources_filename.m_Tasks_File;
-  resources_filename.m_Infrastructure_File =
-      app.m_app_configuration.get_data_path() + "/" +
-      resources_filename.m_Infrastructure_File;
-  resources_filename.m_Lua_File = app.m_app_configuration.get_lua_path() + "/" +
-                                  resources_filename.m_Lua_File;
+  const auto handle_row = [&](std::string_view line) {
+    if (decoder.decode(line, &stage_id, &parents_str, &number_of_tasks) ==
+        false) {
+      THROW_RUNTIME_ERROR("In creation application: file '"s +
+                          stages_filename + "' " + decoder.get_error());
+    }
 
-  // Set some information in application
-  app.m_lua_filename = resources_filename.m_Lua_File;
-  app.m_infrastructure_filename = resources_filename.m_Infrastructure_File;
-  app.m_submission_time = 0;
-  app.m_deadline = std::stoul(deadline_str);
-  app.m_number_of_cores = 1;
+    // Create stage object (built in place, so it takes the application arena)
+    const auto stage_inserted =
+        m_stages.try_emplace(stage_id, stage_id, number_of_tasks);
+    if (stage_inserted.second == false) {
+      // Duplicated stage: keep the first one
+      return;
+    }
+    Stage& stage = stage_inserted.first->second;
 
-  CSV_Data csv_data;
+    // Parse stage dependencies
+    parentIDs.clear();
+    if (parse_list_of_numbers(parents_str, &parentIDs) == false) {
+      THROW_RUNTIME_ERROR("In creation application: file '"s +
+                          stages_filename +
+                          "' has an invalid list of parents '" +
+                          std::string(parents_str) + "'");
+    }
+    stage.set_dependencies(parentIDs);
+
+    // Tasks read before their stage
+    const auto pending_finder = m_pending_tasks_times.find(stage_id);
+    if (pending_finder != m_pending_tasks_times.end()) {
+      const auto& tasks_times = pending_finder->second;
+      stage.add_tasks_times(tasks_times.data(), tasks_times.size());
+      m_pending_tasks_times.erase(pending_finder);
+    }
+  };
 
-  // Read the app csv
-  read_csv_file(resources_filename.m_Application_File, &csv_data);
+  return for_each_csv_row_from_offset(stages_filename, offset, &decoder,
+                                      handle_row, read_incomplete_row);
+}
 
-  // Set the application id
-  app.m_app_id = csv_data.at(1).at(0);
+inline std::size_t Application::Trace::add_tasks_rows(
+    const std::string& tasks_filename, std::uint64_t* offset,
+    bool read_incomplete_row) {
+  using namespace std::string_literals;
 
-  // Get the duration of application as time difference
-  const auto app_time_start = std::stoul(csv_data.at(1).at(1));
-  const auto app_time_stop = std::stoul(csv_data.at(2).at(1));
-  app.m_real_execution_time = app_time_stop - app_time_start;
+  // Temporary data structures are released in bulk at the end
+  std::pmr::monotonic_buffer_resource scratch;
 
-  // Read the jobs file
-  read_csv_file(resources_filename.m_Jobs_File, &csv_data);
+  // Map a ID stage with a execution times of stage2tasks
+  std::pmr::map<Stage::StageID, std::pmr::vector<TimeInstant>> stage2tasks(
+      &scratch);
 
-  // For each line in csv parse it
-  std::map<Job::JobID, TimeInstant> job2submission_time, job2completion_time;
+  TasksRowDecoder decoder(TASKS_COLUMNS);
+  unsigned long launch_time, finish_time;
+  Stage::StageID id_stage;
 
-  // Map each job id with a vector of stages IDs
-  std::map<Job::JobID, std::set<Stage::StageID>> id_stages;
+  const auto handle_row = [&](std::string_view line) {
+    if (decoder.decode(line, &launch_time, &finish_time, &id_stage) ==
+        false) {
+      THROW_RUNTIME_ERROR("In creation application: file '"s +
+                          tasks_filename + "' " + decoder.get_error());
+    }
+    const auto execution_time = TimeInstant::from_milliseconds(finish_time) -
+                                TimeInstant::from_milliseconds(launch_time);
+    stage2tasks[id_stage].push_back(execution_time);
+  };
+
+  const std::size_t n_rows = for_each_csv_row_from_offset(
+      tasks_filename, offset, &decoder, handle_row, read_incomplete_row);
+
+  // Update stages of application with the max min a avg task
+  for (const auto& stage_tasks : stage2tasks) {
+    const auto& stage_id = stage_tasks.first;
+    const auto& tasks_times = stage_tasks.second;
+
+    const auto stage_finder = m_stages.find(stage_id);
+    if (stage_finder != m_stages.end()) {
+      stage_finder->second.add_tasks_times(tasks_times.data(),
+                                           tasks_times.size());
+    } else {
+      // The row of the stage has not been read yet
+      auto& pending_times = m_pending_tasks_times[stage_id];
+      pending_times.insert(pending_times.end(), tasks_times.cbegin(),
+                           tasks_times.cend());
+    }
+  }
 
-  for (std::size_t row_index = 1; row_index < csv_data.size(); ++row_index) {
-    // Get the current row
-    const auto& row = csv_data.at(row_index);
-    const auto row_size = row.size();
-    if (row_size != 4) {
+  return n_rows;
+}
+
+inline bool Application::Trace::read_application_file(
+    const std::string& application_filename) {
+  CSV_Data csv_data;
+  read_csv_file(application_filename, &csv_data);
+
+  // Set the application id
+  m_app_id = csv_data.at(1).at(0);
+
+  // Get the duration of application as time difference (the stop time is
+  // not there yet if the application is still running)
+  const bool application_completed = csv_data.size() > 2;
+  if (application_completed) {
+    const auto app_time_start = std::stoul(csv_data.at(1).at(1));
+    const auto app_time_stop = std::stoul(csv_data.at(2).at(1));
+    m_real_execution_time = TimeInstant::from_milliseconds(app_time_stop) -
+                            TimeInstant::from_milliseconds(app_time_start);
+  }
+  return application_completed;
+}
+
+inline void Application::Trace::check_stages_have_tasks(
+    const std::string& tasks_filename) const {
+  using namespace std::string_literals;
+
+  for (const auto& stage_pair : m_stages) {
+    if (stage_pair.second.get_number_of_tasks_times() == 0) {
       THROW_RUNTIME_ERROR("In creation application: file '"s +
-                          resources_filename.m_Jobs_File +
-                          "' has different number of cols");
+                          tasks_filename + "' has no tasks of stage '" +
+                          std::to_string(stage_pair.first) + "'");
     }
+  }
+}
 
-    // Get the job id
-    const Job::JobID job_id = std::stoi(row.at(0));
+inline void Application::Trace::add_sampled_tasks_file(
+    const std::string& tasks_filename, const TasksSamplingOptions& sampling) {
+  using namespace std::string_literals;
 
-    // Get submission time
-    const auto& submission_time_str = row.at(1);
-    if (submission_time_str != "NOVAL") {
-      const auto submission_time = std::stoul(submission_time_str);
-      job2submission_time.insert(std::make_pair(job_id, submission_time));
+  if (!(sampling.sampling_rate > 0 && sampling.sampling_rate <= 1) ||
+      (sampling.reservoir_size != 0 &&
+       (sampling.sampling_rate != 1 ||
+        sampling.reservoir_size < sampling.min_tasks_per_stage))) {
+    THROW_RUNTIME_ERROR("In creation application: invalid sampling options");
+  }
+
+  // Each stage keeps a reservoir (the sample of fixed size) and, if
+  // sampling by rate, the Bernoulli sample
+  const bool by_rate = sampling.reservoir_size == 0;
+  const std::size_t reservoir_capacity =
+      by_rate ? sampling.min_tasks_per_stage : sampling.reservoir_size;
+
+  struct StageSample {
+    std::uint64_t n_tasks = 0;  // Tasks of the stage in the file
+    std::vector<TimeInstant> reservoir;
+    std::vector<TimeInstant> bernoulli;
+  };
+  std::map<Stage::StageID, StageSample> samples;
+
+  std::mt19937_64 random_engine(sampling.seed);
+  std::bernoulli_distribution keep_task(sampling.sampling_rate);
+
+  // Only the columns of the kept tasks are decoded
+  TasksRowDecoder columns(TASKS_COLUMNS);
+  const std::size_t launch_time_index = 0, finish_time_index = 1,
+                    stage_id_index = 2;
+
+  bool header = true;
+  for_each_line(tasks_filename, [&](std::string_view line) {
+    if (header) {
+      if (columns.bind_header(line) == false) {
+        THROW_RUNTIME_ERROR("In creation application: file '"s +
+                            tasks_filename + "' " + columns.get_error());
+      }
+      header = false;
+      return;
+    }
+    if (trim_view(line, " \r").empty()) {
+      return;
     }
 
-    // Get the completion time (as last field in row)
-    const auto& completion_time_str = row.at(3);
-    if (completion_time_str != "NOVAL") {
-      const auto completion_time = std::stoul(completion_time_str);
-      job2completion_time.insert(std::make_pair(job_id, completion_time));
+    // Only the stage is needed to decide whether to keep the task
+    std::string_view field;
+    Stage::StageID id_stage;
+    if (get_csv_field(line, columns.get_column_index(stage_id_index),
+                      &field) == false ||
+        parse_number(field, &id_stage) == false) {
+      THROW_RUNTIME_ERROR("In creation application: file '"s +
+                          tasks_filename + "' has an invalid stage id '" +
+                          std::string(field) + "'");
     }
 
-    // Get the stage dependency of the job
-    const auto& set_of_deps = row.at(2);
-    if (set_of_deps != "NOVAL") {
-      std::set<Stage::StageID> stageIDs;
-      const auto numbers = parse_string_as_vector_of_numbers(set_of_deps);
-      for (const auto& num : numbers) {
-        stageIDs.insert(num);
+    StageSample& sample = samples[id_stage];
+    const std::uint64_t task_index = sample.n_tasks++;
+
+    // Reservoir sampling (algorithm R): the task takes a random slot of
+    // the reservoir with probability capacity / (task_index + 1)
+    std::size_t reservoir_position = std::string::npos;
+    if (task_index < reservoir_capacity) {
+      reservoir_position = task_index;
+    } else if (reservoir_capacity != 0) {
+      std::uniform_int_distribution<std::uint64_t> replace(0, task_index);
+      const auto candidate = replace(random_engine);
+      if (candidate < reservoir_capacity) {
+        reservoir_position = candidate;
       }
-      id_stages.insert(std::make_pair(job_id, std::move(stageIDs)));
     }
-  }  // for all row in jobs file
-
-  // Insert all jobs into the application object
-  for (const auto& it : job2submission_time) {
-    const auto& job_id = it.first;
-    Job job_temp(job_id,                                     // job id
-                 it.second,                                  // sub time
-                 job2completion_time.find(job_id)->second);  // completion time
-
-    job_temp.set_id_stages(id_stages.find(job_id)->second);
-
-    app.m_jobs.insert(std::make_pair(job_id, std::move(job_temp)));
-  }  // for all submission times
-
-  // ---------------
-  // Parse the stages file
-  read_csv_file(resources_filename.m_Stages_File, &csv_data);
-
-  // Fill the data structures of stages file (for each row in stages file)
-  for (unsigned row_index = 1; row_index < csv_data.size(); ++row_index) {
-    // Get the current row
-    const auto& row = csv_data.at(row_index);
-    const auto number_of_cols = row.size();
-    if (number_of_cols != 6) {
+    const bool bernoulli_kept = by_rate && keep_task(random_engine);
+    if (reservoir_position == std::string::npos && !bernoulli_kept) {
+      return;
+    }
+
+    unsigned long launch_time, finish_time;
+    if (get_csv_field(line, columns.get_column_index(launch_time_index),
+                      &field) == false ||
+        parse_number(field, &launch_time) == false ||
+        get_csv_field(line, columns.get_column_index(finish_time_index),
+                      &field) == false ||
+        parse_number(field, &finish_time) == false) {
       THROW_RUNTIME_ERROR("In creation application: file '"s +
-                          resources_filename.m_Stages_File +
-                          "' has different number of cols");
+                          tasks_filename + "' has an invalid task time");
     }
+    const auto execution_time = TimeInstant::from_milliseconds(finish_time) -
+                                TimeInstant::from_milliseconds(launch_time);
 
-    // Get the stage id at the current row
-    const Stage::StageID stage_id = std::stoi(row.at(0));
+    if (reservoir_position == sample.reservoir.size()) {
+      sample.reservoir.push_back(execution_time);
+    } else if (reservoir_position != std::string::npos) {
+      sample.reservoir[reservoir_position] = execution_time;
+    }
+    if (bernoulli_kept) {
+      sample.bernoulli.push_back(execution_time);
+    }
+  });
 
-    const unsigned number_of_tasks = std::stoi(row.at(3));
+  m_sampling_confidence_z = sampling.confidence_z;
 
-    // Create stage object
-    Stage stage_temp(stage_id, number_of_tasks);
+  for (const auto& stage_sample : samples) {
+    const auto& stage_id = stage_sample.first;
 
-    // Parse stage dependencies
-    std::set<Stage::StageID> parentIDs;
-    const auto& parents_str = row.at(2);
-    const auto numbers = parse_string_as_vector_of_numbers(parents_str);
-    for (const auto& num : numbers) {
-      parentIDs.insert(num);
+    // Either sample is a simple random sample of the tasks of the stage
+    // (the Bernoulli one given its size), chosen by size only
+    const auto& tasks_times =
+        by_rate && stage_sample.second.bernoulli.size() >=
+                       sampling.min_tasks_per_stage
+            ? stage_sample.second.bernoulli
+            : stage_sample.second.reservoir;
+
+    const auto stage_finder = m_stages.find(stage_id);
+    if (stage_finder == m_stages.end()) {
+      THROW_RUNTIME_ERROR("In creation application: file '"s +
+                          tasks_filename + "' has tasks of unknown stage '" +
+                          std::to_string(stage_id) + "'");
+    }
+    stage_finder->second.set_tasks_times(tasks_times);
+
+    // Standard error of the mean of a simple random sample without
+    // replacement: sqrt(s^2 / n * (1 - n / N))
+    const double n = tasks_times.size();
+    const double population = stage_sample.second.n_tasks;
+    double mean = 0, m2 = 0;
+    for (std::size_t i = 0; i < tasks_times.size(); ++i) {
+      const double time = tasks_times[i].to_milliseconds();
+      const double delta = time - mean;
+      mean += delta / (i + 1);
+      m2 += delta * (time - mean);
+    }
+    double std_error = 0;
+    if (n > 1 && population > n) {
+      std_error = std::sqrt(m2 / (n - 1) / n * (1 - n / population));
     }
-    stage_temp.set_dependencies(std::move(parentIDs));
-    app.m_stages.insert(std::make_pair(stage_id, std::move(stage_temp)));
-  }  // for each row in stages file
+    m_stages_avg_time_std_error[stage_id] = std_error;
+  }
+}
 
-  // Parse the tasks file
-  read_csv_file(resources_filename.m_Tasks_File, &csv_data);
+inline std::size_t Application::update_from_appended_rows() {
+  if (is_sampled()) {
+    THROW_RUNTIME_ERROR(
+        "In update application: the application has sampled tasks");
+  }
 
-  // Map a ID stage with a execution times of stage2tasks
-  std::map<Stage::StageID, std::vector<TimeInstant>> stage2tasks;
-
-  // Fill the data structures of task file (for each row in task file)
-  for (unsigned row_index = 1; row_index < csv_data.size(); ++row_index) {
-    // Get the current row
-    const auto& row = csv_data.at(row_index);
-
-    // Get task information
-    const unsigned long launch_time = std::stoul(row.at(4));
-    const unsigned long finish_time = std::stoul(row.at(5));
-    const Stage::StageID id_stage = std::stoi(row.at(16));
-    const auto execution_time = finish_time - launch_time;
-    stage2tasks[id_stage].push_back(execution_time);
+  // The other applications sharing the trace keep the rows read so far
+  Trace& trace = mutable_trace();
+
+  const auto& data_path = trace.m_app_configuration.get_data_path();
+  const FileResources& files = trace.m_files_resources;
+  TraceOffsets& offsets = trace.m_trace_offsets;
+  std::size_t n_rows = 0;
+
+  // The stop time is appended when the application completes (then the
+  // last rows of the other files are complete too)
+  bool application_completed = trace.m_real_execution_time > TimeInstant();
+  if (!application_completed) {
+    application_completed = trace.read_application_file(
+        data_path + "/" + files.m_Application_File);
+    n_rows += application_completed ? 1 : 0;
   }
 
-  // Update stages of application with the max min a avg task
-  for (auto& stage_pair : app.m_stages) {
-    const auto& stage_id = stage_pair.first;
-    auto& stage = stage_pair.second;
-    stage.set_tasks_times(stage2tasks.at(stage_id));
+  n_rows += trace.add_jobs_rows(data_path + "/" + files.m_Jobs_File,
+                                &offsets.m_Jobs_File, application_completed);
+  n_rows += trace.add_stages_rows(data_path + "/" + files.m_Stages_File,
+                                  &offsets.m_Stages_File,
+                                  application_completed);
+  n_rows += trace.add_tasks_rows(data_path + "/" + files.m_Tasks_File,
+                                 &offsets.m_Tasks_File, application_completed);
+  if (application_completed) {
+    trace.check_stages_have_tasks(data_path + "/" + files.m_Tasks_File);
+  }
+
+  // Refit alpha and beta on the new statistics
+  if (n_rows > 0 && m_alpha_beta_n1 != m_alpha_beta_n2) {
+    set_alpha_beta(m_alpha_beta_n1, m_alpha_beta_n2);
+  }
+
+  return n_rows;
+}
+
+inline Application Application::create_application(
+    FileResources resources_filename, std::string config_namefile,
+    std::string deadline_str) {
+  if (deadline_str.empty()) {
+    THROW_RUNTIME_ERROR("In creation application: some missing information");
+  }
+
+  // Read the configuration file
+  Configuration configuration;
+  configuration.read_configuration_from_file(config_namefile);
+
+  return create_application(std::move(resources_filename), configuration,
+                            deadline_str);
+}
+
+inline Application Application::create_application(
+    FileResources resources_filename, const Configuration& configuration,
+    const std::string& deadline_str, const TasksSamplingOptions& sampling,
+    std::ostream* log) {
+  using namespace std::string_literals;
+
+  if (deadline_str.empty()) {
+    THROW_RUNTIME_ERROR("In creation application: some missing information");
+  }
+
+  // Create empty application object (owning the trace until it is copied)
+  Application app;
+  resources_filename = app.set_files_resources(std::move(resources_filename),
+                                               configuration, deadline_str);
+  Trace& trace = app.mutable_trace();
+
+  // Read the app csv
+  const bool application_completed =
+      trace.read_application_file(resources_filename.m_Application_File);
+
+  // Read the jobs, stages and tasks files (in this order: tasks update the
+  // stages). While the application runs the last row of a file can still be
+  // being written: it is left to update_from_appended_rows
+  trace.add_jobs_rows(resources_filename.m_Jobs_File,
+                      &trace.m_trace_offsets.m_Jobs_File,
+                      application_completed);
+  trace.add_stages_rows(resources_filename.m_Stages_File,
+                        &trace.m_trace_offsets.m_Stages_File,
+                        application_completed);
+
+  if (sampling.is_sampling()) {
+    trace.add_sampled_tasks_file(resources_filename.m_Tasks_File, sampling);
+  } else {
+    trace.add_tasks_rows(resources_filename.m_Tasks_File,
+                         &trace.m_trace_offsets.m_Tasks_File,
+                         application_completed);
+
+    // Every stage of a completed application has run its tasks
+    if (application_completed) {
+      trace.check_stages_have_tasks(resources_filename.m_Tasks_File);
+    }
   }
 
   // Read the configuration file
@@ -368,12 +1019,14 @@ inline Application Application::create_application(
   iss_config >> app_id >> chi_0 >> chi_c >> container_memory >>
       executor_memory >> container_cores >> executor_cores;
 
-  // Print on the standard output
-  std::cout << '\n' << " Optimizing configuration" << std::endl;
-  std::cout << app_id << " "
-            << " " << chi_0 << " " << chi_c << " " << container_memory << " "
-            << executor_memory << " " << container_cores << " "
-            << executor_cores;
+  // Print on the log (the standard output by default)
+  if (log != nullptr) {
+    *log << '\n' << " Optimizing configuration" << std::endl;
+    *log << app_id << " "
+         << " " << chi_0 << " " << chi_c << " " << container_memory << " "
+         << executor_memory << " " << container_cores << " "
+         << executor_cores;
+  }
 
   InfrastructureConfiguration ic(
       std::stof(container_memory), std::stof(executor_memory),
@@ -382,10 +1035,12 @@ inline Application Application::create_application(
   MachineLearningModel mlm(std::stof(chi_0), std::stof(chi_c));
 
   // Set infrastructure configuraiton and ML into the application object
-  app.m_infr_config = ic;
-  app.m_mlm = mlm;
+  trace.m_infr_config = ic;
+  trace.m_mlm = mlm;
 
-  app.m_mlm.print_dump_on_stream(&std::cout);
+  if (log != nullptr) {
+    trace.m_mlm.print_dump_on_stream(log);
+  }
 
   return app;
 }
@@ -393,6 +1048,16 @@ inline Application Application::create_application(
 inline Application Application::create_application(
     const std::string& data_input_namefile,
     const std::string& config_namefile) {
+  // Read the configuration file
+  Configuration configuration;
+  configuration.read_configuration_from_file(config_namefile);
+
+  return create_application(data_input_namefile, configuration);
+}
+
+inline Application Application::create_application(
+    const std::string& data_input_namefile, const Configuration& configuration,
+    const TasksSamplingOptions& sampling, std::ostream* log) {
   using namespace std::string_literals;
   // Read the input file
   std::ifstream ifs(data_input_namefile);
@@ -417,7 +1082,8 @@ inline Application Application::create_application(
   iss >> resources_filename.m_Infrastructure_File;
   iss >> deadline_str;
 
-  return create_application(resources_filename, config_namefile, deadline_str);
+  return create_application(std::move(resources_filename), configuration,
+                            deadline_str, sampling, log);
 }
 
 }  // namespace opt_common
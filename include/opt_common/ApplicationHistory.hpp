@@ -0,0 +1,467 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__APPLICATION_HISTORY__HPP
+#define __OPT_COMMON__APPLICATION_HISTORY__HPP
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <opt_common/Application.hpp>
+#include <opt_common/helper.hpp>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace opt_common {
+
+/*! Statistics of the runs of the applications, merged run by run.
+    The index is persisted in an append-only file: adding a run appends the
+    per-stage statistics of the run, and opening the index replays them (no
+    trace is parsed again). Queries cost O(stages).
+    File format (one record per line, the run record commits the stage
+    records written just before it):
+      S,RUN_ID,APPLICATION_ID,STAGE_ID,N_TASKS,COUNT,SUM,SUM_SQUARES,MIN,MAX,
+        CHECKSUM
+      R,RUN_ID,APPLICATION_ID,REAL_EXECUTION_TIME,N_STAGE_RECORDS,CHECKSUM
+    Times are in microseconds. CHECKSUM is the FNV-1a hash (8 hexadecimal
+    digits) of the record before it. A record which is not terminated or
+    whose checksum does not match has been torn by an interrupted append:
+    it is skipped with the uncommitted records of its run. The file is
+    never truncated, so another process can be appending to it.
+ */
+class ApplicationHistory {
+ public:
+  struct StageProfile {
+    Stage::StageID stage_id;
+    unsigned number_of_tasks;  // In the most recent run
+    std::size_t number_of_runs;
+    std::uint64_t number_of_tasks_times;  // Rounded if recency-weighted
+    TimeInstant min_time;
+    TimeInstant avg_time;
+    TimeInstant max_time;
+    TimeInstant std_deviation;
+    double sum_of_squares;  // Microseconds squared, of the tasks times
+  };
+
+  struct ApplicationProfile {
+    std::size_t number_of_runs;
+    TimeInstant avg_real_execution_time;
+    std::vector<StageProfile> stages;  // Sorted by stage ID
+  };
+
+  /*! Open (or create) the index in `index_filename`.
+      `decay` in (0, 1] is the weight of a run relative to the next run of the
+      same application in the recency-weighted profiles.
+   */
+  explicit ApplicationHistory(std::string index_filename, double decay = 0.9);
+
+  /*! Merge a completed run of an application and append it to the file.
+      \return false if the run `run_id` of the application is already in
+      \throw std::runtime_error if the application is still running
+   */
+  bool add_run(const Application& app, const std::string& run_id);
+
+  bool has_application(const Application::ApplicationID& app_id) const {
+    return m_applications.count(app_id) != 0;
+  }
+
+  /*! \return the profile aggregated on all the runs or, if
+      `recency_weighted`, with each run weighted by decay^(newer runs): the
+      number of tasks times, the average and the sum of squares are all
+      weighted (the sum of squares is scaled to the rounded number)
+   */
+  ApplicationProfile get_profile(const Application::ApplicationID& app_id,
+                                 bool recency_weighted = false) const;
+
+  /*! Replace the statistics of the stages of `app` with its profile, so
+      the estimates are based on all the runs.
+      \return the number of stages updated
+   */
+  std::size_t apply_profile(Application* app,
+                            bool recency_weighted = false) const;
+
+ private:
+  // Sums are kept in floating point to merge long histories
+  struct StageAggregate {
+    unsigned number_of_tasks = 0;
+    std::size_t number_of_runs = 0;
+    std::size_t last_run = 0;  // Index of the last run of the application
+    std::uint64_t count = 0;
+    long double sum = 0;
+    long double sum_of_squares = 0;
+    TimeInstant min_time;
+    TimeInstant max_time;
+
+    // Recency-weighted sums, decayed up to `last_run`
+    long double weighted_count = 0;
+    long double weighted_sum = 0;
+    long double weighted_sum_of_squares = 0;
+  };
+
+  struct ApplicationAggregate {
+    std::set<std::string> run_ids;
+    long double sum_real_execution_time = 0;
+    long double weighted_runs = 0;
+    long double weighted_real_execution_time = 0;
+    std::map<Stage::StageID, StageAggregate> stages;
+  };
+
+  struct StageRun {
+    Stage::StageID stage_id;
+    unsigned number_of_tasks;
+    std::uint64_t count;
+    std::int64_t sum;
+    double sum_of_squares;
+    std::int64_t min_time;
+    std::int64_t max_time;
+  };
+
+  std::string m_index_filename;
+  double m_decay;
+  std::map<Application::ApplicationID, ApplicationAggregate> m_applications;
+
+  void merge_run(const Application::ApplicationID& app_id,
+                 const std::string& run_id,
+                 std::int64_t real_execution_time,
+                 const std::vector<StageRun>& stages);
+
+  void replay_index();
+
+  //! \return `record` with its checksum and the end of line
+  static std::string seal_record(const std::string& record);
+
+  //! \return true if `line` is a record with a valid checksum, whose
+  //! content is set in `record`
+  static bool unseal_record(std::string_view line, std::string* record);
+};
+
+inline ApplicationHistory::ApplicationHistory(std::string index_filename,
+                                              double decay)
+    : m_index_filename(std::move(index_filename)), m_decay(decay) {
+  if (!(decay > 0 && decay <= 1)) {
+    THROW_RUNTIME_ERROR("In application history: the decay must be in (0, 1]");
+  }
+  replay_index();
+}
+
+inline void ApplicationHistory::merge_run(
+    const Application::ApplicationID& app_id, const std::string& run_id,
+    std::int64_t real_execution_time, const std::vector<StageRun>& stages) {
+  ApplicationAggregate& application = m_applications[app_id];
+  if (application.run_ids.insert(run_id).second == false) {
+    return;
+  }
+  const std::size_t run_index = application.run_ids.size();
+
+  application.sum_real_execution_time += real_execution_time;
+  application.weighted_runs = application.weighted_runs * m_decay + 1;
+  application.weighted_real_execution_time =
+      application.weighted_real_execution_time * m_decay + real_execution_time;
+
+  for (const auto& stage_run : stages) {
+    StageAggregate& stage = application.stages[stage_run.stage_id];
+    const auto min_time = TimeInstant::from_microseconds(stage_run.min_time);
+    const auto max_time = TimeInstant::from_microseconds(stage_run.max_time);
+
+    if (stage.count == 0) {
+      stage.min_time = min_time;
+      stage.max_time = max_time;
+    } else {
+      stage.min_time = std::min(stage.min_time, min_time);
+      stage.max_time = std::max(stage.max_time, max_time);
+    }
+    stage.number_of_tasks = stage_run.number_of_tasks;
+    ++stage.number_of_runs;
+    stage.count += stage_run.count;
+    stage.sum += stage_run.sum;
+    stage.sum_of_squares += stage_run.sum_of_squares;
+
+    // Decay the runs the stage was missing from, then add this one
+    const long double decay = std::pow(
+        static_cast<long double>(m_decay), run_index - stage.last_run);
+    stage.weighted_count = stage.weighted_count * decay + stage_run.count;
+    stage.weighted_sum = stage.weighted_sum * decay + stage_run.sum;
+    stage.weighted_sum_of_squares =
+        stage.weighted_sum_of_squares * decay + stage_run.sum_of_squares;
+    stage.last_run = run_index;
+  }
+}
+
+inline std::string ApplicationHistory::seal_record(const std::string& record) {
+  // FNV-1a
+  std::uint32_t hash = 0x811c9dc5u;
+  for (const char c : record) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 0x01000193u;
+  }
+
+  static constexpr char hex_digits[] = "0123456789abcdef";
+  std::string sealed = record + ',';
+  for (int shift = 28; shift >= 0; shift -= 4) {
+    sealed += hex_digits[(hash >> shift) & 0xF];
+  }
+  return sealed + '\n';
+}
+
+inline bool ApplicationHistory::unseal_record(std::string_view line,
+                                              std::string* record) {
+  const auto index_sep = line.rfind(',');
+  if (index_sep == std::string_view::npos) {
+    return false;
+  }
+  *record = std::string(line.substr(0, index_sep));
+  return seal_record(*record) == std::string(line) + '\n';
+}
+
+inline void ApplicationHistory::replay_index() {
+  using namespace std::string_literals;
+
+  std::ifstream file(m_index_filename, std::ios::binary);
+  if (file.fail()) {
+    // A new index
+    return;
+  }
+  const std::string content((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+  file.close();
+
+  // The stage records of the run being read (a run is appended at once)
+  std::pair<std::string, std::string> pending_key;
+  std::vector<StageRun> pending_stages;
+
+  std::size_t line_begin = 0;
+  std::size_t line_number = 0;
+  std::string record_str;
+  for (std::size_t line_end;
+       (line_end = content.find('\n', line_begin)) != std::string::npos;
+       line_begin = line_end + 1) {
+    ++line_number;
+    const std::string_view line(content.data() + line_begin,
+                                line_end - line_begin);
+    if (unseal_record(line, &record_str) == false) {
+      // Torn by an interrupted append: its run is not committed
+      pending_key = {};
+      pending_stages.clear();
+      continue;
+    }
+
+    const CSV_Line record = parse_csv_line(record_str);
+    bool valid = false;
+    if (record.at(0) == "S" && record.size() == 10) {
+      StageRun stage_run;
+      valid = parse_number(record[3], &stage_run.stage_id) &&
+              parse_number(record[4], &stage_run.number_of_tasks) &&
+              parse_number(record[5], &stage_run.count) &&
+              parse_number(record[6], &stage_run.sum) &&
+              parse_number(record[7], &stage_run.sum_of_squares) &&
+              parse_number(record[8], &stage_run.min_time) &&
+              parse_number(record[9], &stage_run.max_time);
+      if (valid) {
+        auto key = std::make_pair(record[1], record[2]);
+        if (key != pending_key) {
+          pending_key = std::move(key);
+          pending_stages.clear();
+        }
+        pending_stages.push_back(stage_run);
+      }
+    } else if (record.at(0) == "R" && record.size() == 5) {
+      std::int64_t real_execution_time;
+      std::size_t number_of_stages;
+      valid = parse_number(record[3], &real_execution_time) &&
+              parse_number(record[4], &number_of_stages);
+      if (valid) {
+        // Committed with the stage records just before it (those of an
+        // interrupted append of the same run can precede them)
+        if (pending_key != std::make_pair(record[1], record[2])) {
+          pending_stages.clear();
+        }
+        if (pending_stages.size() >= number_of_stages) {
+          pending_stages.erase(pending_stages.begin(),
+                               pending_stages.end() - number_of_stages);
+          merge_run(record[2], record[1], real_execution_time,
+                    pending_stages);
+        }
+        pending_key = {};
+        pending_stages.clear();
+      }
+    }
+
+    if (!valid) {
+      THROW_RUNTIME_ERROR("In application history: file '"s +
+                          m_index_filename +
+                          "' has an invalid record at line " +
+                          std::to_string(line_number));
+    }
+  }
+}
+
+inline bool ApplicationHistory::add_run(const Application& app,
+                                        const std::string& run_id) {
+  using namespace std::string_literals;
+
+  const auto& app_id = app.get_application_id();
+  for (const auto* id : {&app_id, &run_id}) {
+    if (id->empty() || id->find_first_of(",\"\r\n") != std::string::npos) {
+      THROW_RUNTIME_ERROR("In application history: invalid identifier '"s +
+                          *id + "'");
+    }
+  }
+  if (app.get_real_execution_time() <= TimeInstant()) {
+    THROW_RUNTIME_ERROR("In application history: application '"s + app_id +
+                        "' is still running");
+  }
+
+  const auto finder = m_applications.find(app_id);
+  if (finder != m_applications.cend() && finder->second.run_ids.count(run_id)) {
+    return false;
+  }
+
+  std::vector<StageRun> stages;
+  std::string records;
+  for (const auto& stage_pair : app.get_all_stages()) {
+    const Stage& stage = stage_pair.second;
+    if (stage.get_number_of_tasks_times() == 0) {
+      continue;
+    }
+
+    stages.push_back(StageRun{stage.get_stageID(), stage.get_number_of_tasks(),
+                              stage.get_number_of_tasks_times(),
+                              stage.get_tasks_times_sum().count_microseconds(),
+                              stage.get_tasks_times_sum_of_squares(),
+                              stage.get_min_time().count_microseconds(),
+                              stage.get_max_time().count_microseconds()});
+    const StageRun& stage_run = stages.back();
+    std::ostringstream record;
+    record.precision(17);
+    record << "S," << run_id << ',' << app_id << ',' << stage_run.stage_id
+           << ',' << stage_run.number_of_tasks << ',' << stage_run.count << ','
+           << stage_run.sum << ',' << stage_run.sum_of_squares << ','
+           << stage_run.min_time << ',' << stage_run.max_time;
+    records += seal_record(record.str());
+  }
+  const std::int64_t real_execution_time =
+      app.get_real_execution_time().count_microseconds();
+  records += seal_record("R,"s + run_id + ',' + app_id + ',' +
+                         std::to_string(real_execution_time) + ',' +
+                         std::to_string(stages.size()));
+
+  // A torn record (e.g. written by another process) must not be continued
+  {
+    std::ifstream last_char(m_index_filename, std::ios::binary);
+    if (last_char.seekg(-1, std::ios::end) && last_char.get() != '\n') {
+      records.insert(records.begin(), '\n');
+    }
+  }
+
+  // Append the whole run at once
+  std::ofstream file(m_index_filename, std::ios::app | std::ios::binary);
+  file << records << std::flush;
+  if (file.fail()) {
+    THROW_RUNTIME_ERROR("In application history: cannot append to file '"s +
+                        m_index_filename + "'");
+  }
+
+  merge_run(app_id, run_id, real_execution_time, stages);
+  return true;
+}
+
+inline ApplicationHistory::ApplicationProfile ApplicationHistory::get_profile(
+    const Application::ApplicationID& app_id, bool recency_weighted) const {
+  const auto finder = m_applications.find(app_id);
+  if (finder == m_applications.cend()) {
+    THROW_RUNTIME_ERROR("In application history: unknown application '" +
+                        app_id + "'");
+  }
+  const ApplicationAggregate& application = finder->second;
+
+  const auto to_time = [](long double microseconds) {
+    return TimeInstant::from_microseconds(
+        static_cast<TimeInstant::Rep>(std::llround(microseconds)));
+  };
+
+  ApplicationProfile profile;
+  profile.number_of_runs = application.run_ids.size();
+  profile.avg_real_execution_time =
+      recency_weighted ? to_time(application.weighted_real_execution_time /
+                                 application.weighted_runs)
+                       : to_time(application.sum_real_execution_time /
+                                 profile.number_of_runs);
+
+  profile.stages.reserve(application.stages.size());
+  for (const auto& stage_pair : application.stages) {
+    const StageAggregate& stage = stage_pair.second;
+
+    const long double count =
+        recency_weighted ? stage.weighted_count : stage.count;
+    const long double mean =
+        (recency_weighted ? stage.weighted_sum : stage.sum) / count;
+    const long double mean_of_squares =
+        (recency_weighted ? stage.weighted_sum_of_squares
+                          : stage.sum_of_squares) /
+        count;
+    const long double variance =
+        std::max(mean_of_squares - mean * mean, 0.0L);
+
+    // The weighted count is fractional: the sum of squares follows its
+    // rounding, so the three give back the weighted mean and variance
+    const std::uint64_t number_of_tasks_times =
+        recency_weighted
+            ? std::max<std::uint64_t>(std::llround(stage.weighted_count), 1)
+            : stage.count;
+
+    profile.stages.push_back(StageProfile{
+        stage_pair.first, stage.number_of_tasks, stage.number_of_runs,
+        number_of_tasks_times, stage.min_time, to_time(mean), stage.max_time,
+        to_time(std::sqrt(variance)),
+        static_cast<double>(mean_of_squares * number_of_tasks_times)});
+  }
+
+  return profile;
+}
+
+inline std::size_t ApplicationHistory::apply_profile(
+    Application* app, bool recency_weighted) const {
+  if (!has_application(app->get_application_id())) {
+    return 0;
+  }
+  const ApplicationProfile profile =
+      get_profile(app->get_application_id(), recency_weighted);
+
+  // The copies of the application sharing the trace keep their statistics
+  Application::StagesMap& stages = app->mutable_trace().m_stages;
+
+  std::size_t n_updated = 0;
+  for (const auto& stage_profile : profile.stages) {
+    const auto stage_finder = stages.find(stage_profile.stage_id);
+    if (stage_finder == stages.end()) {
+      continue;
+    }
+    stage_finder->second.set_tasks_statistics(
+        stage_profile.min_time, stage_profile.avg_time, stage_profile.max_time,
+        stage_profile.number_of_tasks_times, stage_profile.sum_of_squares);
+    ++n_updated;
+  }
+  return n_updated;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__APPLICATION_HISTORY__HPP
@@ -0,0 +1,264 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__BATCH_OPTIMIZER__HPP
+#define __OPT_COMMON__BATCH_OPTIMIZER__HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <opt_common/Application.hpp>
+#include <opt_common/CommandLineParser.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <opt_common/configuration.hpp>
+#include <opt_common/helper.hpp>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace opt_common {
+
+/*! Optimizer of many applications in one process.
+    Each line of the manifest is an optimization, with the syntax of the
+    single application form of the command line without the program name
+    (see CommandLineParser::get_usage).
+    The empty lines and the lines starting with '#' are skipped.
+    Each configuration file is read once for all the applications using it.
+    A result is written as soon as its application is optimized, as one
+    JSON object per line:
+      {"index":0,"input":"...","status":"ok","result":"...","seconds":1.5}
+      {"index":1,"input":"...","status":"error","error":"..."}
+    where "index" is the position of the optimization in the manifest.
+ */
+class BatchOptimizer {
+ public:
+  /*! The optimization algorithm, provided by the optimizer program.
+      It writes on `log`, the log of its application, instead of the
+      standard output (shared by the applications optimized concurrently).
+      \return the result of the optimization
+   */
+  using OptimizeFunction = std::function<std::string(
+      Application* app, const CommandLineParser::CommandLineOptions& options,
+      std::ostream* log)>;
+
+  //! `default_config_file` is used by the entries without '-c'
+  BatchOptimizer(std::string default_config_file, OptimizeFunction optimize);
+
+  //! \return the optimizations listed in a manifest file
+  static std::vector<CommandLineParser::CommandLineOptions> read_manifest(
+      const std::string& manifest_namefile);
+
+  /*! Optimize `entries` concurrently on `scheduler`, with at most
+      `max_in_flight` applications loaded at the same time (0 means one
+      for each worker), writing the results on `os`. If `scheduler` is
+      nullptr, the applications are optimized one at a time on the calling
+      thread.
+      The log of the loading and of the optimization of an application is
+      written on `log` (nothing is written if nullptr) with its result, so
+      the logs of the applications are not interleaved. The standard output
+      is not used, so `os` can be std::cout.
+      \return the number of optimizations which failed
+   */
+  std::size_t run(
+      const std::vector<CommandLineParser::CommandLineOptions>& entries,
+      unsigned max_in_flight, WorkStealingScheduler* scheduler,
+      std::ostream* os, std::ostream* log = &std::cerr) const;
+
+ private:
+  std::string m_default_config_file;
+  OptimizeFunction m_optimize;
+
+  //! A configuration file, read or failed
+  struct ConfigurationFile {
+    Configuration configuration;
+    std::string error;  // Empty if the file has been read
+  };
+
+  //! \return the result line of the optimization `index`, writing its log
+  //! on `log`
+  std::string optimize_entry(
+      std::size_t index, const CommandLineParser::CommandLineOptions& entry,
+      const ConfigurationFile& configuration_file, std::ostream* log,
+      bool* failed) const;
+};
+
+inline BatchOptimizer::BatchOptimizer(std::string default_config_file,
+                                      OptimizeFunction optimize)
+    : m_default_config_file(std::move(default_config_file)),
+      m_optimize(std::move(optimize)) {}
+
+inline std::vector<CommandLineParser::CommandLineOptions>
+BatchOptimizer::read_manifest(const std::string& manifest_namefile) {
+  using namespace std::string_literals;
+
+  std::vector<CommandLineParser::CommandLineOptions> entries;
+  std::size_t line_number = 0;
+  for_each_line(manifest_namefile, [&](std::string_view line) {
+    ++line_number;
+    line = trim_view(line, " \t\r");
+    if (line.empty() || line.front() == '#') {
+      return;
+    }
+
+    // Reuse the command line syntax (with a placeholder program name)
+    std::istringstream iss{std::string(line)};
+    std::vector<std::string> tokens{"batch"};
+    std::string token;
+    while (iss >> token) {
+      tokens.push_back(std::move(token));
+    }
+    std::vector<char*> argv;
+    for (auto& argument : tokens) {
+      argv.push_back(&argument[0]);
+    }
+
+    try {
+      entries.push_back(CommandLineParser::parse_command_line(
+          static_cast<int>(argv.size()), argv.data()));
+    } catch (const std::exception& err) {
+      THROW_RUNTIME_ERROR("In batch manifest: file '"s + manifest_namefile +
+                          "' line " + std::to_string(line_number) + ": " +
+                          err.what());
+    }
+    if (entries.back().daemon_mode || entries.back().batch_mode) {
+      THROW_RUNTIME_ERROR("In batch manifest: file '"s + manifest_namefile +
+                          "' line " + std::to_string(line_number) +
+                          ": not an optimization");
+    }
+  });
+  return entries;
+}
+
+inline std::string BatchOptimizer::optimize_entry(
+    std::size_t index, const CommandLineParser::CommandLineOptions& entry,
+    const ConfigurationFile& configuration_file, std::ostream* log,
+    bool* failed) const {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::string result, error;
+  try {
+    if (configuration_file.error.empty() == false) {
+      THROW_RUNTIME_ERROR(configuration_file.error);
+    }
+
+    Application app = Application::create_application(
+        entry.name_of_file, configuration_file.configuration,
+        TasksSamplingOptions(), log);
+    if (entry.deadline != 0) {
+      app.set_deadline(TimeInstant::from_milliseconds(entry.deadline));
+    }
+    result = m_optimize(&app, entry, log);
+  } catch (const std::exception& err) {
+    error = err.what();
+  } catch (...) {
+    error = "unknown error";
+  }
+
+  *failed = !error.empty();
+
+  std::ostringstream line;
+  line << "{\"index\":" << index << ",\"input\":\""
+       << json_escape(entry.name_of_file) << "\",";
+  if (error.empty()) {
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    line << "\"status\":\"ok\",\"result\":\"" << json_escape(result)
+         << "\",\"seconds\":" << elapsed.count() << "}";
+  } else {
+    line << "\"status\":\"error\",\"error\":\"" << json_escape(error)
+         << "\"}";
+  }
+  return line.str();
+}
+
+inline std::size_t BatchOptimizer::run(
+    const std::vector<CommandLineParser::CommandLineOptions>& entries,
+    unsigned max_in_flight, WorkStealingScheduler* scheduler,
+    std::ostream* os, std::ostream* log) const {
+  // Read each configuration once, before the optimizations share them
+  std::map<std::string, ConfigurationFile> configuration_files;
+  for (const auto& entry : entries) {
+    const std::string& config_file =
+        entry.config_file.empty() ? m_default_config_file : entry.config_file;
+    if (configuration_files.count(config_file) != 0) {
+      continue;
+    }
+
+    ConfigurationFile& configuration_file = configuration_files[config_file];
+    try {
+      configuration_file.configuration.read_configuration_from_file(
+          config_file);
+    } catch (const std::exception& err) {
+      configuration_file.error = err.what();
+    }
+  }
+
+  std::atomic<std::size_t> next_entry(0);
+  std::mutex results_mutex;
+  std::size_t number_of_errors = 0;
+
+  // Optimize one application at a time, until all are done
+  const auto optimize_entries = [&]() {
+    std::size_t index;
+    while ((index = next_entry++) < entries.size()) {
+      const auto& entry = entries[index];
+      std::ostringstream entry_log;
+      bool failed;
+      const std::string line = optimize_entry(
+          index, entry,
+          configuration_files.at(entry.config_file.empty()
+                                     ? m_default_config_file
+                                     : entry.config_file),
+          log != nullptr ? &entry_log : nullptr, &failed);
+
+      std::lock_guard<std::mutex> lock(results_mutex);
+      number_of_errors += failed ? 1 : 0;
+      if (log != nullptr) {
+        *log << entry_log.str() << std::flush;
+      }
+      *os << line << std::endl;
+    }
+  };
+
+  if (scheduler == nullptr) {
+    optimize_entries();
+    return number_of_errors;
+  }
+
+  if (max_in_flight == 0) {
+    max_in_flight = scheduler->get_number_of_workers();
+  }
+
+  WorkStealingScheduler::TaskGroup group(scheduler);
+  const std::size_t number_of_tasks =
+      std::min<std::size_t>(max_in_flight, entries.size());
+  for (std::size_t t = 0; t < number_of_tasks; ++t) {
+    group.spawn(optimize_entries);
+  }
+  group.wait();
+
+  return number_of_errors;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__BATCH_OPTIMIZER__HPP
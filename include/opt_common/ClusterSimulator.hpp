@@ -0,0 +1,604 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__CLUSTER_SIMULATOR__HPP
+#define __OPT_COMMON__CLUSTER_SIMULATOR__HPP
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <opt_common/Application.hpp>
+#include <opt_common/helper.hpp>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace opt_common {
+
+/*! Discrete-event simulation of many applications sharing a fixed pool of
+    containers.
+    Each application arrives at a time instant and releases each job at its
+    submission time in the trace (relative to the first job). A stage runs
+    when its job is released and its parents are completed; with k cores it
+    takes (waves of k tasks * average task time), as in
+    Application::compute_avg_execution_time, and its progress follows the
+    cores it is given while the allocation changes.
+    At each event the policy splits the containers among the applications
+    (each one up to the containers its runnable tasks can use), so the cost
+    of the simulation depends on the number of stages, not of tasks.
+    The workload is compiled once and can be run with several policies.
+ */
+class ClusterSimulator {
+ public:
+  enum class Policy {
+    FIFO,           // By arrival time
+    WEIGHTED_FAIR,  // Proportionally to the weights of the applications
+    EDF             // By absolute deadline (arrival time + deadline)
+  };
+
+  struct ApplicationResult {
+    Application::ApplicationID app_id;
+    TimeInstant arrival_time;
+    TimeInstant completion_time;
+    TimeInstant deadline;  // Absolute
+    bool deadline_missed;
+  };
+
+  struct Report {
+    std::vector<ApplicationResult> applications;  // In the order of addition
+    std::size_t number_of_deadline_misses = 0;
+
+    //! From the first arrival to the last completion
+    TimeInstant makespan;
+
+    /*! Core time of the running tasks over the core time available in the
+        makespan (the cores of a container without tasks to run are idle)
+     */
+    double utilization = 0;
+
+    std::size_t number_of_events = 0;
+
+    void print_dump_on_stream(std::ostream* os) const;
+  };
+
+  /*! A pool of `number_of_containers` containers, each one running
+      `cores_per_container` tasks at a time
+   */
+  explicit ClusterSimulator(unsigned number_of_containers,
+                            unsigned cores_per_container = 1);
+
+  //! Add an application of the workload, arriving at `arrival_time`
+  void add_application(const Application& app,
+                       const TimeInstant& arrival_time);
+
+  //! Add an application arriving at the submission time of its first job
+  void add_application(const Application& app);
+
+  std::size_t get_number_of_applications() const noexcept {
+    return m_applications.size();
+  }
+
+  /*! Simulate the workload with a scheduling policy.
+      \throw std::runtime_error if the stages of an application cannot
+      complete (cyclic dependencies)
+   */
+  Report run(Policy policy) const;
+
+ private:
+  // Times are in microseconds
+  struct SimulatedStage {
+    std::uint32_t number_of_tasks;
+    double task_time;
+    std::int64_t release_offset;  // From the arrival of the application
+    std::uint32_t number_of_parents;
+    std::uint32_t first_child;  // In m_children
+    std::uint32_t number_of_children;
+  };
+
+  struct SimulatedApplication {
+    Application::ApplicationID app_id;
+    std::int64_t arrival_time;
+    std::int64_t deadline;  // From the arrival
+    double weight;
+
+    // Stages in m_stages, sorted by release offset
+    std::uint32_t first_stage;
+    std::uint32_t number_of_stages;
+  };
+
+  // The state of a run
+  struct StageState {
+    std::uint32_t pending_parents;
+    double progress = 0;  // Fraction of the stage completed
+    double rate = 0;      // Progress per microsecond
+    bool released = false;
+    bool completed = false;
+  };
+
+  struct ApplicationState {
+    bool arrived = false;
+    std::uint32_t next_release = 0;  // Stages released so far
+    std::uint32_t completed_stages = 0;
+    std::vector<std::uint32_t> runnable;  // Released with parents completed
+    unsigned demand = 0;                  // Containers the runnable can use
+    unsigned containers = 0;
+  };
+
+  // Arrival or release of jobs of an application (time, application)
+  using Event = std::pair<std::int64_t, std::uint32_t>;
+
+  struct Simulation {
+    Policy policy;
+    std::int64_t origin = 0;  // The first arrival
+    double now = 0;           // From the origin
+    std::vector<StageState> stages;
+    std::vector<ApplicationState> applications;
+
+    // Applications arrived and not completed, in order of priority
+    std::vector<std::uint32_t> active;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>>
+        events;
+
+    // Stages to check whether they can run
+    std::vector<std::uint32_t> ready_stages;
+
+    double busy_core_time = 0;
+    Report report;
+  };
+
+  unsigned m_number_of_containers;
+  unsigned m_cores_per_container;
+  std::vector<SimulatedApplication> m_applications;
+  std::vector<SimulatedStage> m_stages;
+  std::vector<std::uint32_t> m_children;  // Indices in m_stages
+
+  static std::int64_t get_first_submission_time(const Application& app);
+
+  void handle_event(Simulation* simulation, std::uint32_t app_index) const;
+
+  //! Move the ready stages of an application to its runnable stages
+  void update_runnable(Simulation* simulation, std::uint32_t app_index) const;
+
+  void complete_stage(Simulation* simulation, std::uint32_t app_index,
+                      std::uint32_t stage_index) const;
+
+  //! Split the containers among the active applications and set the rates
+  //! of their runnable stages
+  void allocate_containers(Simulation* simulation) const;
+};
+
+inline ClusterSimulator::ClusterSimulator(unsigned number_of_containers,
+                                          unsigned cores_per_container)
+    : m_number_of_containers(number_of_containers),
+      m_cores_per_container(cores_per_container) {
+  if (number_of_containers == 0 || cores_per_container == 0) {
+    THROW_RUNTIME_ERROR("In cluster simulator: empty pool of containers");
+  }
+}
+
+inline std::int64_t ClusterSimulator::get_first_submission_time(
+    const Application& app) {
+  std::int64_t first_submission = std::numeric_limits<std::int64_t>::max();
+  for (const auto& job_pair : app.get_all_jobs()) {
+    first_submission =
+        std::min(first_submission,
+                 job_pair.second.get_submission_time().count_microseconds());
+  }
+  return first_submission == std::numeric_limits<std::int64_t>::max()
+             ? 0
+             : first_submission;
+}
+
+inline void ClusterSimulator::add_application(const Application& app) {
+  add_application(app, TimeInstant::from_microseconds(
+                           get_first_submission_time(app)));
+}
+
+inline void ClusterSimulator::add_application(
+    const Application& app, const TimeInstant& arrival_time) {
+  const auto& stages = app.get_all_stages();
+
+  // Release of each stage: the submission of its job
+  const std::int64_t first_submission = get_first_submission_time(app);
+  std::map<Stage::StageID, std::int64_t> release_offsets;
+  for (const auto& job_pair : app.get_all_jobs()) {
+    const std::int64_t offset =
+        job_pair.second.get_submission_time().count_microseconds() -
+        first_submission;
+    for (const auto& stage_id : job_pair.second.get_id_stages()) {
+      const auto inserted = release_offsets.emplace(stage_id, offset);
+      if (inserted.second == false) {
+        inserted.first->second = std::min(inserted.first->second, offset);
+      }
+    }
+  }
+
+  // Order the stages by release
+  std::vector<std::pair<std::int64_t, const Stage*>> sorted_stages;
+  sorted_stages.reserve(stages.size());
+  for (const auto& stage_pair : stages) {
+    const auto finder = release_offsets.find(stage_pair.first);
+    sorted_stages.emplace_back(
+        finder != release_offsets.cend() ? finder->second : 0,
+        &stage_pair.second);
+  }
+  std::stable_sort(
+      sorted_stages.begin(), sorted_stages.end(),
+      [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+  const auto first_stage = static_cast<std::uint32_t>(m_stages.size());
+  std::map<Stage::StageID, std::uint32_t> stage_indices;
+  for (std::size_t i = 0; i < sorted_stages.size(); ++i) {
+    stage_indices.emplace(sorted_stages[i].second->get_stageID(),
+                          first_stage + static_cast<std::uint32_t>(i));
+  }
+
+  // The parents of the stages (outside the application are ignored)
+  std::vector<std::vector<std::uint32_t>> children(sorted_stages.size());
+  std::vector<std::uint32_t> number_of_parents(sorted_stages.size(), 0);
+  for (std::size_t i = 0; i < sorted_stages.size(); ++i) {
+    for (const auto& parent_id : sorted_stages[i].second->get_dependencies()) {
+      const auto finder = stage_indices.find(parent_id);
+      if (finder != stage_indices.cend()) {
+        children[finder->second - first_stage].push_back(
+            first_stage + static_cast<std::uint32_t>(i));
+        ++number_of_parents[i];
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < sorted_stages.size(); ++i) {
+    const Stage& stage = *sorted_stages[i].second;
+    m_stages.push_back(SimulatedStage{
+        stage.get_number_of_tasks(),
+        static_cast<double>(stage.get_avg_time().count_microseconds()),
+        sorted_stages[i].first, number_of_parents[i],
+        static_cast<std::uint32_t>(m_children.size()),
+        static_cast<std::uint32_t>(children[i].size())});
+    m_children.insert(m_children.end(), children[i].cbegin(),
+                      children[i].cend());
+  }
+
+  m_applications.push_back(SimulatedApplication{
+      app.get_application_id(), arrival_time.count_microseconds(),
+      app.get_deadline().count_microseconds(),
+      app.get_weight() > 0 ? app.get_weight() : 1.0, first_stage,
+      static_cast<std::uint32_t>(sorted_stages.size())});
+}
+
+inline ClusterSimulator::Report ClusterSimulator::run(Policy policy) const {
+  Simulation simulation;
+  simulation.policy = policy;
+  simulation.stages.resize(m_stages.size());
+  for (std::size_t i = 0; i < m_stages.size(); ++i) {
+    simulation.stages[i].pending_parents = m_stages[i].number_of_parents;
+  }
+  simulation.applications.resize(m_applications.size());
+  simulation.report.applications.resize(m_applications.size());
+  for (std::size_t i = 0; i < m_applications.size(); ++i) {
+    simulation.events.emplace(m_applications[i].arrival_time,
+                              static_cast<std::uint32_t>(i));
+  }
+
+  if (simulation.events.empty() == false) {
+    simulation.origin = simulation.events.top().first;
+  }
+  auto& now = simulation.now;
+
+  std::vector<std::uint32_t> active;
+  while (!simulation.events.empty() || !simulation.active.empty()) {
+    allocate_containers(&simulation);
+
+    // The next event: the first stage completed or the next arrival/release
+    double next_time = std::numeric_limits<double>::infinity();
+    for (const auto app_index : simulation.active) {
+      for (const auto stage_index :
+           simulation.applications[app_index].runnable) {
+        const StageState& stage = simulation.stages[stage_index];
+        if (stage.rate > 0) {
+          next_time = std::min(next_time, now + (1 - stage.progress) /
+                                                    stage.rate);
+        }
+      }
+    }
+    if (!simulation.events.empty()) {
+      next_time = std::min(next_time,
+                           static_cast<double>(simulation.events.top().first -
+                                               simulation.origin));
+    }
+    if (std::isinf(next_time)) {
+      THROW_RUNTIME_ERROR(
+          "In cluster simulator: the stages of an application cannot "
+          "complete (cyclic dependencies)");
+    }
+
+    // Advance to the event: the progress of a stage is the fraction of the
+    // core time of its tasks run
+    const double elapsed = next_time - now;
+    for (const auto app_index : simulation.active) {
+      const ApplicationState& application = simulation.applications[app_index];
+      for (const auto stage_index : application.runnable) {
+        StageState& stage = simulation.stages[stage_index];
+        const double progress = stage.progress;
+        if (stage.rate > 0 && now + (1 - stage.progress) / stage.rate <=
+                                  next_time) {
+          // The stage which is the event (whatever the rounding)
+          stage.progress = 1;
+        } else {
+          stage.progress += stage.rate * elapsed;
+        }
+        const SimulatedStage& simulated_stage = m_stages[stage_index];
+        simulation.busy_core_time += (stage.progress - progress) *
+                                     simulated_stage.number_of_tasks *
+                                     simulated_stage.task_time;
+      }
+    }
+    now = next_time;
+    ++simulation.report.number_of_events;
+
+    // Complete the stages (completing applications leave the active ones)
+    active = simulation.active;
+    for (const auto app_index : active) {
+      auto& runnable = simulation.applications[app_index].runnable;
+      const auto completed_begin = std::stable_partition(
+          runnable.begin(), runnable.end(), [&](std::uint32_t stage_index) {
+            return simulation.stages[stage_index].progress < 1;
+          });
+      if (completed_begin == runnable.end()) {
+        continue;
+      }
+      const std::vector<std::uint32_t> completed(completed_begin,
+                                                 runnable.end());
+      runnable.erase(completed_begin, runnable.end());
+      for (const auto stage_index : completed) {
+        complete_stage(&simulation, app_index, stage_index);
+      }
+      update_runnable(&simulation, app_index);
+    }
+
+    while (!simulation.events.empty() &&
+           simulation.events.top().first - simulation.origin <= now) {
+      const std::uint32_t app_index = simulation.events.top().second;
+      simulation.events.pop();
+      handle_event(&simulation, app_index);
+    }
+  }
+
+  Report& report = simulation.report;
+  report.makespan = TimeInstant::from_microseconds(std::llround(now));
+  if (now > 0) {
+    report.utilization =
+        simulation.busy_core_time /
+        (static_cast<double>(m_number_of_containers) * m_cores_per_container *
+         now);
+  }
+  return std::move(simulation.report);
+}
+
+inline void ClusterSimulator::handle_event(Simulation* simulation,
+                                           std::uint32_t app_index) const {
+  const SimulatedApplication& app = m_applications[app_index];
+  ApplicationState& application = simulation->applications[app_index];
+
+  if (application.arrived == false) {
+    application.arrived = true;
+    ApplicationResult& result = simulation->report.applications[app_index];
+    result.app_id = app.app_id;
+    result.arrival_time = TimeInstant::from_microseconds(app.arrival_time);
+    result.deadline =
+        TimeInstant::from_microseconds(app.arrival_time + app.deadline);
+
+    auto& active = simulation->active;
+    if (simulation->policy == Policy::EDF) {
+      const auto position = std::upper_bound(
+          active.begin(), active.end(), app.arrival_time + app.deadline,
+          [this](std::int64_t deadline, std::uint32_t other) {
+            return deadline < m_applications[other].arrival_time +
+                                  m_applications[other].deadline;
+          });
+      active.insert(position, app_index);
+    } else {
+      // The events are in order of time: the active applications stay
+      // sorted by arrival
+      active.push_back(app_index);
+    }
+  }
+
+  // Release the stages of the jobs submitted so far
+  const double elapsed =
+      simulation->now - (app.arrival_time - simulation->origin);
+  while (application.next_release < app.number_of_stages) {
+    const std::uint32_t stage_index =
+        app.first_stage + application.next_release;
+    const SimulatedStage& stage = m_stages[stage_index];
+    if (stage.release_offset > elapsed) {
+      simulation->events.emplace(app.arrival_time + stage.release_offset,
+                                 app_index);
+      break;
+    }
+    simulation->stages[stage_index].released = true;
+    simulation->ready_stages.push_back(stage_index);
+    ++application.next_release;
+  }
+  update_runnable(simulation, app_index);
+}
+
+inline void ClusterSimulator::update_runnable(Simulation* simulation,
+                                              std::uint32_t app_index) const {
+  ApplicationState& application = simulation->applications[app_index];
+  auto& ready_stages = simulation->ready_stages;
+
+  while (ready_stages.empty() == false) {
+    const std::uint32_t stage_index = ready_stages.back();
+    ready_stages.pop_back();
+
+    const SimulatedStage& stage = m_stages[stage_index];
+    const StageState& state = simulation->stages[stage_index];
+    if (!state.released || state.pending_parents != 0 || state.completed) {
+      continue;
+    }
+    if (stage.number_of_tasks != 0 && stage.task_time > 0) {
+      application.runnable.push_back(stage_index);
+    } else {
+      // Nothing to run
+      complete_stage(simulation, app_index, stage_index);
+    }
+  }
+
+  if (application.completed_stages ==
+      m_applications[app_index].number_of_stages) {
+    ApplicationResult& result = simulation->report.applications[app_index];
+    result.completion_time = TimeInstant::from_microseconds(
+        simulation->origin + std::llround(simulation->now));
+    result.deadline_missed = result.completion_time > result.deadline;
+    if (result.deadline_missed) {
+      ++simulation->report.number_of_deadline_misses;
+    }
+
+    auto& active = simulation->active;
+    active.erase(std::find(active.begin(), active.end(), app_index));
+    application.containers = 0;
+  }
+}
+
+inline void ClusterSimulator::complete_stage(Simulation* simulation,
+                                             std::uint32_t app_index,
+                                             std::uint32_t stage_index) const {
+  const SimulatedStage& stage = m_stages[stage_index];
+  StageState& state = simulation->stages[stage_index];
+  state.completed = true;
+  state.rate = 0;
+  ++simulation->applications[app_index].completed_stages;
+
+  for (std::uint32_t i = 0; i < stage.number_of_children; ++i) {
+    const std::uint32_t child = m_children[stage.first_child + i];
+    --simulation->stages[child].pending_parents;
+    simulation->ready_stages.push_back(child);
+  }
+}
+
+inline void ClusterSimulator::allocate_containers(
+    Simulation* simulation) const {
+  auto& applications = simulation->applications;
+  unsigned available = m_number_of_containers;
+
+  std::vector<std::uint32_t> unsatisfied;
+  for (const auto app_index : simulation->active) {
+    ApplicationState& application = applications[app_index];
+    std::uint64_t tasks = 0;
+    for (const auto stage_index : application.runnable) {
+      tasks += m_stages[stage_index].number_of_tasks;
+    }
+    application.demand = static_cast<unsigned>(std::min<std::uint64_t>(
+        (tasks + m_cores_per_container - 1) / m_cores_per_container,
+        m_number_of_containers));
+
+    if (simulation->policy == Policy::WEIGHTED_FAIR) {
+      application.containers = 0;
+      if (application.demand > 0) {
+        unsatisfied.push_back(app_index);
+      }
+    } else {
+      // The active applications are in order of priority
+      application.containers = std::min(application.demand, available);
+      available -= application.containers;
+    }
+  }
+
+  // Progressive filling: the share an application cannot use is split among
+  // the others in the next round
+  while (available > 0 && unsatisfied.empty() == false) {
+    double total_weight = 0;
+    for (const auto app_index : unsatisfied) {
+      total_weight += m_applications[app_index].weight;
+    }
+
+    const unsigned round_containers = available;
+    for (const auto app_index : unsatisfied) {
+      ApplicationState& application = applications[app_index];
+      const auto share = static_cast<unsigned>(
+          round_containers * m_applications[app_index].weight / total_weight);
+      const unsigned given =
+          std::min(share, application.demand - application.containers);
+      application.containers += given;
+      available -= given;
+    }
+
+    if (available == round_containers) {
+      // The shares are less than one container: one each to the applications
+      // with the fewest containers per weight
+      std::sort(unsatisfied.begin(), unsatisfied.end(),
+                [&](std::uint32_t lhs, std::uint32_t rhs) {
+                  return applications[lhs].containers /
+                             m_applications[lhs].weight <
+                         applications[rhs].containers /
+                             m_applications[rhs].weight;
+                });
+      for (std::size_t i = 0; i < unsatisfied.size() && available > 0; ++i) {
+        ++applications[unsatisfied[i]].containers;
+        --available;
+      }
+      break;
+    }
+
+    unsatisfied.erase(
+        std::remove_if(unsatisfied.begin(), unsatisfied.end(),
+                       [&](std::uint32_t app_index) {
+                         return applications[app_index].containers ==
+                                applications[app_index].demand;
+                       }),
+        unsatisfied.end());
+  }
+
+  // Each runnable stage takes the cores it can use, in order of release
+  for (const auto app_index : simulation->active) {
+    const ApplicationState& application = applications[app_index];
+    std::uint64_t cores =
+        static_cast<std::uint64_t>(application.containers) *
+        m_cores_per_container;
+    for (const auto stage_index : application.runnable) {
+      const SimulatedStage& stage = m_stages[stage_index];
+      const std::uint64_t stage_cores =
+          std::min<std::uint64_t>(cores, stage.number_of_tasks);
+      cores -= stage_cores;
+
+      StageState& state = simulation->stages[stage_index];
+      state.rate = 0;
+      if (stage_cores > 0) {
+        const std::uint64_t waves =
+            (stage.number_of_tasks + stage_cores - 1) / stage_cores;
+        state.rate = 1.0 / (waves * stage.task_time);
+      }
+    }
+  }
+}
+
+inline void ClusterSimulator::Report::print_dump_on_stream(
+    std::ostream* os) const {
+  *os << "Applications: " << applications.size() << "\n"
+      << "Deadline misses: " << number_of_deadline_misses << "\n"
+      << "Makespan: " << makespan << "\n"
+      << "Utilization: " << utilization << "\n";
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__CLUSTER_SIMULATOR__HPP
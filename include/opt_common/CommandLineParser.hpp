@@ -30,21 +30,88 @@ class CommandLineParser {
     std::string name_of_file;
     OptimizeMethod optimize_method;
     bool no_ml;
+    bool hybrid;             // Simulate only the probes near the deadline
+    unsigned long deadline;  // Milliseconds, 0 keeps the input file one
     std::string config_file;
+    bool daemon_mode;
+    std::string socket_path;
+    bool batch_mode;
+    std::string manifest_file;
+    unsigned number_of_threads;  // 0 means one for each hardware thread
+    unsigned max_in_flight;      // 0 means one for each thread
   };
 
+  //! Parse the command line in one of the forms of get_usage
   static CommandLineOptions parse_command_line(int argc, char** argv);
+
+  //! \return the forms of the command line (one for each line)
+  static std::string get_usage(const std::string& program);
+
+ private:
+  enum class Option { NO_ML, HYBRID, DEADLINE, SOCKET, THREADS, IN_FLIGHT,
+                      CONFIG };
+
+  //! Forms of the command line, as a mask
+  enum : unsigned { SINGLE_FORM = 1, DAEMON_FORM = 2, BATCH_FORM = 4 };
+
+  struct OptionSpec {
+    const char* name;
+    const char* value_name;  // nullptr for a flag
+    unsigned forms;
+    Option option;
+  };
+
+  //! The optional arguments, in the order of the usage
+  static constexpr OptionSpec OPTIONS[] = {
+      {"--no-ml", nullptr, SINGLE_FORM, Option::NO_ML},
+      {"--hybrid", nullptr, SINGLE_FORM, Option::HYBRID},
+      {"--deadline", "MS", SINGLE_FORM, Option::DEADLINE},
+      {"--socket", "SOCKET_PATH", DAEMON_FORM, Option::SOCKET},
+      {"-j", "THREADS", BATCH_FORM, Option::THREADS},
+      {"--max-in-flight", "N", BATCH_FORM, Option::IN_FLIGHT},
+      {"-c", "CONFIG_FILE", SINGLE_FORM | DAEMON_FORM | BATCH_FORM,
+       Option::CONFIG}};
+
+  static void parse_optional_arguments(int first_arg, int argc, char** argv,
+                                       CommandLineOptions* options);
+
+  //! \return the optional arguments of `form`, as shown in the usage
+  static std::string get_optional_arguments_usage(unsigned form);
 };
 
 inline CommandLineParser::CommandLineOptions
 CommandLineParser::parse_command_line(int argc, char** argv) {
+  CommandLineOptions options;
+  options.no_ml = false;
+  options.hybrid = false;
+  options.deadline = 0;
+  options.daemon_mode = false;
+  options.batch_mode = false;
+  options.number_of_threads = 0;
+  options.max_in_flight = 0;
+
+  // Service mode: requests are read at runtime
+  if (argc >= 2 && std::string(argv[1]) == "--daemon") {
+    options.daemon_mode = true;
+    parse_optional_arguments(2, argc, argv, &options);
+    return options;
+  }
+
+  // Batch mode: the applications are listed in the manifest
+  if (argc >= 2 && std::string(argv[1]) == "--batch") {
+    if (argc < 3) {
+      THROW_RUNTIME_ERROR("Command line parse error: missing manifest file");
+    }
+    options.batch_mode = true;
+    options.manifest_file = argv[2];
+    parse_optional_arguments(3, argc, argv, &options);
+    return options;
+  }
+
   if (argc < 3) {
     THROW_RUNTIME_ERROR("Command line parse error: missing argument");
   }
 
-  CommandLineOptions options;
-  options.no_ml = false;
-
   // Get the name of the input file
   options.name_of_file = argv[1];
 
@@ -76,23 +143,103 @@ CommandLineParser::parse_command_line(int argc, char** argv) {
           "Command line parse error: Optimize method not recognized");
   }
 
-  // Parse optional arguments (--no-ml and -c)
-  const int num_args_to_parse = argc - 3;
-  for (int i = 0; i < num_args_to_parse; ++i) {
-    std::string arg_str = argv[3 + i];
-    if (arg_str == "--no-ml") {
-      // Active no-ml
-      options.no_ml = true;
-    } else if (arg_str == "-c") {
-      options.config_file = argv[3 + i + 1];
-      ++i;
-    } else {
+  // Parse optional arguments (--no-ml, --hybrid, --deadline and -c)
+  parse_optional_arguments(3, argc, argv, &options);
+
+  return options;
+}
+
+inline std::string CommandLineParser::get_usage(const std::string& program) {
+  return program + " INPUT_FILE -f|-b" +
+         get_optional_arguments_usage(SINGLE_FORM) + "\n" + program +
+         " --daemon" + get_optional_arguments_usage(DAEMON_FORM) + "\n" +
+         program + " --batch MANIFEST_FILE" +
+         get_optional_arguments_usage(BATCH_FORM) + "\n";
+}
+
+inline std::string CommandLineParser::get_optional_arguments_usage(
+    unsigned form) {
+  std::string usage;
+  for (const OptionSpec& spec : OPTIONS) {
+    if (spec.forms & form) {
+      usage += std::string(" [") + spec.name;
+      if (spec.value_name != nullptr) {
+        usage += std::string(" ") + spec.value_name;
+      }
+      usage += "]";
+    }
+  }
+  return usage;
+}
+
+inline void CommandLineParser::parse_optional_arguments(
+    int first_arg, int argc, char** argv, CommandLineOptions* options) {
+  const unsigned form = options->daemon_mode
+                            ? DAEMON_FORM
+                            : options->batch_mode ? BATCH_FORM : SINGLE_FORM;
+
+  for (int i = first_arg; i < argc; ++i) {
+    std::string arg_str = argv[i];
+    const OptionSpec* spec = nullptr;
+    for (const OptionSpec& candidate : OPTIONS) {
+      if (arg_str == candidate.name) {
+        spec = &candidate;
+      }
+    }
+    if (spec == nullptr) {
       THROW_RUNTIME_ERROR(std::string("Command line parse error: Option '" +
                                       arg_str + "' not recognized"));
     }
-  }
+    if ((spec->forms & form) == 0) {
+      THROW_RUNTIME_ERROR("Command line parse error: Option '" + arg_str +
+                          "' not valid in " +
+                          (form == DAEMON_FORM
+                               ? "daemon mode"
+                               : form == BATCH_FORM
+                                     ? "batch mode"
+                                     : "single application mode"));
+    }
 
-  return options;
+    std::string value;
+    if (spec->value_name != nullptr) {
+      if (i + 1 >= argc) {
+        THROW_RUNTIME_ERROR("Command line parse error: missing value for '" +
+                            arg_str + "'");
+      }
+      value = argv[++i];
+    }
+
+    bool valid = true;
+    switch (spec->option) {
+      case Option::NO_ML:
+        options->no_ml = true;
+        break;
+      case Option::HYBRID:
+        // Surrogate-guided search (see SurrogateGuidedSearch)
+        options->hybrid = true;
+        break;
+      case Option::DEADLINE:
+        valid = parse_number(value, &options->deadline) &&
+                options->deadline != 0;
+        break;
+      case Option::SOCKET:
+        options->socket_path = value;
+        break;
+      case Option::THREADS:
+        valid = parse_number(value, &options->number_of_threads);
+        break;
+      case Option::IN_FLIGHT:
+        valid = parse_number(value, &options->max_in_flight);
+        break;
+      case Option::CONFIG:
+        options->config_file = value;
+        break;
+    }
+    if (!valid) {
+      THROW_RUNTIME_ERROR("Command line parse error: invalid value '" + value +
+                          "' for '" + arg_str + "'");
+    }
+  }
 }
 
 }  // namespace opt_common
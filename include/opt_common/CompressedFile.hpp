@@ -0,0 +1,487 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__COMPRESSED_FILE__HPP
+#define __OPT_COMMON__COMPRESSED_FILE__HPP
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+// Define OPT_COMMON_WITH_ZLIB (link with -lz) and/or OPT_COMMON_WITH_ZSTD
+// (link with -lzstd) to read compressed traces
+#ifdef OPT_COMMON_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef OPT_COMMON_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace opt_common {
+
+enum class Compression { NONE, GZIP, ZSTD };
+
+//! \return the compression of the file according to its extension
+inline Compression detect_compression(const std::string& filename) noexcept {
+  const auto ends_with = [&filename](const std::string& extension) {
+    return filename.size() >= extension.size() &&
+           filename.compare(filename.size() - extension.size(),
+                            extension.size(), extension) == 0;
+  };
+
+  if (ends_with(".gz")) {
+    return Compression::GZIP;
+  }
+  if (ends_with(".zst")) {
+    return Compression::ZSTD;
+  }
+  return Compression::NONE;
+}
+
+//! Queue of chunks between two stages of a pipeline
+class ChunkQueue {
+ public:
+  explicit ChunkQueue(std::size_t capacity) : m_capacity(capacity) {}
+
+  //! \return false if the queue has been closed
+  bool push(std::string chunk);
+
+  //! \return false if the queue is closed and empty
+  bool pop(std::string* chunk);
+
+  //! Wake up every waiting thread (no more chunks will be pushed)
+  void close();
+
+ private:
+  const std::size_t m_capacity;
+  std::deque<std::string> m_chunks;
+  bool m_closed = false;
+  std::mutex m_mutex;
+  std::condition_variable m_not_full;
+  std::condition_variable m_not_empty;
+};
+
+inline bool ChunkQueue::push(std::string chunk) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_not_full.wait(lock,
+                  [this]() { return m_closed || m_chunks.size() < m_capacity; });
+  if (m_closed) {
+    return false;
+  }
+  m_chunks.push_back(std::move(chunk));
+  m_not_empty.notify_one();
+  return true;
+}
+
+inline bool ChunkQueue::pop(std::string* chunk) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_not_empty.wait(lock, [this]() { return m_closed || !m_chunks.empty(); });
+  if (m_chunks.empty()) {
+    return false;
+  }
+  *chunk = std::move(m_chunks.front());
+  m_chunks.pop_front();
+  m_not_full.notify_one();
+  return true;
+}
+
+inline void ChunkQueue::close() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_closed = true;
+  m_not_full.notify_all();
+  m_not_empty.notify_all();
+}
+
+/*! Read a (possibly compressed) file as a stream of decompressed chunks.
+    Reading the file and decompressing it run on two threads, so they overlap
+    with the processing of the chunks done by the caller.
+ */
+class DecompressingReader {
+ public:
+  DecompressingReader(const std::string& filename, Compression compression);
+  ~DecompressingReader();
+
+  DecompressingReader(const DecompressingReader&) = delete;
+  DecompressingReader& operator=(const DecompressingReader&) = delete;
+
+  /*! \return false at the end of the file
+      \throw std::runtime_error if the file cannot be read or decompressed
+   */
+  bool read_chunk(std::string* chunk);
+
+ private:
+  static constexpr std::size_t CHUNK_SIZE = 1 << 20;
+  static constexpr std::size_t QUEUE_CAPACITY = 4;
+
+  std::ifstream m_file;
+  Compression m_compression;
+  ChunkQueue m_raw_chunks;
+  ChunkQueue m_decompressed_chunks;
+  std::exception_ptr m_error;
+  std::mutex m_error_mutex;
+  std::thread m_reader;
+  std::thread m_decompressor;
+
+  void read_file();
+  void decompress();
+  void set_error(std::exception_ptr error);
+
+  // Decompress all the raw chunks, pushing the output to the next stage
+  void decompress_gzip();
+  void decompress_zstd();
+};
+
+inline DecompressingReader::DecompressingReader(const std::string& filename,
+                                                Compression compression)
+    : m_file(filename, std::ios::binary),
+      m_compression(compression),
+      m_raw_chunks(QUEUE_CAPACITY),
+      m_decompressed_chunks(QUEUE_CAPACITY) {
+  using namespace std::string_literals;
+
+  if (m_file.fail()) {
+    throw std::runtime_error("In read compressed file: cannot open file '"s +
+                             filename + "'");
+  }
+
+#ifndef OPT_COMMON_WITH_ZLIB
+  if (compression == Compression::GZIP) {
+    throw std::runtime_error("In read compressed file: '"s + filename +
+                             "' needs gzip support (OPT_COMMON_WITH_ZLIB)");
+  }
+#endif
+#ifndef OPT_COMMON_WITH_ZSTD
+  if (compression == Compression::ZSTD) {
+    throw std::runtime_error("In read compressed file: '"s + filename +
+                             "' needs zstd support (OPT_COMMON_WITH_ZSTD)");
+  }
+#endif
+
+  m_reader = std::thread(&DecompressingReader::read_file, this);
+  m_decompressor = std::thread(&DecompressingReader::decompress, this);
+}
+
+inline DecompressingReader::~DecompressingReader() {
+  // Stop the pipeline even if the caller did not read everything
+  m_raw_chunks.close();
+  m_decompressed_chunks.close();
+  m_reader.join();
+  m_decompressor.join();
+}
+
+inline bool DecompressingReader::read_chunk(std::string* chunk) {
+  const bool available = m_decompressed_chunks.pop(chunk);
+
+  std::lock_guard<std::mutex> lock(m_error_mutex);
+  if (m_error) {
+    std::rethrow_exception(m_error);
+  }
+  return available;
+}
+
+inline void DecompressingReader::set_error(std::exception_ptr error) {
+  {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    if (!m_error) {
+      m_error = std::move(error);
+    }
+  }
+  m_raw_chunks.close();
+  m_decompressed_chunks.close();
+}
+
+inline void DecompressingReader::read_file() {
+  try {
+    while (m_file) {
+      std::string chunk(CHUNK_SIZE, '\0');
+      m_file.read(&chunk[0], chunk.size());
+      chunk.resize(m_file.gcount());
+      if (chunk.empty() || m_raw_chunks.push(std::move(chunk)) == false) {
+        break;
+      }
+    }
+    if (m_file.bad()) {
+      throw std::runtime_error("In read compressed file: read error");
+    }
+    m_raw_chunks.close();
+  } catch (...) {
+    set_error(std::current_exception());
+  }
+}
+
+inline void DecompressingReader::decompress() {
+  try {
+    switch (m_compression) {
+      case Compression::NONE: {
+        std::string chunk;
+        while (m_raw_chunks.pop(&chunk)) {
+          m_decompressed_chunks.push(std::move(chunk));
+        }
+        break;
+      }
+      case Compression::GZIP:
+        decompress_gzip();
+        break;
+      case Compression::ZSTD:
+        decompress_zstd();
+        break;
+    }
+    m_decompressed_chunks.close();
+  } catch (...) {
+    set_error(std::current_exception());
+  }
+}
+
+inline void DecompressingReader::decompress_gzip() {
+#ifdef OPT_COMMON_WITH_ZLIB
+  z_stream stream{};
+  // Accept both gzip and zlib headers
+  if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+    throw std::runtime_error("In read compressed file: cannot init zlib");
+  }
+
+  std::string input;
+  int ret = Z_OK;
+  while (m_raw_chunks.pop(&input)) {
+    stream.next_in = reinterpret_cast<Bytef*>(&input[0]);
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    while (stream.avail_in > 0) {
+      if (ret == Z_STREAM_END) {
+        // Concatenated gzip members
+        inflateReset(&stream);
+      }
+
+      std::string output(CHUNK_SIZE, '\0');
+      stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+      stream.avail_out = static_cast<uInt>(output.size());
+
+      ret = inflate(&stream, Z_NO_FLUSH);
+      if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+        inflateEnd(&stream);
+        throw std::runtime_error("In read compressed file: corrupted gzip data");
+      }
+
+      output.resize(output.size() - stream.avail_out);
+      if (!output.empty() &&
+          m_decompressed_chunks.push(std::move(output)) == false) {
+        inflateEnd(&stream);
+        return;
+      }
+    }
+  }
+  inflateEnd(&stream);
+
+  if (ret != Z_STREAM_END) {
+    throw std::runtime_error("In read compressed file: truncated gzip data");
+  }
+#endif
+}
+
+inline void DecompressingReader::decompress_zstd() {
+#ifdef OPT_COMMON_WITH_ZSTD
+  ZSTD_DStream* const stream = ZSTD_createDStream();
+  if (stream == nullptr || ZSTD_isError(ZSTD_initDStream(stream))) {
+    ZSTD_freeDStream(stream);
+    throw std::runtime_error("In read compressed file: cannot init zstd");
+  }
+
+  std::string input;
+  std::size_t ret = 0;
+  while (m_raw_chunks.pop(&input)) {
+    ZSTD_inBuffer in_buffer{input.data(), input.size(), 0};
+
+    while (in_buffer.pos < in_buffer.size) {
+      std::string output(ZSTD_DStreamOutSize(), '\0');
+      ZSTD_outBuffer out_buffer{&output[0], output.size(), 0};
+
+      ret = ZSTD_decompressStream(stream, &out_buffer, &in_buffer);
+      if (ZSTD_isError(ret)) {
+        ZSTD_freeDStream(stream);
+        throw std::runtime_error(
+            std::string("In read compressed file: zstd error: ") +
+            ZSTD_getErrorName(ret));
+      }
+
+      output.resize(out_buffer.pos);
+      if (!output.empty() &&
+          m_decompressed_chunks.push(std::move(output)) == false) {
+        ZSTD_freeDStream(stream);
+        return;
+      }
+    }
+  }
+  ZSTD_freeDStream(stream);
+
+  // A complete frame leaves nothing pending
+  if (ret != 0) {
+    throw std::runtime_error("In read compressed file: truncated zstd data");
+  }
+#endif
+}
+
+//! Append `block` to `line` up to the first '\n'
+//! \return true if the line is complete
+inline bool append_to_first_line(std::string_view block, std::string* line) {
+  const auto end_line = block.find('\n');
+  line->append(block.substr(0, end_line));
+  return end_line != std::string_view::npos;
+}
+
+//! Read the next block of `file` into `block`
+//! \return the size read (0 at the end of the file)
+inline std::size_t read_file_block(std::ifstream* file, std::string* block) {
+  file->read(&(*block)[0], block->size());
+  if (file->bad()) {
+    throw std::runtime_error("In read compressed file: read error");
+  }
+  return static_cast<std::size_t>(file->gcount());
+}
+
+/*! \return the first line of a (possibly compressed) file, without its
+    '\n'. Only the blocks up to the end of the line are read and
+    decompressed, on the calling thread (e.g. to read the header of a CSV
+    file, where a DecompressingReader would start its threads for a few
+    bytes).
+    \throw std::runtime_error if the file cannot be read or decompressed
+ */
+inline std::string read_first_line_of_file(const std::string& filename,
+                                           Compression compression) {
+  using namespace std::string_literals;
+
+  std::ifstream file(filename, std::ios::binary);
+  if (file.fail()) {
+    throw std::runtime_error("In read compressed file: cannot open file '"s +
+                             filename + "'");
+  }
+
+  static constexpr std::size_t BLOCK_SIZE = 1 << 12;
+  std::string line, input(BLOCK_SIZE, '\0'), output(BLOCK_SIZE, '\0');
+  std::size_t input_size;
+
+  switch (compression) {
+    case Compression::NONE:
+      while ((input_size = read_file_block(&file, &input)) > 0) {
+        if (append_to_first_line(std::string_view(input.data(), input_size),
+                                 &line)) {
+          break;
+        }
+      }
+      return line;
+
+    case Compression::GZIP: {
+#ifdef OPT_COMMON_WITH_ZLIB
+      z_stream stream{};
+      // Accept both gzip and zlib headers
+      if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        throw std::runtime_error("In read compressed file: cannot init zlib");
+      }
+
+      int ret = Z_OK;
+      while ((input_size = read_file_block(&file, &input)) > 0) {
+        stream.next_in = reinterpret_cast<Bytef*>(&input[0]);
+        stream.avail_in = static_cast<uInt>(input_size);
+        while (stream.avail_in > 0) {
+          if (ret == Z_STREAM_END) {
+            // Concatenated gzip members
+            inflateReset(&stream);
+          }
+
+          stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+          stream.avail_out = static_cast<uInt>(output.size());
+          ret = inflate(&stream, Z_NO_FLUSH);
+          if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            inflateEnd(&stream);
+            throw std::runtime_error(
+                "In read compressed file: corrupted gzip data");
+          }
+
+          if (append_to_first_line(
+                  std::string_view(output.data(),
+                                   output.size() - stream.avail_out),
+                  &line)) {
+            inflateEnd(&stream);
+            return line;
+          }
+        }
+      }
+      inflateEnd(&stream);
+
+      if (ret != Z_STREAM_END) {
+        throw std::runtime_error(
+            "In read compressed file: truncated gzip data");
+      }
+      return line;
+#else
+      throw std::runtime_error("In read compressed file: '"s + filename +
+                               "' needs gzip support (OPT_COMMON_WITH_ZLIB)");
+#endif
+    }
+
+    case Compression::ZSTD: {
+#ifdef OPT_COMMON_WITH_ZSTD
+      ZSTD_DStream* const stream = ZSTD_createDStream();
+      if (stream == nullptr || ZSTD_isError(ZSTD_initDStream(stream))) {
+        ZSTD_freeDStream(stream);
+        throw std::runtime_error("In read compressed file: cannot init zstd");
+      }
+
+      std::size_t ret = 0;
+      while ((input_size = read_file_block(&file, &input)) > 0) {
+        ZSTD_inBuffer in_buffer{input.data(), input_size, 0};
+        while (in_buffer.pos < in_buffer.size) {
+          ZSTD_outBuffer out_buffer{&output[0], output.size(), 0};
+          ret = ZSTD_decompressStream(stream, &out_buffer, &in_buffer);
+          if (ZSTD_isError(ret)) {
+            ZSTD_freeDStream(stream);
+            throw std::runtime_error(
+                std::string("In read compressed file: zstd error: ") +
+                ZSTD_getErrorName(ret));
+          }
+
+          if (append_to_first_line(
+                  std::string_view(output.data(), out_buffer.pos), &line)) {
+            ZSTD_freeDStream(stream);
+            return line;
+          }
+        }
+      }
+      ZSTD_freeDStream(stream);
+
+      if (ret != 0) {
+        throw std::runtime_error(
+            "In read compressed file: truncated zstd data");
+      }
+      return line;
+#else
+      throw std::runtime_error("In read compressed file: '"s + filename +
+                               "' needs zstd support (OPT_COMMON_WITH_ZSTD)");
+#endif
+    }
+  }
+  return line;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__COMPRESSED_FILE__HPP
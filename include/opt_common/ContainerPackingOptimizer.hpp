@@ -0,0 +1,210 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__CONTAINER_PACKING_OPTIMIZER__HPP
+#define __OPT_COMMON__CONTAINER_PACKING_OPTIMIZER__HPP
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <opt_common/InfrastructureConfiguration.hpp>
+#include <opt_common/MachineLearningModel.hpp>
+#include <opt_common/helper.hpp>
+#include <string>
+#include <vector>
+
+namespace opt_common {
+
+/*! Search the cheapest way to provide a number of executor cores.
+    Every combination of container type and executor shape is a point of the
+    grid; the grid is stored as structure of arrays so that the evaluation of
+    all the points is a plain loop the compiler can vectorize.
+ */
+class ContainerPackingOptimizer {
+ public:
+  struct ContainerType {
+    std::string name;
+    float memory;
+    unsigned cores;
+    double cost;  // Cost of one container
+  };
+
+  struct ExecutorShape {
+    float memory;
+    unsigned cores;
+  };
+
+  struct Packing {
+    ContainerType container_type;
+    ExecutorShape executor_shape;
+    unsigned n_executors;
+    unsigned n_containers;
+    double cost;
+
+    //! \return the configuration to use with the rest of the library
+    InfrastructureConfiguration get_infrastructure_configuration() const {
+      return InfrastructureConfiguration(
+          container_type.memory, executor_shape.memory, container_type.cores,
+          executor_shape.cores);
+    }
+  };
+
+  ContainerPackingOptimizer() = default;
+
+  void add_container_type(ContainerType container_type);
+
+  void add_executor_shape(ExecutorShape executor_shape);
+
+  //! Add all the shapes in the cartesian product of cores and memories
+  void add_executor_shapes(const std::vector<unsigned>& executor_cores,
+                           const std::vector<float>& executor_memories);
+
+  /*! \return the cheapest packing providing at least `n_required_cores`
+      executor cores.
+      \note Executors cannot be split across containers, so the number of
+            containers can be greater than the one computed by
+            InfrastructureConfiguration::get_n_containers.
+   */
+  Packing find_cheapest_packing(unsigned n_required_cores) const;
+
+  //! \return the cheapest packing meeting the deadline according to `mlm`
+  Packing find_cheapest_packing(const MachineLearningModel& mlm,
+                                const TimeInstant& deadline) const;
+
+ private:
+  std::vector<ContainerType> m_container_types;
+  std::vector<ExecutorShape> m_executor_shapes;
+
+  // Grid (structure of arrays) of the feasible combinations
+  std::vector<std::size_t> m_grid_type_index;
+  std::vector<std::size_t> m_grid_shape_index;
+  std::vector<double> m_grid_executor_cores;
+  std::vector<double> m_grid_executors_per_container;
+  std::vector<double> m_grid_container_cost;
+
+  void add_grid_point(std::size_t type_index, std::size_t shape_index);
+};
+
+inline void ContainerPackingOptimizer::add_container_type(
+    ContainerType container_type) {
+  m_container_types.push_back(std::move(container_type));
+  for (std::size_t s = 0; s < m_executor_shapes.size(); ++s) {
+    add_grid_point(m_container_types.size() - 1, s);
+  }
+}
+
+inline void ContainerPackingOptimizer::add_executor_shape(
+    ExecutorShape executor_shape) {
+  m_executor_shapes.push_back(executor_shape);
+  for (std::size_t t = 0; t < m_container_types.size(); ++t) {
+    add_grid_point(t, m_executor_shapes.size() - 1);
+  }
+}
+
+inline void ContainerPackingOptimizer::add_executor_shapes(
+    const std::vector<unsigned>& executor_cores,
+    const std::vector<float>& executor_memories) {
+  for (const auto cores : executor_cores) {
+    for (const auto memory : executor_memories) {
+      add_executor_shape(ExecutorShape{memory, cores});
+    }
+  }
+}
+
+inline void ContainerPackingOptimizer::add_grid_point(std::size_t type_index,
+                                                      std::size_t shape_index) {
+  const ContainerType& type = m_container_types[type_index];
+  const ExecutorShape& shape = m_executor_shapes[shape_index];
+  if (shape.cores == 0 || shape.memory <= 0) {
+    THROW_RUNTIME_ERROR("In container packing: invalid executor shape");
+  }
+
+  // How many executors fit in one container (limited by cores and memory)
+  const auto executors_per_container =
+      std::min(std::floor(type.memory / shape.memory),
+               std::floor(static_cast<float>(type.cores) / shape.cores));
+  if (executors_per_container < 1) {
+    // The executor does not fit in this container type
+    return;
+  }
+
+  m_grid_type_index.push_back(type_index);
+  m_grid_shape_index.push_back(shape_index);
+  m_grid_executor_cores.push_back(shape.cores);
+  m_grid_executors_per_container.push_back(executors_per_container);
+  m_grid_container_cost.push_back(type.cost);
+}
+
+inline ContainerPackingOptimizer::Packing
+ContainerPackingOptimizer::find_cheapest_packing(
+    unsigned n_required_cores) const {
+  const std::size_t grid_size = m_grid_container_cost.size();
+  if (grid_size == 0) {
+    THROW_RUNTIME_ERROR(
+        "In container packing: no executor shape fits in any container type");
+  }
+
+  const double required_cores = n_required_cores;
+  const double* const executor_cores = m_grid_executor_cores.data();
+  const double* const executors_per_container =
+      m_grid_executors_per_container.data();
+  const double* const container_cost = m_grid_container_cost.data();
+
+  // Evaluate the whole grid (branch-free, so it is vectorized)
+  std::vector<double> costs(grid_size);
+  for (std::size_t i = 0; i < grid_size; ++i) {
+    const double executors = std::ceil(required_cores / executor_cores[i]);
+    const double containers =
+        std::ceil(executors / executors_per_container[i]);
+    costs[i] = containers * container_cost[i];
+  }
+
+  const auto best = compute_min_get_index(costs);
+
+  const ContainerType& type = m_container_types[m_grid_type_index[best]];
+  const ExecutorShape& shape = m_executor_shapes[m_grid_shape_index[best]];
+  const auto n_executors = static_cast<unsigned>(
+      std::ceil(required_cores / executor_cores[best]));
+  const auto n_containers = static_cast<unsigned>(
+      std::ceil(n_executors / executors_per_container[best]));
+
+  return Packing{type, shape, n_executors, n_containers, costs[best]};
+}
+
+inline ContainerPackingOptimizer::Packing
+ContainerPackingOptimizer::find_cheapest_packing(
+    const MachineLearningModel& mlm, const TimeInstant& deadline) const {
+  const double deadline_ms = deadline.to_milliseconds();
+  const double slack_ms = deadline_ms - mlm.get_chi_0();
+  if (!(slack_ms > 0)) {
+    THROW_RUNTIME_ERROR(
+        "In container packing: deadline cannot be met by the model");
+  }
+
+  // Invert the model: deadline = chi_0 + chi_c / n
+  const double n_cores = std::ceil(mlm.get_chi_c() / slack_ms);
+  if (!(n_cores <= std::numeric_limits<unsigned>::max())) {
+    THROW_RUNTIME_ERROR(
+        "In container packing: the model needs too many cores for the "
+        "deadline");
+  }
+  return find_cheapest_packing(
+      n_cores < 1 ? 1u : static_cast<unsigned>(n_cores));
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__CONTAINER_PACKING_OPTIMIZER__HPP
@@ -0,0 +1,334 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__CSV_SCHEMA__HPP
+#define __OPT_COMMON__CSV_SCHEMA__HPP
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <opt_common/helper.hpp>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace opt_common {
+
+//! A column of a CSV schema
+struct CsvColumn {
+  const char* name;
+
+  //! Position of the column when the header has not its name (the traces
+  //! written before the columns were looked up by name)
+  std::size_t legacy_index;
+};
+
+/*! \return true if two names of columns are the same, ignoring the case and
+    the characters which are not alphanumeric (e.g. "Stage ID" and
+    "stage_id" are the same name)
+ */
+inline bool csv_column_name_equal(std::string_view lhs,
+                                  std::string_view rhs) noexcept {
+  const auto is_name_char = [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0;
+  };
+
+  auto lhs_it = lhs.cbegin(), rhs_it = rhs.cbegin();
+  while (true) {
+    lhs_it = std::find_if(lhs_it, lhs.cend(), is_name_char);
+    rhs_it = std::find_if(rhs_it, rhs.cend(), is_name_char);
+    if (lhs_it == lhs.cend() || rhs_it == rhs.cend()) {
+      return lhs_it == lhs.cend() && rhs_it == rhs.cend();
+    }
+    if (std::tolower(static_cast<unsigned char>(*lhs_it)) !=
+        std::tolower(static_cast<unsigned char>(*rhs_it))) {
+      return false;
+    }
+    ++lhs_it;
+    ++rhs_it;
+  }
+}
+
+/*! Split the first `max_fields` values of a line of a CSV file (the values
+    are separated as in parse_csv_line). The values are views on `line`.
+    The buffer is not cleared, so the caller can reuse its capacity.
+ */
+inline void split_csv_fields(std::string_view line, std::size_t max_fields,
+                             std::vector<std::string_view>* fields) {
+  line = trim_view(line, " \r");
+  while (line.empty() == false && fields->size() < max_fields) {
+    std::string_view::size_type index_sep;
+    if (line.front() == '"') {
+      index_sep = line.find(',', line.find('"', 1));
+    } else {
+      index_sep = line.find(',');
+    }
+
+    fields->push_back(trim_view(line.substr(0, index_sep), " \r"));
+    if (index_sep == std::string_view::npos) {
+      break;
+    }
+    line = trim_view(line.substr(index_sep + 1), " \r");
+  }
+}
+
+//! Decode a value of a CSV file into its typed destination
+//! \return false if the value is malformed
+template <typename T>
+bool decode_csv_field(std::string_view field, T* output) noexcept {
+  static_assert(std::is_integral<T>::value,
+                "CSV fields are decoded as integers or views");
+  return parse_number(field, output);
+}
+
+//! The raw value, for the fields the caller decodes itself
+inline bool decode_csv_field(std::string_view field,
+                             std::string_view* output) noexcept {
+  *output = field;
+  return true;
+}
+
+/*! Decoder of the rows of a CSV file into typed fields.
+    The columns are bound to the names in the header once per file, then
+    each row is split only up to the last bound column and each value is
+    parsed straight into its destination (no string is allocated).
+    If the header has none of the names, the columns keep their legacy
+    positions, so the traces without names are read as before; a header
+    with some of the names must have all of them.
+ */
+template <typename... Fields>
+class CsvRowDecoder {
+ public:
+  static constexpr std::size_t NUMBER_OF_COLUMNS = sizeof...(Fields);
+
+  /*! If `check_row_size`, each row must have as many values as the
+      header (as the schemas with a fixed number of columns)
+   */
+  explicit CsvRowDecoder(
+      const std::array<CsvColumn, NUMBER_OF_COLUMNS>& columns,
+      bool check_row_size = false);
+
+  /*! Bind the columns to the header line of a file.
+      \return false if the header has some names of the columns but not all
+      of them (see get_error)
+   */
+  bool bind_header(std::string_view header_line);
+
+  //! \return the position in the rows of the column `column`
+  std::size_t get_column_index(std::size_t column) const noexcept {
+    return m_indices[column];
+  }
+
+  /*! Decode a row into the fields (in the order of the columns).
+      \return false if a column is missing, its value is malformed or the
+      row has not the size of the header (see get_error)
+   */
+  bool decode(std::string_view line, Fields*... outputs);
+
+  //! \return the description of the last header or row which could not be
+  //! decoded
+  std::string get_error() const;
+
+ private:
+  enum class Failure { MISSING_NAME, MISSING_VALUE, INVALID_VALUE, ROW_SIZE };
+
+  std::array<CsvColumn, NUMBER_OF_COLUMNS> m_columns;
+  std::array<std::size_t, NUMBER_OF_COLUMNS> m_indices;
+  std::size_t m_number_of_fields;  // Values to split in each row
+
+  bool m_check_row_size;
+  std::size_t m_header_size = 0;  // 0 until a header is bound
+
+  std::vector<std::string_view> m_fields;  // Buffer reused for each row
+
+  Failure m_failure = Failure::MISSING_VALUE;
+  std::size_t m_failed_column = 0;
+  std::string m_failed_value;
+
+  template <std::size_t... Columns>
+  bool decode_fields(std::index_sequence<Columns...>, Fields*... outputs);
+
+  template <typename T>
+  bool decode_column(std::size_t column, T* output);
+
+  void update_number_of_fields() noexcept;
+};
+
+template <typename... Fields>
+inline CsvRowDecoder<Fields...>::CsvRowDecoder(
+    const std::array<CsvColumn, NUMBER_OF_COLUMNS>& columns,
+    bool check_row_size)
+    : m_columns(columns), m_check_row_size(check_row_size) {
+  for (std::size_t i = 0; i < NUMBER_OF_COLUMNS; ++i) {
+    m_indices[i] = m_columns[i].legacy_index;
+  }
+  update_number_of_fields();
+}
+
+template <typename... Fields>
+inline bool CsvRowDecoder<Fields...>::bind_header(
+    std::string_view header_line) {
+  std::vector<std::string_view> names;
+  split_csv_fields(header_line, header_line.size(), &names);
+  m_header_size = names.size();
+
+  std::size_t number_of_found = 0;
+  std::size_t missing_column = 0;
+  for (std::size_t i = 0; i < NUMBER_OF_COLUMNS; ++i) {
+    const auto finder =
+        std::find_if(names.cbegin(), names.cend(), [&](std::string_view name) {
+          return csv_column_name_equal(trim_view(name, " \""),
+                                       m_columns[i].name);
+        });
+    if (finder != names.cend()) {
+      m_indices[i] = static_cast<std::size_t>(finder - names.cbegin());
+      ++number_of_found;
+    } else {
+      m_indices[i] = m_columns[i].legacy_index;
+      missing_column = i;
+    }
+  }
+  update_number_of_fields();
+
+  // A header of another schema: its positions mean something else
+  if (number_of_found != 0 && number_of_found != NUMBER_OF_COLUMNS) {
+    m_failure = Failure::MISSING_NAME;
+    m_failed_column = missing_column;
+    return false;
+  }
+  return true;
+}
+
+template <typename... Fields>
+inline bool CsvRowDecoder<Fields...>::decode(std::string_view line,
+                                             Fields*... outputs) {
+  m_fields.clear();
+  if (m_check_row_size && m_header_size != 0) {
+    // One more value than the header to detect the longer rows
+    split_csv_fields(line, std::max(m_number_of_fields, m_header_size + 1),
+                     &m_fields);
+    if (m_fields.size() != m_header_size) {
+      m_failure = Failure::ROW_SIZE;
+      return false;
+    }
+  } else {
+    split_csv_fields(line, m_number_of_fields, &m_fields);
+  }
+  return decode_fields(std::index_sequence_for<Fields...>(), outputs...);
+}
+
+template <typename... Fields>
+template <std::size_t... Columns>
+inline bool CsvRowDecoder<Fields...>::decode_fields(
+    std::index_sequence<Columns...>, Fields*... outputs) {
+  // Stop at the first column which cannot be decoded
+  return (decode_column(Columns, outputs) && ...);
+}
+
+template <typename... Fields>
+template <typename T>
+inline bool CsvRowDecoder<Fields...>::decode_column(std::size_t column,
+                                                    T* output) {
+  const std::size_t index = m_indices[column];
+  if (index < m_fields.size() && decode_csv_field(m_fields[index], output)) {
+    return true;
+  }
+
+  m_failed_column = column;
+  if (index >= m_fields.size()) {
+    m_failure = Failure::MISSING_VALUE;
+    m_failed_value.clear();
+  } else {
+    m_failure = Failure::INVALID_VALUE;
+    m_failed_value = std::string(m_fields[index]);
+  }
+  return false;
+}
+
+template <typename... Fields>
+inline std::string CsvRowDecoder<Fields...>::get_error() const {
+  const std::string name = m_columns[m_failed_column].name;
+  switch (m_failure) {
+    case Failure::MISSING_NAME:
+      return "has a header without the column '" + name + "'";
+    case Failure::MISSING_VALUE:
+      return "has a row without the column '" + name + "'";
+    case Failure::ROW_SIZE:
+      return "has different number of cols";
+    case Failure::INVALID_VALUE:
+      break;
+  }
+  return "has an invalid " + name + " '" + m_failed_value + "'";
+}
+
+template <typename... Fields>
+inline void CsvRowDecoder<Fields...>::update_number_of_fields() noexcept {
+  m_number_of_fields = 0;
+  for (const auto index : m_indices) {
+    m_number_of_fields = std::max(m_number_of_fields, index + 1);
+  }
+}
+
+/*! Call `handle_row(std::string_view)` for each row of a CSV file from the
+    byte `*offset` (see for_each_line_from_offset), after binding `decoder`
+    to the header of the file. The header (the first row) and the empty rows
+    are not handled.
+    `offset` is moved after the last row read.
+    \return the number of rows handled (0 if only the header or empty rows
+    have been appended)
+    \throw std::runtime_error if the header cannot be bound
+ */
+template <typename Decoder, typename Function>
+std::size_t for_each_csv_row_from_offset(const std::string& csv_namefile,
+                                         std::uint64_t* offset,
+                                         Decoder* decoder,
+                                         Function handle_row,
+                                         bool read_incomplete_row = false) {
+  using namespace std::string_literals;
+
+  const auto bind_header = [&](std::string_view header_line) {
+    if (decoder->bind_header(header_line) == false) {
+      THROW_RUNTIME_ERROR("In read CSV file: file '"s + csv_namefile + "' " +
+                          decoder->get_error());
+    }
+  };
+
+  bool header = (*offset == 0);
+  if (header == false) {
+    bind_header(read_first_line(csv_namefile));
+  }
+
+  std::size_t n_rows = 0;
+  *offset = for_each_line_from_offset(
+      csv_namefile, *offset,
+      [&](std::string_view line) {
+        if (header) {
+          bind_header(line);
+          header = false;
+        } else if (trim_view(line, " \r").empty() == false) {
+          handle_row(line);
+          ++n_rows;
+        }
+      },
+      read_incomplete_row);
+  return n_rows;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__CSV_SCHEMA__HPP
@@ -0,0 +1,400 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__ESTIMATOR_BENCHMARK__HPP
+#define __OPT_COMMON__ESTIMATOR_BENCHMARK__HPP
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <opt_common/Application.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <opt_common/helper.hpp>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace opt_common {
+
+//! A trace of the corpus, with the number of cores it has run on
+struct BenchmarkTrace {
+  std::string data_input_namefile;
+  unsigned recorded_cores;
+};
+
+/*! Read the traces of a corpus: each line of the manifest is the input file
+    of an application and the number of cores of its run. The empty lines
+    and the lines starting with '#' are skipped.
+ */
+inline std::vector<BenchmarkTrace> read_benchmark_manifest(
+    const std::string& manifest_namefile) {
+  using namespace std::string_literals;
+
+  std::vector<BenchmarkTrace> corpus;
+  for_each_line(manifest_namefile, [&](std::string_view line) {
+    line = trim_view(line, " \t\r");
+    if (line.empty() || line.front() == '#') {
+      return;
+    }
+
+    const auto index_sep = line.find_first_of(" \t");
+    BenchmarkTrace trace;
+    if (index_sep == std::string_view::npos ||
+        parse_number(trim_view(line.substr(index_sep), " \t"),
+                     &trace.recorded_cores) == false ||
+        trace.recorded_cores == 0) {
+      THROW_RUNTIME_ERROR("In benchmark manifest: file '"s +
+                          manifest_namefile + "' has an invalid line '" +
+                          std::string(line) + "'");
+    }
+    trace.data_input_namefile = std::string(line.substr(0, index_sep));
+    corpus.push_back(std::move(trace));
+  });
+  return corpus;
+}
+
+struct EstimatorBenchmarkOptions {
+  //! Number of cores alpha and beta are fitted on (not fitted if equal)
+  unsigned alpha_beta_n1 = 0;
+  unsigned alpha_beta_n2 = 0;
+
+  //! Calls of each estimator per trace, to time the cheap ones
+  unsigned repetitions = 100;
+};
+
+/*! Accuracy and cost of the estimators of the execution time on a corpus
+    of traces, against the real execution time of each trace.
+    The traces are loaded and evaluated concurrently (one task per trace);
+    the estimators must only read the application.
+ */
+class EstimatorBenchmark {
+ public:
+  //! \return the estimated time in milliseconds (not positive if the
+  //! estimator is not available for the application; an exception counts
+  //! as unavailable too)
+  using Estimator =
+      std::function<double(const Application& app, unsigned n_cores)>;
+
+  //! Load an application (e.g. with Application::create_application)
+  using Loader = std::function<Application(const std::string& namefile)>;
+
+  struct TraceError {
+    std::string data_input_namefile;
+    std::string error;
+  };
+
+  struct EstimatorStatistics {
+    std::string name;
+
+    std::size_t number_of_samples = 0;
+
+    //! Not positive estimates and failed calls
+    std::size_t number_of_unavailable = 0;
+
+    // Absolute percentage errors (100 is a time twice or zero times the
+    // real one)
+    double mape = 0;
+    double median_error = 0;
+    double p95_error = 0;
+    double max_error = 0;
+
+    //! Mean of (estimate - real) / real: positive if it overestimates
+    double mean_bias = 0;
+
+    //! Average time of a call of the estimator (on the traces where it
+    //! did not fail)
+    double runtime_ns = 0;
+
+    //! Traces where the estimator threw
+    std::vector<TraceError> errors;
+  };
+
+  struct Report {
+    std::vector<EstimatorStatistics> estimators;  // In the order of addition
+
+    std::size_t number_of_traces = 0;
+
+    //! Traces of applications still running (no real execution time)
+    std::size_t number_of_skipped = 0;
+
+    //! Traces which could not be loaded
+    std::vector<TraceError> errors;
+
+    //! \return the fastest estimator with MAPE at most `max_mape` (nullptr
+    //! if none is accurate enough)
+    const EstimatorStatistics* get_cheapest_estimator(double max_mape) const;
+
+    void print_dump_on_stream(std::ostream* os) const;
+  };
+
+  /*! A benchmark of the estimators of the library: "analytic"
+      (Application::compute_avg_execution_time), "alpha_beta" (alpha / n +
+      beta, if fitted) and "machine_learning" (MachineLearningModel)
+   */
+  explicit EstimatorBenchmark(
+      const EstimatorBenchmarkOptions& options = EstimatorBenchmarkOptions());
+
+  void add_estimator(std::string name, Estimator estimator);
+
+  /*! \return the report of all the estimators on `corpus`. The traces
+      are evaluated concurrently on `scheduler` or, if it is nullptr, one at
+      a time on the calling thread.
+   */
+  Report run(const std::vector<BenchmarkTrace>& corpus, const Loader& load,
+             WorkStealingScheduler* scheduler) const;
+
+ private:
+  EstimatorBenchmarkOptions m_options;
+  std::vector<std::pair<std::string, Estimator>> m_estimators;
+
+  //! The evaluation of the estimators on one trace: once the trace is
+  //! loaded, there is an entry per estimator (NaN if the estimator threw)
+  struct TraceResult {
+    bool loaded = false;
+    double real_time = 0;                       // 0 if still running
+    std::vector<double> estimates;              // Per estimator
+    std::vector<double> runtimes_ns;            // Per estimator
+    std::vector<std::string> estimator_errors;  // Per estimator
+    std::string error;
+  };
+
+  void evaluate_trace(const BenchmarkTrace& trace, const Loader& load,
+                      TraceResult* result) const;
+};
+
+inline EstimatorBenchmark::EstimatorBenchmark(
+    const EstimatorBenchmarkOptions& options)
+    : m_options(options) {
+  if (m_options.repetitions == 0) {
+    THROW_RUNTIME_ERROR("In estimator benchmark: no repetitions");
+  }
+
+  add_estimator("analytic", [](const Application& app, unsigned n_cores) {
+    return app.compute_avg_execution_time(n_cores).to_milliseconds();
+  });
+  add_estimator("alpha_beta", [](const Application& app, unsigned n_cores) {
+    if (app.get_alpha() == 0 && app.get_beta() == 0) {
+      // Not fitted
+      return 0.0;
+    }
+    return app.get_alpha() / n_cores + app.get_beta();
+  });
+  add_estimator("machine_learning",
+                [](const Application& app, unsigned n_cores) {
+                  return app.get_machine_learning_model().evaluateModel(
+                      n_cores);
+                });
+}
+
+inline void EstimatorBenchmark::add_estimator(std::string name,
+                                              Estimator estimator) {
+  if (!estimator) {
+    THROW_RUNTIME_ERROR("In estimator benchmark: missing estimator '" + name +
+                        "'");
+  }
+  m_estimators.emplace_back(std::move(name), std::move(estimator));
+}
+
+inline void EstimatorBenchmark::evaluate_trace(const BenchmarkTrace& trace,
+                                               const Loader& load,
+                                               TraceResult* result) const {
+  Application app = load(trace.data_input_namefile);
+  if (m_options.alpha_beta_n1 != m_options.alpha_beta_n2) {
+    app.set_alpha_beta(m_options.alpha_beta_n1, m_options.alpha_beta_n2);
+  }
+  result->loaded = true;
+  result->real_time = app.get_real_execution_time().to_milliseconds();
+  if (!(result->real_time > 0)) {
+    return;
+  }
+
+  const double unavailable = std::numeric_limits<double>::quiet_NaN();
+  result->estimates.assign(m_estimators.size(), unavailable);
+  result->runtimes_ns.assign(m_estimators.size(), unavailable);
+  result->estimator_errors.assign(m_estimators.size(), std::string());
+  for (std::size_t e = 0; e < m_estimators.size(); ++e) {
+    const Estimator& estimator = m_estimators[e].second;
+
+    // The result of the first call, the time of all the calls
+    try {
+      double estimate = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (unsigned i = 0; i < m_options.repetitions; ++i) {
+        const double value = estimator(app, trace.recorded_cores);
+        if (i == 0) {
+          estimate = value;
+        }
+      }
+      const std::chrono::duration<double, std::nano> elapsed =
+          std::chrono::steady_clock::now() - start;
+
+      result->estimates[e] = estimate;
+      result->runtimes_ns[e] = elapsed.count() / m_options.repetitions;
+    } catch (const std::exception& err) {
+      result->estimator_errors[e] = err.what();
+    } catch (...) {
+      result->estimator_errors[e] = "unknown error";
+    }
+  }
+}
+
+inline EstimatorBenchmark::Report EstimatorBenchmark::run(
+    const std::vector<BenchmarkTrace>& corpus, const Loader& load,
+    WorkStealingScheduler* scheduler) const {
+  std::vector<TraceResult> results(corpus.size());
+
+  // Each call writes only the result of its trace
+  const auto evaluate = [&](std::size_t i) {
+    try {
+      evaluate_trace(corpus[i], load, &results[i]);
+    } catch (const std::exception& err) {
+      results[i].error = err.what();
+    } catch (...) {
+      results[i].error = "unknown error";
+    }
+  };
+
+  if (scheduler == nullptr) {
+    for (std::size_t i = 0; i < corpus.size(); ++i) {
+      evaluate(i);
+    }
+  } else {
+    WorkStealingScheduler::TaskGroup group(scheduler);
+    for (std::size_t i = 0; i < corpus.size(); ++i) {
+      group.spawn([&evaluate, i]() { evaluate(i); });
+    }
+    group.wait();
+  }
+
+  Report report;
+  report.number_of_traces = corpus.size();
+  for (std::size_t i = 0; i < corpus.size(); ++i) {
+    if (results[i].loaded == false) {
+      report.errors.push_back(
+          TraceError{corpus[i].data_input_namefile, results[i].error});
+    } else if (!(results[i].real_time > 0)) {
+      ++report.number_of_skipped;
+    }
+  }
+
+  for (std::size_t e = 0; e < m_estimators.size(); ++e) {
+    EstimatorStatistics statistics;
+    statistics.name = m_estimators[e].first;
+
+    std::vector<double> errors;
+    double sum_bias = 0, sum_runtime = 0;
+    std::size_t number_of_timed = 0;
+    for (std::size_t i = 0; i < corpus.size(); ++i) {
+      const TraceResult& result = results[i];
+      if (result.estimates.empty()) {
+        continue;
+      }
+      if (result.estimator_errors[e].empty() == false) {
+        statistics.errors.push_back(TraceError{
+            corpus[i].data_input_namefile, result.estimator_errors[e]});
+      } else {
+        sum_runtime += result.runtimes_ns[e];
+        ++number_of_timed;
+      }
+
+      const double estimate = result.estimates[e];
+      if (!(estimate > 0) || !std::isfinite(estimate)) {
+        ++statistics.number_of_unavailable;
+        continue;
+      }
+      const double relative_error =
+          (estimate - result.real_time) / result.real_time;
+      errors.push_back(std::abs(relative_error) * 100);
+      sum_bias += relative_error * 100;
+    }
+
+    if (number_of_timed > 0) {
+      statistics.runtime_ns = sum_runtime / number_of_timed;
+    }
+
+    statistics.number_of_samples = errors.size();
+    if (errors.empty() == false) {
+      std::sort(errors.begin(), errors.end());
+
+      // Nearest-rank percentile
+      const auto percentile = [&errors](double p) {
+        const auto rank = static_cast<std::size_t>(
+            std::ceil(p / 100 * static_cast<double>(errors.size())));
+        return errors[std::max<std::size_t>(rank, 1) - 1];
+      };
+
+      double sum_errors = 0;
+      for (const double error : errors) {
+        sum_errors += error;
+      }
+      statistics.mape = sum_errors / errors.size();
+      statistics.median_error = percentile(50);
+      statistics.p95_error = percentile(95);
+      statistics.max_error = errors.back();
+      statistics.mean_bias = sum_bias / errors.size();
+    }
+
+    report.estimators.push_back(std::move(statistics));
+  }
+
+  return report;
+}
+
+inline const EstimatorBenchmark::EstimatorStatistics*
+EstimatorBenchmark::Report::get_cheapest_estimator(double max_mape) const {
+  const EstimatorStatistics* cheapest = nullptr;
+  for (const EstimatorStatistics& statistics : estimators) {
+    if (statistics.number_of_samples == 0 || statistics.mape > max_mape) {
+      continue;
+    }
+    if (cheapest == nullptr || statistics.runtime_ns < cheapest->runtime_ns) {
+      cheapest = &statistics;
+    }
+  }
+  return cheapest;
+}
+
+inline void EstimatorBenchmark::Report::print_dump_on_stream(
+    std::ostream* os) const {
+  *os << "Traces: " << number_of_traces << " (skipped " << number_of_skipped
+      << ", errors " << errors.size() << ")\n";
+  for (const TraceError& error : errors) {
+    *os << "  " << error.data_input_namefile << ": " << error.error << "\n";
+  }
+
+  *os << "Estimator samples unavailable MAPE% p50% p95% max% bias% ns/call\n";
+  for (const EstimatorStatistics& statistics : estimators) {
+    *os << statistics.name << " " << statistics.number_of_samples << " "
+        << statistics.number_of_unavailable << " " << statistics.mape << " "
+        << statistics.median_error << " " << statistics.p95_error << " "
+        << statistics.max_error << " " << statistics.mean_bias << " "
+        << statistics.runtime_ns << "\n";
+  }
+  for (const EstimatorStatistics& statistics : estimators) {
+    for (const TraceError& error : statistics.errors) {
+      *os << "  " << statistics.name << " on " << error.data_input_namefile
+          << ": " << error.error << "\n";
+    }
+  }
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__ESTIMATOR_BENCHMARK__HPP
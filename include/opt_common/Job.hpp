@@ -16,8 +16,10 @@ limitations under the License.
 
 #ifndef __OPT_COMMON__JOB__HPP
 #define __OPT_COMMON__JOB__HPP
+#include <algorithm>
 #include <cstdint>
 #include <map>
+#include <memory_resource>
 #include <opt_common/Stage.hpp>
 #include <opt_common/helper.hpp>
 
@@ -26,8 +28,19 @@ namespace opt_common {
 class Job {
  public:
   using JobID = std::uint64_t;
+  using allocator_type = std::pmr::polymorphic_allocator<Stage::StageID>;
 
-  Job(JobID job_id, TimeInstant submission_time, TimeInstant completion_time);
+  Job(JobID job_id, TimeInstant submission_time, TimeInstant completion_time,
+      const allocator_type& allocator = {});
+
+  //! Allocator-extended constructors (used by std::pmr containers)
+  Job(const Job& other, const allocator_type& allocator);
+  Job(Job&& other, const allocator_type& allocator);
+
+  Job(const Job&) = default;
+  Job(Job&&) = default;
+  Job& operator=(const Job&) = default;
+  Job& operator=(Job&&) = default;
 
   const JobID& get_jobID() const noexcept { return m_job_id; }
 
@@ -39,21 +52,54 @@ class Job {
     return m_completion_time;
   }
 
-  void set_id_stages(std::set<Stage::StageID> id_stages) {
-    m_id_stages = std::move(id_stages);
+  void set_id_stages(const std::set<Stage::StageID>& id_stages) {
+    m_id_stages.assign(id_stages.cbegin(), id_stages.cend());
+  }
+
+  //! The IDs are sorted and duplicates are removed
+  void set_id_stages(const std::vector<Stage::StageID>& id_stages) {
+    set_id_stages(id_stages.cbegin(), id_stages.cend());
+  }
+
+  //! The IDs are sorted and duplicates are removed
+  template <typename InputIt>
+  void set_id_stages(InputIt first, InputIt last) {
+    m_id_stages.assign(first, last);
+    std::sort(m_id_stages.begin(), m_id_stages.end());
+    m_id_stages.erase(std::unique(m_id_stages.begin(), m_id_stages.end()),
+                      m_id_stages.end());
+  }
+
+  //! \return the sorted IDs of the stages belonging to this job
+  const std::pmr::vector<Stage::StageID>& get_id_stages() const noexcept {
+    return m_id_stages;
   }
 
  private:
   JobID m_job_id;
   TimeInstant m_submission_time;
   TimeInstant m_completion_time;
-  std::set<Stage::StageID> m_id_stages;
+  std::pmr::vector<Stage::StageID> m_id_stages;
 };
 
-inline Job::Job(JobID job_id, TimeInstant submission_time, TimeInstant completion_time)
+inline Job::Job(JobID job_id, TimeInstant submission_time,
+                TimeInstant completion_time, const allocator_type& allocator)
     : m_job_id(std::move(job_id)),
       m_submission_time(std::move(submission_time)),
-      m_completion_time(std::move(completion_time)) {}
+      m_completion_time(std::move(completion_time)),
+      m_id_stages(allocator) {}
+
+inline Job::Job(const Job& other, const allocator_type& allocator)
+    : m_job_id(other.m_job_id),
+      m_submission_time(other.m_submission_time),
+      m_completion_time(other.m_completion_time),
+      m_id_stages(other.m_id_stages, allocator) {}
+
+inline Job::Job(Job&& other, const allocator_type& allocator)
+    : m_job_id(other.m_job_id),
+      m_submission_time(other.m_submission_time),
+      m_completion_time(other.m_completion_time),
+      m_id_stages(std::move(other.m_id_stages), allocator) {}
 }  // namespace opt_common
 
 #endif  // __OPT_COMMON__JOB__HPP
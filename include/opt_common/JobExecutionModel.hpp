@@ -0,0 +1,216 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__JOB_EXECUTION_MODEL__HPP
+#define __OPT_COMMON__JOB_EXECUTION_MODEL__HPP
+#include <algorithm>
+#include <cstdint>
+#include <opt_common/Application.hpp>
+#include <opt_common/Job.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <opt_common/helper.hpp>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace opt_common {
+
+/*! Estimate of the execution time of an application job by job.
+    A job takes (waves * average task time) for each of its stages, as in
+    Application::compute_avg_execution_time. The jobs submitted while
+    others were running in the trace share the cores with them, so their
+    durations add up; between the other jobs the driver idles for the gap
+    recorded in the trace, which does not depend on the cores. The time of
+    the run outside the jobs (e.g. the start of the driver) is added too.
+    A stage listed by several jobs (e.g. a skipped stage) runs in the first
+    one; the stages of no job run after the jobs.
+    The application is compiled once, then the model does not refer to it.
+ */
+class JobExecutionModel {
+ public:
+  explicit JobExecutionModel(const Application& app);
+
+  //! \return the duration of each job with `n_cores` cores (in the order of
+  //! get_job_ids), computed concurrently on `scheduler` if not nullptr
+  std::vector<TimeInstant> compute_job_durations(
+      unsigned n_cores, WorkStealingScheduler* scheduler = nullptr) const;
+
+  //! \return the execution time of the application with `n_cores` cores
+  TimeInstant compute_execution_time(
+      unsigned n_cores, WorkStealingScheduler* scheduler = nullptr) const;
+
+  //! \return the IDs of the jobs, by submission time
+  const std::vector<Job::JobID>& get_job_ids() const noexcept {
+    return m_job_ids;
+  }
+
+  //! \return the time the driver idles between the jobs
+  const TimeInstant& get_jobs_gap() const noexcept { return m_jobs_gap; }
+
+  //! \return the time of the run outside the jobs
+  const TimeInstant& get_driver_overhead() const noexcept {
+    return m_driver_overhead;
+  }
+
+ private:
+  //! Jobs evaluated by a task of the scheduler
+  static constexpr std::size_t JOBS_PER_TASK = 256;
+
+  struct StageCost {
+    std::size_t number_of_tasks;
+    TimeInstant avg_time;
+  };
+
+  std::vector<Job::JobID> m_job_ids;
+
+  // The stages of the job i are [m_first_stage[i], m_first_stage[i + 1])
+  std::vector<StageCost> m_stages;
+  std::vector<std::size_t> m_first_stage;
+
+  std::vector<StageCost> m_stages_without_job;
+
+  TimeInstant m_jobs_gap;
+  TimeInstant m_driver_overhead;
+
+  static TimeInstant compute_stages_time(const StageCost* first,
+                                         const StageCost* last,
+                                         unsigned n_cores) noexcept;
+};
+
+inline JobExecutionModel::JobExecutionModel(const Application& app) {
+  const Application::StagesMap& stages = app.get_all_stages();
+
+  std::vector<const Job*> jobs;
+  jobs.reserve(app.get_all_jobs().size());
+  for (const auto& job_pair : app.get_all_jobs()) {
+    jobs.push_back(&job_pair.second);
+  }
+  std::stable_sort(jobs.begin(), jobs.end(),
+                   [](const Job* lhs, const Job* rhs) {
+                     return lhs->get_submission_time() <
+                            rhs->get_submission_time();
+                   });
+
+  // Assign each stage to the first job listing it
+  std::set<Stage::StageID> assigned_stages;
+  m_first_stage.push_back(0);
+  for (const Job* job : jobs) {
+    m_job_ids.push_back(job->get_jobID());
+    for (const auto stage_id : job->get_id_stages()) {
+      const auto stage_finder = stages.find(stage_id);
+      if (stage_finder != stages.cend() &&
+          assigned_stages.insert(stage_id).second) {
+        const Stage& stage = stage_finder->second;
+        m_stages.push_back(
+            StageCost{stage.get_number_of_tasks(), stage.get_avg_time()});
+      }
+    }
+    m_first_stage.push_back(m_stages.size());
+  }
+
+  for (const auto& stage_pair : stages) {
+    if (assigned_stages.count(stage_pair.first) == 0) {
+      const Stage& stage = stage_pair.second;
+      m_stages_without_job.push_back(
+          StageCost{stage.get_number_of_tasks(), stage.get_avg_time()});
+    }
+  }
+
+  if (jobs.empty()) {
+    return;
+  }
+
+  // A job submitted after the completion of all the previous ones waits
+  // for the driver
+  TimeInstant last_completion = jobs.front()->get_completion_time();
+  for (const Job* job : jobs) {
+    if (job->get_submission_time() > last_completion) {
+      m_jobs_gap += job->get_submission_time() - last_completion;
+    }
+    last_completion = std::max(last_completion, job->get_completion_time());
+  }
+
+  const TimeInstant jobs_span =
+      last_completion - jobs.front()->get_submission_time();
+  if (app.get_real_execution_time() > jobs_span) {
+    m_driver_overhead = app.get_real_execution_time() - jobs_span;
+  }
+}
+
+inline TimeInstant JobExecutionModel::compute_stages_time(
+    const StageCost* first, const StageCost* last, unsigned n_cores) noexcept {
+  TimeInstant time_execution;
+  for (; first != last; ++first) {
+    if (first->number_of_tasks % n_cores != 0) {
+      time_execution += first->avg_time;
+    }
+
+    const TimeInstant::Rep coeff = first->number_of_tasks / n_cores;
+    time_execution += coeff * first->avg_time;
+  }
+  return time_execution;
+}
+
+inline std::vector<TimeInstant> JobExecutionModel::compute_job_durations(
+    unsigned n_cores, WorkStealingScheduler* scheduler) const {
+  if (n_cores == 0) {
+    THROW_RUNTIME_ERROR("In job execution model: no cores");
+  }
+
+  std::vector<TimeInstant> durations(m_job_ids.size());
+  const auto compute_durations = [&](std::size_t first_job,
+                                     std::size_t last_job) {
+    for (std::size_t i = first_job; i < last_job; ++i) {
+      durations[i] = compute_stages_time(m_stages.data() + m_first_stage[i],
+                                         m_stages.data() + m_first_stage[i + 1],
+                                         n_cores);
+    }
+  };
+
+  if (scheduler == nullptr || durations.size() <= JOBS_PER_TASK) {
+    compute_durations(0, durations.size());
+    return durations;
+  }
+
+  // Each task writes only the durations of its jobs
+  WorkStealingScheduler::TaskGroup group(scheduler);
+  for (std::size_t first_job = 0; first_job < durations.size();
+       first_job += JOBS_PER_TASK) {
+    group.spawn([&, first_job]() {
+      compute_durations(first_job,
+                        std::min(first_job + JOBS_PER_TASK, durations.size()));
+    });
+  }
+  group.wait();
+  return durations;
+}
+
+inline TimeInstant JobExecutionModel::compute_execution_time(
+    unsigned n_cores, WorkStealingScheduler* scheduler) const {
+  TimeInstant time_execution = m_driver_overhead + m_jobs_gap;
+  for (const TimeInstant& duration :
+       compute_job_durations(n_cores, scheduler)) {
+    time_execution += duration;
+  }
+  time_execution += compute_stages_time(
+      m_stages_without_job.data(),
+      m_stages_without_job.data() + m_stages_without_job.size(), n_cores);
+  return time_execution;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__JOB_EXECUTION_MODEL__HPP
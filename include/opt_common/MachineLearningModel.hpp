@@ -34,9 +34,10 @@ class MachineLearningModel {
   double evaluateModel(unsigned n) const;
 
   // determines the initial number of cores, given the infrastrucutre
-  // configuration and deadline
+  // configuration and deadline (written on `log`, if not nullptr)
   unsigned initial_core_numbers(const InfrastructureConfiguration& ic,
-                                const TimeInstant& deadline) const;
+                                const TimeInstant& deadline,
+                                std::ostream* log = &std::cout) const;
 
   void print() const;
 
@@ -61,7 +62,8 @@ inline double MachineLearningModel::evaluateModel(unsigned n) const {
 }
 
 inline unsigned MachineLearningModel::initial_core_numbers(
-    const InfrastructureConfiguration& ic, const TimeInstant& deadline) const {
+    const InfrastructureConfiguration& ic, const TimeInstant& deadline,
+    std::ostream* log) const {
   // double xi=fmin((double)ic.getContainer_memory()/ic.getExecutor_memory(),
   // (double) ic.getContainter_cores()/ic.getExecutor_cores());
   /* Old Version
@@ -69,12 +71,15 @@ inline unsigned MachineLearningModel::initial_core_numbers(
 
   double n_cores= ic.getExecutor_cores()  * ceil(n_containers);
   */
-  double n_cores = fmax(chi_c / (deadline - chi_0), ic.getContainter_cores());
+  double n_cores = fmax(chi_c / (deadline.to_milliseconds() - chi_0),
+                        ic.getContainter_cores());
 
   // double n_cores= ic.getExecutor_cores()  * ceil(n_containers);
 
-  std::cout << "\n"
-            << "Initial cores number: " << n_cores << std::endl;
+  if (log != nullptr) {
+    *log << "\n"
+         << "Initial cores number: " << n_cores << std::endl;
+  }
 
   return n_cores;
 }
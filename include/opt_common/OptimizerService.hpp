@@ -0,0 +1,473 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__OPTIMIZER_SERVICE__HPP
+#define __OPT_COMMON__OPTIMIZER_SERVICE__HPP
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <istream>
+#include <list>
+#include <map>
+#include <opt_common/Application.hpp>
+#include <opt_common/CommandLineParser.hpp>
+#include <opt_common/configuration.hpp>
+#include <opt_common/helper.hpp>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <thread>
+#endif
+
+namespace opt_common {
+
+/*! Long-running optimizer keeping loaded applications, configurations and
+    computed results in memory between requests.
+    Requests are single lines:
+      optimize INPUT_FILE -f|-b OPTIONS
+      evaluate INPUT_FILE N_CORES [-c CONFIG_FILE]
+      invalidate [INPUT_FILE]
+      stats
+      quit
+    where OPTIONS are the ones of the single application form of the
+    command line (see CommandLineParser::get_usage).
+    Every answer is a single line starting with "OK" or "ERROR"; while a
+    request is served, the standard output is moved to the standard error.
+    An application is loaded again when its input or configuration file
+    changes (size or modification time); the least recently used one is
+    dropped beyond `max_applications`.
+ */
+class OptimizerService {
+ public:
+  /*! The optimization algorithm, provided by the optimizer program.
+      It can update `app` (e.g. alpha/beta), the change is kept for the next
+      requests.
+      \return the answer to send back (on a single line)
+   */
+  using OptimizeFunction = std::function<std::string(
+      Application* app, const CommandLineParser::CommandLineOptions& options)>;
+
+  static constexpr std::size_t DEFAULT_MAX_APPLICATIONS = 16;
+
+  //! `default_config_file` is used by requests without '-c'
+  OptimizerService(std::string default_config_file, OptimizeFunction optimize,
+                   std::size_t max_applications = DEFAULT_MAX_APPLICATIONS);
+
+  //! \return the answer to `request` (errors are reported in the answer)
+  std::string handle_request(const std::string& request);
+
+  //! Serve requests line by line until end of stream or "quit"
+  void serve(std::istream* is, std::ostream* os);
+
+  //! Serve requests on a Unix domain socket (one client at a time)
+  void serve_unix_socket(const std::string& socket_path);
+
+ private:
+  using CacheKey = std::pair<std::string, std::string>;  // Input and config
+
+  //! Size and modification time of a file (as read by get_file_signature)
+  struct FileSignature {
+    std::uintmax_t size;
+    std::filesystem::file_time_type modification_time;
+
+    bool operator==(const FileSignature& other) const {
+      return size == other.size &&
+             modification_time == other.modification_time;
+    }
+  };
+
+  struct CachedConfiguration {
+    FileSignature signature;
+    Configuration configuration;
+  };
+
+  struct CachedApplication {
+    Application app;
+    FileSignature input_signature;
+    FileSignature config_signature;
+    std::list<CacheKey>::iterator recently_used;  // In m_recently_used
+    std::map<std::string, std::string> optimizations;
+    std::map<unsigned, std::string> evaluations;
+  };
+
+  std::string m_default_config_file;
+  OptimizeFunction m_optimize;
+  std::size_t m_max_applications;
+
+  std::map<std::string, CachedConfiguration> m_configurations;
+  std::map<CacheKey, CachedApplication> m_applications;
+  std::list<CacheKey> m_recently_used;  // The most recently used first
+
+  //! Moves the logs on the standard output (e.g. of the loading or of the
+  //! optimization) to the standard error, which is not the answers stream
+  struct RedirectStdout {
+    std::streambuf* const buffer = std::cout.rdbuf(std::cerr.rdbuf());
+    ~RedirectStdout() { std::cout.rdbuf(buffer); }
+  };
+
+  std::size_t m_cache_hits = 0;
+  std::size_t m_cache_misses = 0;
+  bool m_quit = false;
+
+  //! \return the signature of `path` (an invalid one if it cannot be read)
+  static FileSignature get_file_signature(const std::string& path);
+
+  CachedApplication& get_application(const std::string& input_file,
+                                     std::string config_file);
+
+  //! Drop the cached application at `position`
+  void erase_application(std::map<CacheKey, CachedApplication>::iterator
+                             position);
+
+  std::string handle_optimize(const std::vector<std::string>& tokens);
+  std::string handle_evaluate(const std::vector<std::string>& tokens);
+  std::string handle_invalidate(const std::vector<std::string>& tokens);
+  std::string handle_stats() const;
+};
+
+inline OptimizerService::OptimizerService(std::string default_config_file,
+                                          OptimizeFunction optimize,
+                                          std::size_t max_applications)
+    : m_default_config_file(std::move(default_config_file)),
+      m_optimize(std::move(optimize)),
+      m_max_applications(max_applications) {
+  if (m_max_applications == 0) {
+    THROW_RUNTIME_ERROR(
+        "In optimizer service: the cache must hold an application");
+  }
+}
+
+inline std::string OptimizerService::handle_request(
+    const std::string& request) {
+  std::istringstream iss(request);
+  std::vector<std::string> tokens;
+  std::string token;
+  while (iss >> token) {
+    tokens.push_back(std::move(token));
+  }
+
+  if (tokens.empty()) {
+    return "ERROR empty request";
+  }
+
+  RedirectStdout redirect;
+  try {
+    const std::string& command = tokens.front();
+    if (command == "optimize") {
+      return handle_optimize(tokens);
+    } else if (command == "evaluate") {
+      return handle_evaluate(tokens);
+    } else if (command == "invalidate") {
+      return handle_invalidate(tokens);
+    } else if (command == "stats") {
+      return handle_stats();
+    } else if (command == "quit") {
+      m_quit = true;
+      return "OK";
+    }
+    return "ERROR unknown request '" + command + "'";
+  } catch (const std::exception& err) {
+    return std::string("ERROR ") + err.what();
+  }
+}
+
+inline OptimizerService::FileSignature OptimizerService::get_file_signature(
+    const std::string& path) {
+  // On error: size -1 and the minimum time
+  std::error_code error;
+  const auto size = std::filesystem::file_size(path, error);
+  return FileSignature{size, std::filesystem::last_write_time(path, error)};
+}
+
+inline OptimizerService::CachedApplication& OptimizerService::get_application(
+    const std::string& input_file, std::string config_file) {
+  if (config_file.empty()) {
+    config_file = m_default_config_file;
+  }
+  const FileSignature input_signature = get_file_signature(input_file);
+  const FileSignature config_signature = get_file_signature(config_file);
+
+  CacheKey key(input_file, config_file);
+  auto finder = m_applications.find(key);
+  if (finder != m_applications.end()) {
+    if (finder->second.input_signature == input_signature &&
+        finder->second.config_signature == config_signature) {
+      ++m_cache_hits;
+      m_recently_used.splice(m_recently_used.begin(), m_recently_used,
+                             finder->second.recently_used);
+      return finder->second;
+    }
+    erase_application(finder);  // The files have changed
+  }
+  ++m_cache_misses;
+
+  // Read the configuration only the first time it is used (or changed)
+  auto config_finder = m_configurations.find(config_file);
+  if (config_finder == m_configurations.end() ||
+      !(config_finder->second.signature == config_signature)) {
+    CachedConfiguration cached_configuration{config_signature, {}};
+    cached_configuration.configuration.read_configuration_from_file(
+        config_file);
+    config_finder = m_configurations
+                        .insert_or_assign(config_file,
+                                          std::move(cached_configuration))
+                        .first;
+  }
+
+  CachedApplication cached{
+      Application::create_application(input_file,
+                                      config_finder->second.configuration),
+      input_signature,
+      config_signature,
+      {},
+      {},
+      {}};
+
+  // Make room for the new application
+  while (m_applications.size() >= m_max_applications) {
+    erase_application(m_applications.find(m_recently_used.back()));
+  }
+  m_recently_used.push_front(key);
+  cached.recently_used = m_recently_used.begin();
+  return m_applications.emplace(std::move(key), std::move(cached))
+      .first->second;
+}
+
+inline void OptimizerService::erase_application(
+    std::map<CacheKey, CachedApplication>::iterator position) {
+  m_recently_used.erase(position->second.recently_used);
+  m_applications.erase(position);
+}
+
+inline std::string OptimizerService::handle_optimize(
+    const std::vector<std::string>& tokens) {
+  // Reuse the command line syntax (the request name acts as program name)
+  std::vector<char*> argv;
+  for (const auto& token : tokens) {
+    argv.push_back(const_cast<char*>(token.c_str()));
+  }
+  const auto options = CommandLineParser::parse_command_line(
+      static_cast<int>(argv.size()), argv.data());
+
+  CachedApplication& cached =
+      get_application(options.name_of_file, options.config_file);
+
+  // The same optimization is answered from memory
+  std::string memo_key =
+      std::to_string(static_cast<int>(options.optimize_method)) +
+      (options.no_ml ? " no-ml" : "") + (options.hybrid ? " hybrid" : "") +
+      (options.deadline != 0 ? " " + std::to_string(options.deadline) : "");
+  const auto finder = cached.optimizations.find(memo_key);
+  if (finder != cached.optimizations.cend()) {
+    return finder->second;
+  }
+
+  std::string answer;
+  if (options.deadline != 0) {
+    // Another deadline is optimized on a copy (sharing the trace)
+    Application app = cached.app;
+    app.set_deadline(TimeInstant::from_milliseconds(options.deadline));
+    answer = "OK " + m_optimize(&app, options);
+  } else {
+    answer = "OK " + m_optimize(&cached.app, options);
+  }
+  cached.optimizations.emplace(std::move(memo_key), answer);
+  return answer;
+}
+
+inline std::string OptimizerService::handle_evaluate(
+    const std::vector<std::string>& tokens) {
+  if (tokens.size() != 3 && !(tokens.size() == 5 && tokens[3] == "-c")) {
+    return "ERROR usage: evaluate INPUT_FILE N_CORES [-c CONFIG_FILE]";
+  }
+
+  unsigned n_cores;
+  if (parse_number(tokens[2], &n_cores) == false || n_cores == 0) {
+    return "ERROR invalid number of cores '" + tokens[2] + "'";
+  }
+
+  CachedApplication& cached =
+      get_application(tokens[1], tokens.size() == 5 ? tokens[4] : "");
+
+  auto finder = cached.evaluations.find(n_cores);
+  if (finder == cached.evaluations.end()) {
+    std::ostringstream answer;
+    answer << "OK " << cached.app.compute_avg_execution_time(n_cores) << " "
+           << cached.app.get_machine_learning_model().evaluateModel(n_cores);
+    finder = cached.evaluations.emplace(n_cores, answer.str()).first;
+  }
+  return finder->second;
+}
+
+inline std::string OptimizerService::handle_invalidate(
+    const std::vector<std::string>& tokens) {
+  if (tokens.size() == 1) {
+    m_applications.clear();
+    m_recently_used.clear();
+    m_configurations.clear();
+    return "OK";
+  }
+
+  for (auto it = m_applications.begin(); it != m_applications.end();) {
+    if (it->first.first == tokens[1]) {
+      erase_application(it++);
+    } else {
+      ++it;
+    }
+  }
+  return "OK";
+}
+
+inline std::string OptimizerService::handle_stats() const {
+  return "OK applications=" + std::to_string(m_applications.size()) +
+         " hits=" + std::to_string(m_cache_hits) +
+         " misses=" + std::to_string(m_cache_misses);
+}
+
+inline void OptimizerService::serve(std::istream* is, std::ostream* os) {
+  m_quit = false;
+  std::string line;
+  while (!m_quit && std::getline(*is, line)) {
+    *os << handle_request(line) << std::endl;
+  }
+}
+
+inline void OptimizerService::serve_unix_socket(
+    const std::string& socket_path) {
+#if defined(__unix__) || defined(__APPLE__)
+  using namespace std::string_literals;
+
+  sockaddr_un address{};
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    THROW_RUNTIME_ERROR("In optimizer service: socket path too long '"s +
+                        socket_path + "'");
+  }
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  const int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server_fd < 0) {
+    THROW_RUNTIME_ERROR("In optimizer service: cannot create the socket");
+  }
+
+  ::unlink(socket_path.c_str());
+  if (::bind(server_fd, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(server_fd, SOMAXCONN) != 0) {
+    ::close(server_fd);
+    THROW_RUNTIME_ERROR("In optimizer service: cannot listen on '"s +
+                        socket_path + "'");
+  }
+
+  // Write the whole answer (false if the client has gone away)
+  const auto send_answer = [](int client_fd, const std::string& answer) {
+    std::size_t n_written = 0;
+    while (n_written < answer.size()) {
+#ifdef MSG_NOSIGNAL
+      // A closed client must not raise SIGPIPE
+      const auto n = ::send(client_fd, answer.data() + n_written,
+                            answer.size() - n_written, MSG_NOSIGNAL);
+#else
+      const auto n = ::write(client_fd, answer.data() + n_written,
+                             answer.size() - n_written);
+#endif
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;  // EPIPE, ECONNRESET, ...
+      }
+      n_written += n;
+    }
+    return true;
+  };
+
+#ifndef MSG_NOSIGNAL
+  // Without MSG_NOSIGNAL, a write on a closed client raises SIGPIPE
+  ::signal(SIGPIPE, SIG_IGN);
+#endif
+
+  m_quit = false;
+  while (!m_quit) {
+    const int client_fd = ::accept(server_fd, nullptr, nullptr);
+    if (client_fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+          errno == ENOMEM) {
+        // Out of resources: wait for some to be released
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        continue;
+      }
+      const std::string error = std::strerror(errno);
+      ::close(server_fd);
+      ::unlink(socket_path.c_str());
+      THROW_RUNTIME_ERROR("In optimizer service: cannot accept on '"s +
+                          socket_path + "': " + error);
+    }
+
+    // Read the requests of the client line by line
+    std::string pending;
+    char buffer[4096];
+    bool connected = true;
+    while (!m_quit && connected) {
+      const auto n_read = ::read(client_fd, buffer, sizeof(buffer));
+      if (n_read < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n_read <= 0) {
+        break;
+      }
+      pending.append(buffer, n_read);
+
+      std::string::size_type end_line;
+      while (connected && !m_quit &&
+             (end_line = pending.find('\n')) != std::string::npos) {
+        const std::string answer =
+            handle_request(pending.substr(0, end_line)) + "\n";
+        pending.erase(0, end_line + 1);
+        connected = send_answer(client_fd, answer);
+      }
+    }
+
+    ::close(client_fd);
+  }
+
+  ::close(server_fd);
+  ::unlink(socket_path.c_str());
+#else
+  THROW_RUNTIME_ERROR(
+      "In optimizer service: Unix sockets are not supported on this platform");
+#endif
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__OPTIMIZER_SERVICE__HPP
@@ -0,0 +1,159 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__PARALLEL_OPTIMIZER__HPP
+#define __OPT_COMMON__PARALLEL_OPTIMIZER__HPP
+#include <exception>
+#include <functional>
+#include <memory>
+#include <opt_common/Application.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace opt_common {
+
+/*! The steps of the optimization of one application.
+    The steps write on `log`, the log of their application, instead of the
+    standard output (shared by the applications optimized concurrently).
+ */
+struct ApplicationPipeline {
+  //! Load the application (e.g. with Application::create_application)
+  std::function<Application(const std::string& data_input_namefile,
+                            std::ostream* log)>
+      load;
+
+  //! Number of cores alpha and beta are fitted on (not fitted if equal)
+  unsigned alpha_beta_n1 = 0;
+  unsigned alpha_beta_n2 = 0;
+
+  /*! Search the configuration starting from the initial number of cores
+      guessed by the ML model. The simulator runs of the search can be
+      spawned as tasks of a TaskGroup on `scheduler` (which must not write
+      on `log` concurrently).
+      \return the result of the optimization
+   */
+  std::function<std::string(Application* app, unsigned initial_cores,
+                            WorkStealingScheduler* scheduler,
+                            std::ostream* log)>
+      search;
+};
+
+struct PipelineResult {
+  std::string data_input_namefile;
+  std::string result;
+  std::string error;  // Empty if the optimization succeeded
+  std::string log;    // Written by the steps of the application
+};
+
+/*! Optimize many applications concurrently on `scheduler`.
+    Each step of the pipeline of an application is a task that spawns the
+    next step, so the workers move between applications and nested tasks
+    until the last application is completed.
+    An error stops only the application that raised it. Nothing is written
+    on the standard output: the logs of the applications are returned in
+    their results.
+    \return the results in the same order as `data_input_namefiles`
+ */
+inline std::vector<PipelineResult> run_application_pipelines(
+    const std::vector<std::string>& data_input_namefiles,
+    const ApplicationPipeline& pipeline, WorkStealingScheduler* scheduler) {
+  struct ApplicationState {
+    std::unique_ptr<Application> app;
+    unsigned initial_cores = 0;
+    std::ostringstream log;  // The steps of an application run in sequence
+  };
+
+  std::vector<PipelineResult> results(data_input_namefiles.size());
+  std::vector<ApplicationState> states(data_input_namefiles.size());
+
+  WorkStealingScheduler::TaskGroup group(scheduler);
+
+  for (std::size_t i = 0; i < data_input_namefiles.size(); ++i) {
+    results[i].data_input_namefile = data_input_namefiles[i];
+
+    // Run a step, recording its error
+    const auto run_step = [&results, i](const auto& step) {
+      try {
+        step();
+        return true;
+      } catch (const std::exception& err) {
+        results[i].error = err.what();
+      } catch (...) {
+        results[i].error = "unknown error";
+      }
+      return false;
+    };
+
+    // The last step of the application (or the one failing) keeps its log
+    const auto keep_log = [&results, &states, i]() {
+      results[i].log = states[i].log.str();
+      states[i].log = std::ostringstream();
+    };
+
+    group.spawn([&, i, run_step, keep_log]() {
+      // Load
+      const bool loaded = run_step([&]() {
+        states[i].app = std::make_unique<Application>(
+            pipeline.load(data_input_namefiles[i], &states[i].log));
+      });
+      if (!loaded) {
+        keep_log();
+        return;
+      }
+
+      group.spawn([&, i, run_step, keep_log]() {
+        // Fit alpha and beta, and guess the number of cores
+        const bool fitted = run_step([&]() {
+          Application& app = *states[i].app;
+          if (pipeline.alpha_beta_n1 != pipeline.alpha_beta_n2) {
+            app.set_alpha_beta(pipeline.alpha_beta_n1, pipeline.alpha_beta_n2);
+          }
+          states[i].initial_cores =
+              app.get_machine_learning_model().initial_core_numbers(
+                  app.get_infrastructure_config(), app.get_deadline(),
+                  &states[i].log);
+        });
+        if (!fitted) {
+          keep_log();
+          return;
+        }
+
+        group.spawn([&, i, run_step, keep_log]() {
+          // Search
+          run_step([&]() {
+            results[i].result =
+                pipeline.search(states[i].app.get(), states[i].initial_cores,
+                                scheduler, &states[i].log);
+          });
+
+          // The application is not needed anymore
+          states[i].app.reset();
+          keep_log();
+        });
+      });
+    });
+  }
+
+  group.wait();
+  return results;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__PARALLEL_OPTIMIZER__HPP
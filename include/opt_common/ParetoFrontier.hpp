@@ -0,0 +1,206 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__PARETO_FRONTIER__HPP
+#define __OPT_COMMON__PARETO_FRONTIER__HPP
+#include <algorithm>
+#include <functional>
+#include <opt_common/Application.hpp>
+#include <opt_common/helper.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace opt_common {
+
+struct ParetoFrontierOptions {
+  unsigned min_cores = 1;
+
+  //! 0 means the maximum number of tasks of a stage (more cores do not
+  //! reduce the number of waves)
+  unsigned max_cores = 0;
+
+  /*! A more expensive candidate with the same analytic time is kept only
+      if the ML model predicts at least this relative reduction of the
+      execution time
+   */
+  double min_relative_improvement = 0.001;
+};
+
+/*! The Pareto-optimal trade-off between the number of containers and the
+    execution time of an application.
+    The points are sorted by increasing number of containers (and decreasing
+    time), so the cheapest configuration meeting a deadline is a lookup.
+ */
+class ParetoFrontier {
+ public:
+  struct Point {
+    unsigned n_cores;
+    unsigned n_containers;
+    TimeInstant predicted_time;  // Simulated if a simulator is available
+    TimeInstant analytic_time;   // Application::compute_avg_execution_time
+    double ml_time;              // MachineLearningModel::evaluateModel
+    bool simulated;
+  };
+
+  //! \return the execution time of the application with `n_cores` cores
+  using Simulator = std::function<TimeInstant(unsigned n_cores)>;
+
+  /*! Compute the frontier over a range of cores.
+      The analytic wave model prunes the candidates: for a number of
+      containers only the greatest number of cores is considered, and a
+      more expensive candidate must reduce the analytic time. The ML model
+      (not fitted for every application) only breaks the ties.
+      The simulator (optional) is run only on the candidates left.
+   */
+  static ParetoFrontier compute_pareto_frontier(
+      const Application& app,
+      const ParetoFrontierOptions& options = ParetoFrontierOptions(),
+      const Simulator& simulator = nullptr);
+
+  const std::vector<Point>& get_points() const noexcept { return m_points; }
+
+  //! \return the cheapest point meeting `deadline` (nullptr if none does)
+  const Point* find_cheapest_point(const TimeInstant& deadline) const noexcept;
+
+  //! \return the number of simulator runs done to compute the frontier
+  std::size_t get_number_of_simulations() const noexcept {
+    return m_number_of_simulations;
+  }
+
+  void write_csv(std::ostream* os) const;
+  void write_json(std::ostream* os) const;
+
+ private:
+  Application::ApplicationID m_app_id;
+  std::vector<Point> m_points;
+  std::size_t m_number_of_simulations = 0;
+};
+
+inline ParetoFrontier ParetoFrontier::compute_pareto_frontier(
+    const Application& app, const ParetoFrontierOptions& options,
+    const Simulator& simulator) {
+  const unsigned min_cores = std::max(options.min_cores, 1u);
+  const unsigned max_cores =
+      options.max_cores != 0
+          ? options.max_cores
+          : static_cast<unsigned>(app.compute_max_number_of_task());
+  if (max_cores < min_cores) {
+    THROW_RUNTIME_ERROR("In Pareto frontier: empty range of cores");
+  }
+
+  const auto& ic = app.get_infrastructure_config();
+  const auto& mlm = app.get_machine_learning_model();
+
+  // The greatest number of cores for each number of containers
+  std::vector<Point> candidates;
+  for (unsigned n = min_cores; n <= max_cores; ++n) {
+    const unsigned n_containers = ic.get_n_containers(n);
+    if (!candidates.empty() &&
+        candidates.back().n_containers == n_containers) {
+      candidates.pop_back();
+    }
+    candidates.push_back(Point{n, n_containers, TimeInstant(), TimeInstant(),
+                               0.0, false});
+  }
+
+  // Prune the candidates which do not reduce the time of the cheaper ones
+  ParetoFrontier frontier;
+  frontier.m_app_id = app.get_application_id();
+  for (auto& candidate : candidates) {
+    candidate.analytic_time = app.compute_avg_execution_time(candidate.n_cores);
+    candidate.ml_time = mlm.evaluateModel(candidate.n_cores);
+    candidate.predicted_time = candidate.analytic_time;
+
+    if (!frontier.m_points.empty()) {
+      const Point& cheaper = frontier.m_points.back();
+      const bool improves =
+          candidate.analytic_time < cheaper.analytic_time ||
+          (candidate.analytic_time == cheaper.analytic_time &&
+           candidate.ml_time <
+               cheaper.ml_time * (1.0 - options.min_relative_improvement));
+      if (!improves) {
+        continue;
+      }
+    }
+    frontier.m_points.push_back(candidate);
+  }
+
+  if (simulator) {
+    for (auto& point : frontier.m_points) {
+      point.predicted_time = simulator(point.n_cores);
+      point.simulated = true;
+      ++frontier.m_number_of_simulations;
+    }
+
+    // The simulated times can break the dominance between the points
+    std::vector<Point> simulated_points;
+    for (const auto& point : frontier.m_points) {
+      if (simulated_points.empty() ||
+          point.predicted_time < simulated_points.back().predicted_time) {
+        simulated_points.push_back(point);
+      }
+    }
+    frontier.m_points = std::move(simulated_points);
+  }
+
+  return frontier;
+}
+
+inline const ParetoFrontier::Point* ParetoFrontier::find_cheapest_point(
+    const TimeInstant& deadline) const noexcept {
+  // Times are decreasing: find the first point within the deadline
+  const auto finder =
+      std::partition_point(m_points.cbegin(), m_points.cend(),
+                           [&deadline](const Point& point) {
+                             return point.predicted_time > deadline;
+                           });
+  return finder != m_points.cend() ? &*finder : nullptr;
+}
+
+inline void ParetoFrontier::write_csv(std::ostream* os) const {
+  // Times (in milliseconds) are written without losing microseconds
+  const auto precision = os->precision(17);
+  *os << "n_cores,n_containers,predicted_time,analytic_time,ml_time,"
+         "simulated\n";
+  for (const auto& point : m_points) {
+    *os << point.n_cores << ',' << point.n_containers << ','
+        << point.predicted_time << ',' << point.analytic_time << ','
+        << point.ml_time << ',' << (point.simulated ? 1 : 0) << '\n';
+  }
+  os->precision(precision);
+}
+
+inline void ParetoFrontier::write_json(std::ostream* os) const {
+  const auto precision = os->precision(17);
+  *os << "{\"application\": \"" << json_escape(m_app_id)
+      << "\", \"points\": [";
+  for (std::size_t i = 0; i < m_points.size(); ++i) {
+    const Point& point = m_points[i];
+    *os << (i == 0 ? "" : ", ") << "{\"n_cores\": " << point.n_cores
+        << ", \"n_containers\": " << point.n_containers
+        << ", \"predicted_time\": " << point.predicted_time
+        << ", \"analytic_time\": " << point.analytic_time
+        << ", \"ml_time\": " << point.ml_time
+        << ", \"simulated\": " << (point.simulated ? "true" : "false") << "}";
+  }
+  *os << "]}\n";
+  os->precision(precision);
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__PARETO_FRONTIER__HPP
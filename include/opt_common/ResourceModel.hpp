@@ -0,0 +1,309 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__RESOURCE_MODEL__HPP
+#define __OPT_COMMON__RESOURCE_MODEL__HPP
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <opt_common/InfrastructureConfiguration.hpp>
+#include <opt_common/helper.hpp>
+#include <string>
+#include <vector>
+
+namespace opt_common {
+
+//! Amount of each resource required by an executor or offered by a node
+class ResourceVector {
+ public:
+  enum Resource : std::size_t { CORES = 0, MEMORY, DISK, NETWORK };
+  static constexpr std::size_t NUMBER_OF_RESOURCES = 4;
+
+  ResourceVector() noexcept : m_amounts{} {}
+
+  ResourceVector(double cores, double memory, double disk = 0,
+                 double network = 0) noexcept
+      : m_amounts{{cores, memory, disk, network}} {}
+
+  double operator[](std::size_t resource) const noexcept {
+    return m_amounts[resource];
+  }
+  double& operator[](std::size_t resource) noexcept {
+    return m_amounts[resource];
+  }
+
+  //! \return true if every resource is within the capacity
+  bool fits_in(const ResourceVector& capacity) const noexcept;
+
+  //! \return the greatest ratio demand / capacity among all resources
+  double dominant_share(const ResourceVector& capacity) const noexcept;
+
+  ResourceVector& operator+=(const ResourceVector& other) noexcept;
+  ResourceVector& operator-=(const ResourceVector& other) noexcept;
+
+ private:
+  std::array<double, NUMBER_OF_RESOURCES> m_amounts;
+};
+
+inline bool ResourceVector::fits_in(const ResourceVector& capacity) const
+    noexcept {
+  bool fits = true;
+  for (std::size_t r = 0; r < NUMBER_OF_RESOURCES; ++r) {
+    fits &= m_amounts[r] <= capacity.m_amounts[r];
+  }
+  return fits;
+}
+
+inline double ResourceVector::dominant_share(
+    const ResourceVector& capacity) const noexcept {
+  double share = 0;
+  for (std::size_t r = 0; r < NUMBER_OF_RESOURCES; ++r) {
+    if (m_amounts[r] > 0) {
+      share = std::fmax(share, m_amounts[r] / capacity.m_amounts[r]);
+    }
+  }
+  return share;
+}
+
+inline ResourceVector& ResourceVector::operator+=(
+    const ResourceVector& other) noexcept {
+  for (std::size_t r = 0; r < NUMBER_OF_RESOURCES; ++r) {
+    m_amounts[r] += other.m_amounts[r];
+  }
+  return *this;
+}
+
+inline ResourceVector& ResourceVector::operator-=(
+    const ResourceVector& other) noexcept {
+  for (std::size_t r = 0; r < NUMBER_OF_RESOURCES; ++r) {
+    m_amounts[r] -= other.m_amounts[r];
+  }
+  return *this;
+}
+
+//! \return the resources of one executor described by `ic`
+inline ResourceVector get_executor_resources(
+    const InfrastructureConfiguration& ic) {
+  return ResourceVector(ic.getExecutor_cores(), ic.getExecutor_memory());
+}
+
+//! \return the resources of one container described by `ic`
+inline ResourceVector get_container_resources(
+    const InfrastructureConfiguration& ic) {
+  return ResourceVector(ic.getContainter_cores(), ic.getContainer_memory());
+}
+
+/*! Multi-resource version of InfrastructureConfiguration::get_n_containers:
+    the executors providing `n_required_executors_cores` cores are packed
+    in containers, whose number is driven by the bottleneck resource.
+ */
+inline unsigned get_n_containers(const ResourceVector& executor,
+                                 const ResourceVector& container,
+                                 unsigned n_required_executors_cores) {
+  if (!(executor[ResourceVector::CORES] > 0)) {
+    THROW_RUNTIME_ERROR("In resource model: executor without cores");
+  }
+  const double required_executors = std::ceil(
+      n_required_executors_cores / executor[ResourceVector::CORES]);
+
+  // A container lacking a resource the executor needs cannot host it
+  const double required_containers =
+      std::ceil(required_executors * executor.dominant_share(container));
+  if (!(required_containers <=
+        static_cast<double>(std::numeric_limits<unsigned>::max()))) {
+    THROW_RUNTIME_ERROR(
+        "In resource model: the container cannot host the executors");
+  }
+  return static_cast<unsigned>(required_containers);
+}
+
+//! A set of identical nodes
+struct NodePool {
+  std::string name;
+  ResourceVector capacity;
+  unsigned count;
+};
+
+struct PackingResult {
+  static constexpr std::size_t NOT_PLACED = static_cast<std::size_t>(-1);
+
+  //! Node index for each item (NOT_PLACED if it does not fit anywhere)
+  std::vector<std::size_t> assignment;
+
+  //! Pool index for each node
+  std::vector<std::size_t> node_pool;
+
+  std::size_t n_unplaced = 0;
+  std::size_t n_used_nodes = 0;
+
+  //! Used nodes for each pool
+  std::vector<std::size_t> n_used_nodes_per_pool;
+
+  /*! Free fraction of each resource on the used nodes: capacity that is paid
+      for but stranded because another resource is the bottleneck.
+   */
+  ResourceVector fragmentation;
+};
+
+/*! Vector bin packing by first-fit-decreasing over mixed node pools.
+    Nodes are tried in pool order; the nodes which can still host an item are
+    tracked in a bitset, so full nodes are skipped one word at a time.
+ */
+class VectorBinPacker {
+ public:
+  explicit VectorBinPacker(std::vector<NodePool> node_pools);
+
+  PackingResult pack(const std::vector<ResourceVector>& items) const;
+
+ private:
+  using BitsetWord = std::uint64_t;
+  static constexpr std::size_t BITS_PER_WORD = 64;
+
+  std::vector<NodePool> m_node_pools;
+  ResourceVector m_largest_capacity;
+
+  static unsigned count_trailing_zeros(BitsetWord word) noexcept;
+};
+
+inline VectorBinPacker::VectorBinPacker(std::vector<NodePool> node_pools)
+    : m_node_pools(std::move(node_pools)) {
+  for (const auto& pool : m_node_pools) {
+    for (std::size_t r = 0; r < ResourceVector::NUMBER_OF_RESOURCES; ++r) {
+      m_largest_capacity[r] =
+          std::fmax(m_largest_capacity[r], pool.capacity[r]);
+    }
+  }
+}
+
+inline unsigned VectorBinPacker::count_trailing_zeros(
+    BitsetWord word) noexcept {
+  assert(word != 0);
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#else
+  unsigned n = 0;
+  while ((word & 1) == 0) {
+    word >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+inline PackingResult VectorBinPacker::pack(
+    const std::vector<ResourceVector>& items) const {
+  PackingResult result;
+  result.assignment.assign(items.size(), PackingResult::NOT_PLACED);
+  result.n_used_nodes_per_pool.assign(m_node_pools.size(), 0);
+
+  // Expand the pools in single nodes
+  std::vector<ResourceVector> free_capacity;
+  for (std::size_t p = 0; p < m_node_pools.size(); ++p) {
+    free_capacity.insert(free_capacity.end(), m_node_pools[p].count,
+                         m_node_pools[p].capacity);
+    result.node_pool.insert(result.node_pool.end(), m_node_pools[p].count, p);
+  }
+  const std::size_t n_nodes = free_capacity.size();
+  std::vector<bool> used(n_nodes, false);
+
+  // Sort items by decreasing dominant share on the largest node
+  std::vector<std::size_t> order(items.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<double> sizes(items.size());
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    sizes[i] = items[i].dominant_share(m_largest_capacity);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&sizes](std::size_t a, std::size_t b) {
+                     return sizes[a] > sizes[b];
+                   });
+
+  // The smallest demand of each resource: a node which cannot host it is
+  // removed from the index since it cannot host any other item
+  ResourceVector smallest_item;
+  if (items.empty() == false) {
+    smallest_item = items.front();
+    for (const auto& item : items) {
+      for (std::size_t r = 0; r < ResourceVector::NUMBER_OF_RESOURCES; ++r) {
+        smallest_item[r] = std::fmin(smallest_item[r], item[r]);
+      }
+    }
+  }
+
+  // Bitset index of nodes with some free capacity
+  std::vector<BitsetWord> available((n_nodes + BITS_PER_WORD - 1) /
+                                    BITS_PER_WORD);
+  for (std::size_t n = 0; n < n_nodes; ++n) {
+    if (smallest_item.fits_in(free_capacity[n])) {
+      available[n / BITS_PER_WORD] |= BitsetWord(1) << (n % BITS_PER_WORD);
+    }
+  }
+
+  for (const auto item_index : order) {
+    const ResourceVector& item = items[item_index];
+
+    bool placed = false;
+    for (std::size_t w = 0; w < available.size() && !placed; ++w) {
+      BitsetWord word = available[w];
+      while (word != 0) {
+        const std::size_t node =
+            w * BITS_PER_WORD + count_trailing_zeros(word);
+        word &= word - 1;
+
+        if (item.fits_in(free_capacity[node])) {
+          free_capacity[node] -= item;
+          used[node] = true;
+          result.assignment[item_index] = node;
+          if (smallest_item.fits_in(free_capacity[node]) == false) {
+            available[w] &= ~(BitsetWord(1) << (node % BITS_PER_WORD));
+          }
+          placed = true;
+          break;
+        }
+      }
+    }
+
+    if (!placed) {
+      ++result.n_unplaced;
+    }
+  }
+
+  // Compute the stranded capacity on the used nodes
+  ResourceVector total_capacity, total_free;
+  for (std::size_t n = 0; n < n_nodes; ++n) {
+    if (used[n]) {
+      ++result.n_used_nodes;
+      ++result.n_used_nodes_per_pool[result.node_pool[n]];
+      total_capacity += m_node_pools[result.node_pool[n]].capacity;
+      total_free += free_capacity[n];
+    }
+  }
+  for (std::size_t r = 0; r < ResourceVector::NUMBER_OF_RESOURCES; ++r) {
+    if (total_capacity[r] > 0) {
+      result.fragmentation[r] = total_free[r] / total_capacity[r];
+    }
+  }
+
+  return result;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__RESOURCE_MODEL__HPP
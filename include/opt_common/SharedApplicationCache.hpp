@@ -0,0 +1,816 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__SHARED_APPLICATION_CACHE__HPP
+#define __OPT_COMMON__SHARED_APPLICATION_CACHE__HPP
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <opt_common/Application.hpp>
+#include <opt_common/configuration.hpp>
+#include <opt_common/helper.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace opt_common {
+
+/*! Read-only view of an application stored in a shared memory segment.
+    The segment has a flat layout: fixed-width records and offsets from the
+    beginning of the segment, so every process can map it at any address and
+    use it without copying.
+ */
+class SharedApplicationView {
+ public:
+  //! Times are in microseconds (see TimeInstant)
+  struct FlatStage {
+    std::uint64_t id;
+    std::uint64_t number_of_tasks;
+    std::int64_t min_time;
+    std::int64_t avg_time;
+    std::int64_t max_time;
+    std::int64_t tasks_times_sum;
+    double tasks_times_sum_of_squares;
+    std::uint64_t tasks_times_count;
+    std::uint64_t first_dependency;  // Index in the IDs array
+    std::uint64_t number_of_dependencies;
+  };
+
+  struct FlatJob {
+    std::uint64_t id;
+    std::int64_t submission_time;
+    std::int64_t completion_time;
+    std::uint64_t first_stage;  // Index in the IDs array
+    std::uint64_t number_of_stages;
+  };
+
+  //! An invalid view
+  SharedApplicationView() = default;
+
+  bool is_valid() const noexcept { return m_header != nullptr; }
+
+  std::string_view get_application_id() const noexcept;
+
+  std::size_t get_number_of_stages() const noexcept {
+    return m_header->number_of_stages;
+  }
+  const FlatStage& get_stage(std::size_t index) const noexcept;
+
+  std::size_t get_number_of_jobs() const noexcept {
+    return m_header->number_of_jobs;
+  }
+  const FlatJob& get_job(std::size_t index) const noexcept;
+
+  //! The stage IDs referred by FlatStage and FlatJob
+  const std::uint64_t* get_ids() const noexcept;
+
+  //! Same as Application::compute_avg_execution_time
+  TimeInstant compute_avg_execution_time(std::size_t n) const noexcept;
+
+  //! \return a (private) application built from the view, without parsing
+  Application create_application(Application::FileResources resources_filename,
+                                 const Configuration& configuration,
+                                 const std::string& deadline_str) const;
+
+ private:
+  friend class SharedApplicationCache;
+
+  static constexpr std::uint64_t MAGIC = 0x3270704143544f50;  // "POTCApp2"
+
+  enum SegmentState : std::uint32_t { BUILDING = 0, READY, UNAVAILABLE };
+
+  struct SegmentHeader {
+    std::uint64_t magic;
+    std::atomic<std::uint32_t> state;
+    std::uint32_t padding;
+    std::int64_t builder_pid;  // The process writing the segment
+    std::uint64_t segment_size;
+
+    // Key of the application (to detect collisions of the segment name)
+    std::uint64_t key_offset;
+    std::uint64_t key_size;
+
+    std::uint64_t application_id_offset;
+    std::uint64_t application_id_size;
+    std::int64_t real_execution_time;
+
+    float container_memory;
+    float executor_memory;
+    std::uint32_t container_cores;
+    std::uint32_t executor_cores;
+    double chi_0;
+    double chi_c;
+
+    std::uint64_t jobs_file_offset;
+    std::uint64_t stages_file_offset;
+    std::uint64_t tasks_file_offset;
+
+    std::uint64_t number_of_stages;
+    std::uint64_t stages_offset;
+    std::uint64_t number_of_jobs;
+    std::uint64_t jobs_offset;
+    std::uint64_t number_of_ids;
+    std::uint64_t ids_offset;
+  };
+
+  static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+                "The state is shared between processes");
+  static_assert(std::is_trivially_copyable<FlatStage>::value &&
+                    std::is_trivially_copyable<FlatJob>::value,
+                "Records are written as raw memory");
+
+  //! Keep the segment mapped as long as a copy of the view exists
+  std::shared_ptr<const void> m_mapping;
+  const SegmentHeader* m_header = nullptr;
+
+  const char* get_base() const noexcept {
+    return reinterpret_cast<const char*>(m_header);
+  }
+  std::string_view get_key() const noexcept {
+    return std::string_view(get_base() + m_header->key_offset,
+                            m_header->key_size);
+  }
+
+  /*! \return true if the header describes a segment of `mapped_size`
+      bytes, with all its parts and the records they refer to inside it
+   */
+  bool is_consistent(std::uint64_t mapped_size) const noexcept;
+
+  //! \return the size of the segment for `app`
+  static std::uint64_t compute_segment_size(const Application& app,
+                                            const std::string& key) noexcept;
+
+  //! Write `app` at `segment` (of compute_segment_size bytes), after the
+  //! header published by the builder (which keeps its builder_pid)
+  static void write_segment(const Application& app, const std::string& key,
+                            void* segment);
+};
+
+/*! Cache of applications shared by the processes of a host.
+    An application is parsed by the first process requesting it and stored in
+    a named shared memory segment; the other processes map the segment.
+    The segment name is derived from the paths of the trace files. The
+    segment stores the key of the application: the ApplicationID and the
+    fingerprints (size and modification time) of the trace files. A segment
+    of an older version of the trace (or a damaged one) is replaced.
+    \note Applications still running (incomplete traces) are not shared.
+ */
+class SharedApplicationCache {
+ public:
+  /*! \return the application, from the cache if possible (otherwise it is
+      parsed and stored in the cache)
+   */
+  static Application load_application(
+      Application::FileResources resources_filename,
+      const Configuration& configuration, const std::string& deadline_str);
+
+  /*! \return a view of the application in the cache, parsing and storing it
+      if it is missing. The view is invalid if the application cannot be
+      shared.
+   */
+  static SharedApplicationView map_application(
+      const Application::FileResources& resources_filename,
+      const Configuration& configuration);
+
+  //! Remove the segment of the application (mapped views stay valid)
+  //! \return false if there is no segment
+  static bool remove_application(
+      const Application::FileResources& resources_filename,
+      const Configuration& configuration);
+
+  //! Time to wait for another process which is parsing the application
+  static constexpr std::chrono::seconds WAIT_TIMEOUT{300};
+
+ private:
+  //! \return the key of the application (empty if the files are missing)
+  static std::string get_key(
+      const Application::FileResources& resources_filename,
+      const Configuration& configuration);
+
+  //! \return the name of the segment of the trace files (the same for all
+  //! the versions of the files)
+  static std::string get_segment_name(
+      const Application::FileResources& resources_filename,
+      const Configuration& configuration);
+
+  /*! Map the segment of the application, creating it if it is missing.
+      If this process parses the application, it is moved in `parsed_app`.
+   */
+  static SharedApplicationView open_segment(
+      const Application::FileResources& resources_filename,
+      const Configuration& configuration, const std::string& deadline_str,
+      std::unique_ptr<Application>* parsed_app);
+
+#if defined(__unix__) || defined(__APPLE__)
+  //! Parse the application and write it in the new segment `fd`
+  static SharedApplicationView build_segment(
+      int fd, const std::string& name, const std::string& key,
+      const Application::FileResources& resources_filename,
+      const Configuration& configuration, const std::string& deadline_str,
+      std::unique_ptr<Application>* parsed_app);
+
+  /*! Map the existing segment `fd`, waiting for its builder.
+      `replace` is set if the segment is not usable for `key` and has been
+      unlinked (an older version of the trace, a dead builder or a damaged
+      segment): a new segment can be created.
+   */
+  static SharedApplicationView map_segment(int fd, const std::string& name,
+                                           const std::string& key,
+                                           bool* replace);
+
+  //! Unlink the segment `name` only if it is still the segment `fd` (and
+  //! not one created since by another process)
+  static void unlink_segment(int fd, const std::string& name);
+#endif
+
+  //! \return true if the application can be stored in the cache
+  static bool is_shareable(const Application& app) noexcept {
+    const Application::Trace& trace = *app.m_trace;
+    return !app.is_sampled() && trace.m_partial_jobs.empty() &&
+           trace.m_pending_tasks_times.empty() &&
+           trace.m_real_execution_time > TimeInstant();
+  }
+};
+
+inline std::string_view SharedApplicationView::get_application_id() const
+    noexcept {
+  return std::string_view(get_base() + m_header->application_id_offset,
+                          m_header->application_id_size);
+}
+
+inline const SharedApplicationView::FlatStage& SharedApplicationView::get_stage(
+    std::size_t index) const noexcept {
+  return reinterpret_cast<const FlatStage*>(get_base() +
+                                            m_header->stages_offset)[index];
+}
+
+inline const SharedApplicationView::FlatJob& SharedApplicationView::get_job(
+    std::size_t index) const noexcept {
+  return reinterpret_cast<const FlatJob*>(get_base() +
+                                          m_header->jobs_offset)[index];
+}
+
+inline const std::uint64_t* SharedApplicationView::get_ids() const noexcept {
+  return reinterpret_cast<const std::uint64_t*>(get_base() +
+                                                m_header->ids_offset);
+}
+
+inline bool SharedApplicationView::is_consistent(
+    std::uint64_t mapped_size) const noexcept {
+  const SegmentHeader& header = *m_header;
+  if (header.magic != MAGIC || header.segment_size != mapped_size ||
+      mapped_size < sizeof(SegmentHeader)) {
+    return false;
+  }
+
+  // [offset, offset + count * record_size) must be inside the segment
+  const auto is_inside = [mapped_size](std::uint64_t offset,
+                                       std::uint64_t count,
+                                       std::uint64_t record_size) {
+    return offset % 8 == 0 && offset <= mapped_size &&
+           count <= (mapped_size - offset) / record_size;
+  };
+  if (!is_inside(header.key_offset, header.key_size, 1) ||
+      !is_inside(header.application_id_offset, header.application_id_size,
+                 1) ||
+      !is_inside(header.stages_offset, header.number_of_stages,
+                 sizeof(FlatStage)) ||
+      !is_inside(header.jobs_offset, header.number_of_jobs,
+                 sizeof(FlatJob)) ||
+      !is_inside(header.ids_offset, header.number_of_ids,
+                 sizeof(std::uint64_t))) {
+    return false;
+  }
+
+  // The ranges of IDs of the records must be inside the IDs array
+  const auto is_ids_range = [&header](std::uint64_t first,
+                                      std::uint64_t count) {
+    return first <= header.number_of_ids &&
+           count <= header.number_of_ids - first;
+  };
+  for (std::size_t i = 0; i < header.number_of_stages; ++i) {
+    const FlatStage& stage = get_stage(i);
+    if (!is_ids_range(stage.first_dependency, stage.number_of_dependencies)) {
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < header.number_of_jobs; ++i) {
+    const FlatJob& job = get_job(i);
+    if (!is_ids_range(job.first_stage, job.number_of_stages)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline TimeInstant SharedApplicationView::compute_avg_execution_time(
+    std::size_t n) const noexcept {
+  TimeInstant time_execution;
+  for (std::size_t i = 0; i < get_number_of_stages(); ++i) {
+    const FlatStage& stage = get_stage(i);
+    const auto avg_time = TimeInstant::from_microseconds(stage.avg_time);
+    if (stage.number_of_tasks % n != 0) {
+      time_execution += avg_time;
+    }
+
+    const TimeInstant::Rep coeff = stage.number_of_tasks / n;
+    time_execution += coeff * avg_time;
+  }
+  return time_execution;
+}
+
+inline Application SharedApplicationView::create_application(
+    Application::FileResources resources_filename,
+    const Configuration& configuration, const std::string& deadline_str) const {
+  if (!is_valid()) {
+    THROW_RUNTIME_ERROR("In shared application: invalid view");
+  }
+
+  Application app;
+  app.set_files_resources(std::move(resources_filename), configuration,
+                          deadline_str);
+  Application::Trace& trace = app.mutable_trace();
+
+  trace.m_app_id = std::string(get_application_id());
+  trace.m_real_execution_time =
+      TimeInstant::from_microseconds(m_header->real_execution_time);
+  trace.m_infr_config = InfrastructureConfiguration(
+      m_header->container_memory, m_header->executor_memory,
+      m_header->container_cores, m_header->executor_cores);
+  trace.m_mlm = MachineLearningModel(m_header->chi_0, m_header->chi_c);
+  trace.m_trace_offsets.m_Jobs_File = m_header->jobs_file_offset;
+  trace.m_trace_offsets.m_Stages_File = m_header->stages_file_offset;
+  trace.m_trace_offsets.m_Tasks_File = m_header->tasks_file_offset;
+
+  const std::uint64_t* const ids = get_ids();
+
+  // Records are sorted by ID: insert with hint at the end
+  for (std::size_t i = 0; i < get_number_of_stages(); ++i) {
+    const FlatStage& flat_stage = get_stage(i);
+    Stage& stage =
+        trace.m_stages
+            .try_emplace(trace.m_stages.end(), flat_stage.id, flat_stage.id,
+                         flat_stage.number_of_tasks)
+            ->second;
+    const std::uint64_t* const dependencies = ids + flat_stage.first_dependency;
+    stage.set_dependencies(dependencies,
+                           dependencies + flat_stage.number_of_dependencies);
+    stage.m_min_time = TimeInstant::from_microseconds(flat_stage.min_time);
+    stage.m_avg_time = TimeInstant::from_microseconds(flat_stage.avg_time);
+    stage.m_max_time = TimeInstant::from_microseconds(flat_stage.max_time);
+    stage.m_tasks_times_sum =
+        TimeInstant::from_microseconds(flat_stage.tasks_times_sum);
+    stage.m_tasks_times_sum_of_squares = flat_stage.tasks_times_sum_of_squares;
+    stage.m_tasks_times_count = flat_stage.tasks_times_count;
+  }
+
+  for (std::size_t i = 0; i < get_number_of_jobs(); ++i) {
+    const FlatJob& flat_job = get_job(i);
+    Job& job =
+        trace.m_jobs
+            .try_emplace(
+                trace.m_jobs.end(), flat_job.id, flat_job.id,
+                TimeInstant::from_microseconds(flat_job.submission_time),
+                TimeInstant::from_microseconds(flat_job.completion_time))
+            ->second;
+    const std::uint64_t* const id_stages = ids + flat_job.first_stage;
+    job.set_id_stages(id_stages, id_stages + flat_job.number_of_stages);
+  }
+
+  return app;
+}
+
+inline std::uint64_t SharedApplicationView::compute_segment_size(
+    const Application& app, const std::string& key) noexcept {
+  const Application::Trace& trace = *app.m_trace;
+
+  // Every part is aligned to 8 bytes
+  const auto align = [](std::uint64_t size) { return (size + 7) & ~7ull; };
+
+  std::uint64_t number_of_ids = 0;
+  for (const auto& stage_pair : trace.m_stages) {
+    number_of_ids += stage_pair.second.get_dependencies().size();
+  }
+  for (const auto& job_pair : trace.m_jobs) {
+    number_of_ids += job_pair.second.get_id_stages().size();
+  }
+
+  return align(sizeof(SegmentHeader)) + align(key.size()) +
+         align(trace.m_app_id.size()) +
+         sizeof(FlatStage) * trace.m_stages.size() +
+         sizeof(FlatJob) * trace.m_jobs.size() +
+         sizeof(std::uint64_t) * number_of_ids;
+}
+
+inline void SharedApplicationView::write_segment(const Application& app,
+                                                 const std::string& key,
+                                                 void* segment) {
+  const Application::Trace& trace = *app.m_trace;
+  const auto align = [](std::uint64_t size) { return (size + 7) & ~7ull; };
+  char* const base = static_cast<char*>(segment);
+
+  SegmentHeader* const header = reinterpret_cast<SegmentHeader*>(base);
+  header->segment_size = compute_segment_size(app, key);
+
+  std::uint64_t offset = align(sizeof(SegmentHeader));
+
+  header->key_offset = offset;
+  header->key_size = key.size();
+  std::memcpy(base + offset, key.data(), key.size());
+  offset += align(key.size());
+
+  header->application_id_offset = offset;
+  header->application_id_size = trace.m_app_id.size();
+  std::memcpy(base + offset, trace.m_app_id.data(), trace.m_app_id.size());
+  offset += align(trace.m_app_id.size());
+
+  header->real_execution_time =
+      trace.m_real_execution_time.count_microseconds();
+  header->container_memory = trace.m_infr_config.getContainer_memory();
+  header->executor_memory = trace.m_infr_config.getExecutor_memory();
+  header->container_cores = trace.m_infr_config.getContainter_cores();
+  header->executor_cores = trace.m_infr_config.getExecutor_cores();
+  header->chi_0 = trace.m_mlm.get_chi_0();
+  header->chi_c = trace.m_mlm.get_chi_c();
+  header->jobs_file_offset = trace.m_trace_offsets.m_Jobs_File;
+  header->stages_file_offset = trace.m_trace_offsets.m_Stages_File;
+  header->tasks_file_offset = trace.m_trace_offsets.m_Tasks_File;
+
+  header->number_of_stages = trace.m_stages.size();
+  header->stages_offset = offset;
+  offset += sizeof(FlatStage) * trace.m_stages.size();
+
+  header->number_of_jobs = trace.m_jobs.size();
+  header->jobs_offset = offset;
+  offset += sizeof(FlatJob) * trace.m_jobs.size();
+
+  header->ids_offset = offset;
+  std::uint64_t* const ids = reinterpret_cast<std::uint64_t*>(base + offset);
+  std::uint64_t number_of_ids = 0;
+
+  FlatStage* flat_stage = reinterpret_cast<FlatStage*>(
+      base + header->stages_offset);
+  for (const auto& stage_pair : trace.m_stages) {
+    const Stage& stage = stage_pair.second;
+    const auto& dependencies = stage.get_dependencies();
+    *flat_stage++ = FlatStage{stage.get_stageID(),
+                              stage.get_number_of_tasks(),
+                              stage.get_min_time().count_microseconds(),
+                              stage.get_avg_time().count_microseconds(),
+                              stage.get_max_time().count_microseconds(),
+                              stage.get_tasks_times_sum().count_microseconds(),
+                              stage.get_tasks_times_sum_of_squares(),
+                              stage.get_number_of_tasks_times(),
+                              number_of_ids,
+                              dependencies.size()};
+    std::copy(dependencies.cbegin(), dependencies.cend(), ids + number_of_ids);
+    number_of_ids += dependencies.size();
+  }
+
+  FlatJob* flat_job = reinterpret_cast<FlatJob*>(base + header->jobs_offset);
+  for (const auto& job_pair : trace.m_jobs) {
+    const Job& job = job_pair.second;
+    const auto& id_stages = job.get_id_stages();
+    *flat_job++ = FlatJob{job.get_jobID(),
+                          job.get_submission_time().count_microseconds(),
+                          job.get_completion_time().count_microseconds(),
+                          number_of_ids, id_stages.size()};
+    std::copy(id_stages.cbegin(), id_stages.cend(), ids + number_of_ids);
+    number_of_ids += id_stages.size();
+  }
+  header->number_of_ids = number_of_ids;
+
+  // Publish the content to the other processes
+  header->state.store(READY, std::memory_order_release);
+}
+
+inline Application SharedApplicationCache::load_application(
+    Application::FileResources resources_filename,
+    const Configuration& configuration, const std::string& deadline_str) {
+  std::unique_ptr<Application> parsed_app;
+  const SharedApplicationView view = open_segment(
+      resources_filename, configuration, deadline_str, &parsed_app);
+
+  if (parsed_app) {
+    return std::move(*parsed_app);
+  }
+  if (view.is_valid()) {
+    return view.create_application(std::move(resources_filename),
+                                   configuration, deadline_str);
+  }
+  return Application::create_application(std::move(resources_filename),
+                                         configuration, deadline_str);
+}
+
+inline SharedApplicationView SharedApplicationCache::map_application(
+    const Application::FileResources& resources_filename,
+    const Configuration& configuration) {
+  // The deadline is not part of the trace
+  std::unique_ptr<Application> parsed_app;
+  return open_segment(resources_filename, configuration, "0", &parsed_app);
+}
+
+inline std::string SharedApplicationCache::get_key(
+    const Application::FileResources& resources_filename,
+    const Configuration& configuration) {
+  std::string key;
+#if defined(__unix__) || defined(__APPLE__)
+  const std::string& data_path = configuration.get_data_path();
+  const std::string application_file =
+      data_path + "/" + resources_filename.m_Application_File;
+
+  // The ApplicationID (the application file is small)
+  CSV_Data csv_data;
+  try {
+    read_csv_file(application_file, &csv_data);
+    key = csv_data.at(1).at(0) + "\n";
+  } catch (const std::exception&) {
+    return std::string();
+  }
+
+  // The fingerprints of all the files the application is built from
+  for (const auto* file :
+       {&resources_filename.m_Application_File, &resources_filename.m_Jobs_File,
+        &resources_filename.m_Stages_File, &resources_filename.m_Tasks_File,
+        &resources_filename.m_Infrastructure_File}) {
+    const std::string path = data_path + "/" + *file;
+    struct stat file_stat;
+    if (::stat(path.c_str(), &file_stat) != 0) {
+      return std::string();
+    }
+    // A file rewritten within a second (with the same size) is another
+    // version: the modification time is in nanoseconds
+#ifdef __APPLE__
+    const timespec& modification_time = file_stat.st_mtimespec;
+#else
+    const timespec& modification_time = file_stat.st_mtim;
+#endif
+    key += path + " " + std::to_string(file_stat.st_size) + " " +
+           std::to_string(modification_time.tv_sec) + "." +
+           std::to_string(modification_time.tv_nsec) + "\n";
+  }
+#endif
+  return key;
+}
+
+inline std::string SharedApplicationCache::get_segment_name(
+    const Application::FileResources& resources_filename,
+    const Configuration& configuration) {
+  // FNV-1a of the paths of the files
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  const auto add_to_hash = [&hash](const std::string& text) {
+    for (const char c : text) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    hash = (hash ^ '\n') * 0x100000001b3ull;
+  };
+  add_to_hash(configuration.get_data_path());
+  for (const auto* file :
+       {&resources_filename.m_Application_File, &resources_filename.m_Jobs_File,
+        &resources_filename.m_Stages_File, &resources_filename.m_Tasks_File,
+        &resources_filename.m_Infrastructure_File}) {
+    add_to_hash(*file);
+  }
+
+  static constexpr char hex_digits[] = "0123456789abcdef";
+  std::string name = "/opt_common_app_";
+  for (int shift = 60; shift >= 0; shift -= 4) {
+    name += hex_digits[(hash >> shift) & 0xF];
+  }
+  return name;
+}
+
+inline SharedApplicationView SharedApplicationCache::open_segment(
+    const Application::FileResources& resources_filename,
+    const Configuration& configuration, const std::string& deadline_str,
+    std::unique_ptr<Application>* parsed_app) {
+#if defined(__unix__) || defined(__APPLE__)
+  const std::string key = get_key(resources_filename, configuration);
+  if (key.empty()) {
+    return SharedApplicationView();
+  }
+  const std::string name = get_segment_name(resources_filename, configuration);
+
+  // A segment which is not usable is replaced once
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd >= 0) {
+      return build_segment(fd, name, key, resources_filename, configuration,
+                           deadline_str, parsed_app);
+    }
+    if (errno != EEXIST || (fd = ::shm_open(name.c_str(), O_RDONLY, 0)) < 0) {
+      break;
+    }
+
+    bool replace = false;
+    SharedApplicationView view = map_segment(fd, name, key, &replace);
+    ::close(fd);
+    if (view.is_valid() || !replace) {
+      return view;
+    }
+  }
+#endif
+  return SharedApplicationView();
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+inline void SharedApplicationCache::unlink_segment(int fd,
+                                                   const std::string& name) {
+  struct stat segment_stat, named_stat;
+  const int named_fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (named_fd < 0) {
+    return;
+  }
+  if (::fstat(fd, &segment_stat) == 0 &&
+      ::fstat(named_fd, &named_stat) == 0 &&
+      segment_stat.st_dev == named_stat.st_dev &&
+      segment_stat.st_ino == named_stat.st_ino) {
+    ::shm_unlink(name.c_str());
+  }
+  ::close(named_fd);
+}
+
+inline SharedApplicationView SharedApplicationCache::build_segment(
+    int fd, const std::string& name, const std::string& key,
+    const Application::FileResources& resources_filename,
+    const Configuration& configuration, const std::string& deadline_str,
+    std::unique_ptr<Application>* parsed_app) {
+  using Header = SharedApplicationView::SegmentHeader;
+  SharedApplicationView view;
+
+  // Map `size` bytes of `fd` in the view
+  const auto map_view = [&view, fd](std::uint64_t size) {
+    void* const address =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+      return false;
+    }
+    view.m_mapping = std::shared_ptr<const void>(
+        address, [size](const void* mapping) {
+          ::munmap(const_cast<void*>(mapping), size);
+        });
+    view.m_header = static_cast<const Header*>(address);
+    return true;
+  };
+
+  // Tell the waiting processes that the segment will not be written
+  const auto abandon_segment = [&name, &view, fd]() {
+    if (view.is_valid()) {
+      const_cast<Header*>(view.m_header)
+          ->state.store(SharedApplicationView::UNAVAILABLE,
+                        std::memory_order_release);
+    }
+    unlink_segment(fd, name);
+    ::close(fd);
+    return SharedApplicationView();
+  };
+
+  // First publish who is building the segment
+  if (::ftruncate(fd, sizeof(Header)) != 0 || !map_view(sizeof(Header))) {
+    return abandon_segment();
+  }
+  // The builder is known before the magic makes the header valid
+  Header* const header = new (const_cast<Header*>(view.m_header)) Header{};
+  header->builder_pid = ::getpid();
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = SharedApplicationView::MAGIC;
+
+  try {
+    *parsed_app = std::make_unique<Application>(Application::create_application(
+        resources_filename, configuration, deadline_str));
+  } catch (...) {
+    abandon_segment();
+    throw;
+  }
+
+  const Application& app = **parsed_app;
+  const std::uint64_t size =
+      SharedApplicationView::compute_segment_size(app, key);
+  if (!is_shareable(app) || ::ftruncate(fd, size) != 0) {
+    return abandon_segment();
+  }
+
+  SharedApplicationView header_view = std::move(view);
+  if (!map_view(size)) {
+    view = std::move(header_view);
+    return abandon_segment();
+  }
+  ::close(fd);
+
+  SharedApplicationView::write_segment(app, key,
+                                       const_cast<void*>(view.m_mapping.get()));
+  return view;
+}
+
+inline SharedApplicationView SharedApplicationCache::map_segment(
+    int fd, const std::string& name, const std::string& key, bool* replace) {
+  using Header = SharedApplicationView::SegmentHeader;
+  SharedApplicationView view;
+  *replace = false;
+
+  // Map `size` bytes of `fd` in the view, if the segment has them (the
+  // pages beyond its end cannot be read)
+  const auto map_view = [&view, fd](std::uint64_t size) {
+    struct stat segment_stat;
+    if (::fstat(fd, &segment_stat) != 0 ||
+        static_cast<std::uint64_t>(segment_stat.st_size) < size) {
+      return false;
+    }
+    void* const address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+      return false;
+    }
+    view.m_mapping = std::shared_ptr<const void>(
+        address, [size](const void* mapping) {
+          ::munmap(const_cast<void*>(mapping), size);
+        });
+    view.m_header = static_cast<const Header*>(address);
+    return true;
+  };
+
+  const auto replace_segment = [&]() {
+    unlink_segment(fd, name);
+    *replace = true;
+    return SharedApplicationView();
+  };
+
+  // Wait for the process building the segment
+  const auto timeout =
+      std::chrono::steady_clock::now() + SharedApplicationCache::WAIT_TIMEOUT;
+  std::uint32_t state = SharedApplicationView::BUILDING;
+  while (state == SharedApplicationView::BUILDING &&
+         std::chrono::steady_clock::now() < timeout) {
+    if (view.is_valid() || map_view(sizeof(Header))) {
+      // The magic is 0 until the builder writes the header
+      const std::uint64_t magic = view.m_header->magic;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (magic != 0 && magic != SharedApplicationView::MAGIC) {
+        return replace_segment();
+      }
+      state = view.m_header->state.load(std::memory_order_acquire);
+      if (magic != 0 && state == SharedApplicationView::BUILDING &&
+          ::kill(view.m_header->builder_pid, 0) != 0 && errno == ESRCH) {
+        // The builder died
+        return replace_segment();
+      }
+    }
+    if (state == SharedApplicationView::BUILDING) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  if (state != SharedApplicationView::READY) {
+    return SharedApplicationView();
+  }
+
+  const std::uint64_t segment_size = view.m_header->segment_size;
+  if (segment_size < sizeof(Header) || !map_view(segment_size) ||
+      !view.is_consistent(segment_size) || view.get_key() != key) {
+    // Truncated, damaged or of another version of the trace
+    return replace_segment();
+  }
+  return view;
+}
+
+#endif
+
+inline bool SharedApplicationCache::remove_application(
+    const Application::FileResources& resources_filename,
+    const Configuration& configuration) {
+#if defined(__unix__) || defined(__APPLE__)
+  return ::shm_unlink(
+             get_segment_name(resources_filename, configuration).c_str()) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__SHARED_APPLICATION_CACHE__HPP
@@ -16,7 +16,9 @@ limitations under the License.
 
 #ifndef __OPT_COMMON__STAGE_HPP
 #define __OPT_COMMON__STAGE_HPP
+#include <algorithm>
 #include <cstdint>
+#include <memory_resource>
 #include <opt_common/helper.hpp>
 #include <ostream>
 #include <set>
@@ -27,9 +29,20 @@ namespace opt_common {
 class Stage {
  public:
   using StageID = std::uint64_t;
+  using allocator_type = std::pmr::polymorphic_allocator<StageID>;
 
   //! Constructor
-  Stage(StageID stage_id, std::size_t number_of_tasks);
+  Stage(StageID stage_id, std::size_t number_of_tasks,
+        const allocator_type& allocator = {});
+
+  //! Allocator-extended constructors (used by std::pmr containers)
+  Stage(const Stage& other, const allocator_type& allocator);
+  Stage(Stage&& other, const allocator_type& allocator);
+
+  Stage(const Stage&) = default;
+  Stage(Stage&&) = default;
+  Stage& operator=(const Stage&) = default;
+  Stage& operator=(Stage&&) = default;
 
   //! \return the stage identifier
   const StageID& get_stageID() const noexcept { return m_id_stage; }
@@ -44,59 +57,199 @@ class Stage {
   const TimeInstant& get_max_time() const noexcept { return m_max_time; }
 
   void set_tasks_times(const std::vector<TimeInstant>& tasks_times) {
-    const auto statistical_times = compute_minavgmax_times(tasks_times);
-    m_min_time = std::get<0>(statistical_times);
-    m_avg_time = std::get<1>(statistical_times);
-    m_max_time = std::get<2>(statistical_times);
+    set_tasks_times(tasks_times.data(), tasks_times.size());
+  }
+
+  void set_tasks_times(const TimeInstant* tasks_times, std::size_t size);
+
+  /*! Merge the times of more tasks into the statistics (e.g. tasks read from
+      a trace which is still being written).
+   */
+  void add_tasks_times(const TimeInstant* tasks_times, std::size_t size);
+
+  //! \return the number of task times the statistics are computed on
+  std::size_t get_number_of_tasks_times() const noexcept {
+    return m_tasks_times_count;
+  }
+
+  const TimeInstant& get_tasks_times_sum() const noexcept {
+    return m_tasks_times_sum;
+  }
+
+  //! \return the sum of the squared task times (in microseconds squared)
+  double get_tasks_times_sum_of_squares() const noexcept {
+    return m_tasks_times_sum_of_squares;
   }
 
-  void set_dependencies(std::set<StageID> id_dependencies);
+  /*! Set the statistics computed elsewhere (e.g. merged across runs).
+      The sum of the times is avg_time * count.
+   */
+  void set_tasks_statistics(const TimeInstant& min_time,
+                            const TimeInstant& avg_time,
+                            const TimeInstant& max_time, std::size_t count,
+                            double sum_of_squares);
+
+  void set_dependencies(const std::set<StageID>& id_dependencies);
+
+  //! The IDs are sorted and duplicates are removed
+  void set_dependencies(const std::vector<StageID>& id_dependencies) {
+    set_dependencies(id_dependencies.cbegin(), id_dependencies.cend());
+  }
+
+  //! The IDs are sorted and duplicates are removed
+  template <typename InputIt>
+  void set_dependencies(InputIt first, InputIt last);
+
+  //! \return the sorted IDs of the parent stages
+  const std::pmr::vector<StageID>& get_dependencies() const noexcept {
+    return m_stages_dependencies;
+  }
 
   void print_dump_on_stream(std::ostream* os) const;
 
  private:
-  using MinAvgMax_Times = std::tuple<TimeInstant, TimeInstant, TimeInstant>;
+  friend class SharedApplicationView;
+
+  using MinSumMax_Times = std::tuple<TimeInstant, TimeInstant, TimeInstant>;
 
   StageID m_id_stage;
   TimeInstant m_min_time;
   TimeInstant m_avg_time;
   TimeInstant m_max_time;
   unsigned int m_number_of_tasks;
-  std::set<StageID> m_stages_dependencies;
+  std::size_t m_tasks_times_count = 0;
+  TimeInstant m_tasks_times_sum;
+  double m_tasks_times_sum_of_squares = 0;
+  std::pmr::vector<StageID> m_stages_dependencies;
 
-  MinAvgMax_Times compute_minavgmax_times(
-      const std::vector<TimeInstant>& tasks_times) const;
+  MinSumMax_Times compute_minsummax_times(const TimeInstant* tasks_times,
+                                          std::size_t size) const;
 };
 
-inline Stage::Stage(StageID stage_id, std::size_t number_of_tasks)
-    : m_id_stage(std::move(stage_id)), m_number_of_tasks(number_of_tasks) {}
+inline Stage::Stage(StageID stage_id, std::size_t number_of_tasks,
+                    const allocator_type& allocator)
+    : m_id_stage(std::move(stage_id)),
+      m_number_of_tasks(number_of_tasks),
+      m_stages_dependencies(allocator) {}
+
+inline Stage::Stage(const Stage& other, const allocator_type& allocator)
+    : m_id_stage(other.m_id_stage),
+      m_min_time(other.m_min_time),
+      m_avg_time(other.m_avg_time),
+      m_max_time(other.m_max_time),
+      m_number_of_tasks(other.m_number_of_tasks),
+      m_tasks_times_count(other.m_tasks_times_count),
+      m_tasks_times_sum(other.m_tasks_times_sum),
+      m_tasks_times_sum_of_squares(other.m_tasks_times_sum_of_squares),
+      m_stages_dependencies(other.m_stages_dependencies, allocator) {}
+
+inline Stage::Stage(Stage&& other, const allocator_type& allocator)
+    : m_id_stage(other.m_id_stage),
+      m_min_time(other.m_min_time),
+      m_avg_time(other.m_avg_time),
+      m_max_time(other.m_max_time),
+      m_number_of_tasks(other.m_number_of_tasks),
+      m_tasks_times_count(other.m_tasks_times_count),
+      m_tasks_times_sum(other.m_tasks_times_sum),
+      m_tasks_times_sum_of_squares(other.m_tasks_times_sum_of_squares),
+      m_stages_dependencies(std::move(other.m_stages_dependencies),
+                            allocator) {}
 
-inline Stage::MinAvgMax_Times Stage::compute_minavgmax_times(
-    const std::vector<TimeInstant>& tasks_times) const {
-  if (tasks_times.empty()) {
+inline void Stage::set_tasks_times(const TimeInstant* tasks_times,
+                                  std::size_t size) {
+  if (size == 0) {
     THROW_RUNTIME_ERROR("Stage computing timing: the number of tasks is zero");
   }
 
-  TimeInstant min = tasks_times.at(0);
-  TimeInstant avg = 0;
-  TimeInstant max = tasks_times.at(0);
+  m_tasks_times_count = 0;
+  add_tasks_times(tasks_times, size);
+}
+
+inline void Stage::add_tasks_times(const TimeInstant* tasks_times,
+                                   std::size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  const auto statistical_times = compute_minsummax_times(tasks_times, size);
+  const TimeInstant& min = std::get<0>(statistical_times);
+  const TimeInstant& sum = std::get<1>(statistical_times);
+  const TimeInstant& max = std::get<2>(statistical_times);
+
+  double sum_of_squares = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    const double time = tasks_times[i].count_microseconds();
+    sum_of_squares += time * time;
+  }
+
+  if (m_tasks_times_count == 0) {
+    m_min_time = min;
+    m_max_time = max;
+    m_tasks_times_sum = sum;
+    m_tasks_times_sum_of_squares = sum_of_squares;
+  } else {
+    m_min_time = std::min(m_min_time, min);
+    m_max_time = std::max(m_max_time, max);
+    m_tasks_times_sum += sum;
+    m_tasks_times_sum_of_squares += sum_of_squares;
+  }
+  m_tasks_times_count += size;
+  m_avg_time =
+      m_tasks_times_sum / static_cast<TimeInstant::Rep>(m_tasks_times_count);
+}
 
-  for (const auto& task_time : tasks_times) {
+inline void Stage::set_tasks_statistics(const TimeInstant& min_time,
+                                        const TimeInstant& avg_time,
+                                        const TimeInstant& max_time,
+                                        std::size_t count,
+                                        double sum_of_squares) {
+  if (count == 0) {
+    THROW_RUNTIME_ERROR("Stage computing timing: the number of tasks is zero");
+  }
+
+  m_min_time = min_time;
+  m_avg_time = avg_time;
+  m_max_time = max_time;
+  m_tasks_times_count = count;
+  m_tasks_times_sum = avg_time * static_cast<TimeInstant::Rep>(count);
+  m_tasks_times_sum_of_squares = sum_of_squares;
+}
+
+inline Stage::MinSumMax_Times Stage::compute_minsummax_times(
+    const TimeInstant* tasks_times, std::size_t size) const {
+  assert(size > 0);
+
+  TimeInstant min = tasks_times[0];
+  TimeInstant sum;
+  TimeInstant max = tasks_times[0];
+
+  for (std::size_t i = 0; i < size; ++i) {
+    const TimeInstant& task_time = tasks_times[i];
     if (task_time < min) {
       min = task_time;
     }
     if (task_time > max) {
       max = task_time;
     }
-    avg += task_time;
+    sum += task_time;
   }
 
-  avg = static_cast<float>(avg) / static_cast<float>(tasks_times.size());
-  return std::make_tuple(min, avg, max);
+  return std::make_tuple(min, sum, max);
+}
+
+inline void Stage::set_dependencies(
+    const std::set<StageID>& id_dependencies) {
+  m_stages_dependencies.assign(id_dependencies.cbegin(),
+                               id_dependencies.cend());
 }
 
-inline void Stage::set_dependencies(std::set<StageID> id_dependencies) {
-  m_stages_dependencies = std::move(id_dependencies);
+template <typename InputIt>
+void Stage::set_dependencies(InputIt first, InputIt last) {
+  m_stages_dependencies.assign(first, last);
+  std::sort(m_stages_dependencies.begin(), m_stages_dependencies.end());
+  m_stages_dependencies.erase(
+      std::unique(m_stages_dependencies.begin(), m_stages_dependencies.end()),
+      m_stages_dependencies.end());
 }
 
 inline void Stage::print_dump_on_stream(std::ostream* os) const {
@@ -0,0 +1,303 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__SURROGATE_SEARCH__HPP
+#define __OPT_COMMON__SURROGATE_SEARCH__HPP
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <opt_common/Application.hpp>
+#include <opt_common/JobExecutionModel.hpp>
+#include <opt_common/helper.hpp>
+#include <utility>
+
+namespace opt_common {
+
+struct SurrogateOptions {
+  //! Width of the uncertainty band, in standard deviations of the error
+  double confidence_z = 2.0;
+
+  //! Standard deviation of the log error of an estimator not calibrated yet
+  double prior_log_error = 0.5;
+
+  //! Simulator results needed before the error of an estimator is measured
+  std::size_t min_observations = 3;
+};
+
+/*! Error model of the cheap estimators of the execution time of an
+    application, calibrated on the results of the simulator.
+    For each estimator the log of (simulated time / predicted time) is
+    tracked (Welford's algorithm): its mean corrects the bias of the
+    estimator and its deviation is the width of the uncertainty band.
+    The prediction uses the estimator with the narrowest band.
+    \note The application must outlive the model.
+ */
+class SurrogateModel {
+ public:
+  enum class Estimator {
+    ANALYTIC,          // Application::compute_avg_execution_time
+    MACHINE_LEARNING,  // MachineLearningModel::evaluateModel
+    ALPHA_BETA,        // alpha / n + beta
+    JOB_MODEL          // JobExecutionModel::compute_execution_time
+  };
+  static constexpr std::size_t NUMBER_OF_ESTIMATORS = 4;
+
+  struct Prediction {
+    TimeInstant lower;
+    TimeInstant estimate;
+    TimeInstant upper;
+    Estimator estimator;
+  };
+
+  explicit SurrogateModel(const Application& app,
+                          const SurrogateOptions& options = SurrogateOptions());
+
+  /*! \return the predicted execution time with `n_cores` cores
+      \throw std::runtime_error if no estimator has a positive prediction
+   */
+  Prediction predict(unsigned n_cores) const;
+
+  //! Update the calibration with a result of the simulator
+  void add_observation(unsigned n_cores, const TimeInstant& simulated_time);
+
+  std::size_t get_number_of_observations() const noexcept {
+    return m_number_of_observations;
+  }
+
+ private:
+  struct ErrorStatistics {
+    std::size_t count = 0;
+    double mean = 0;  // Of the log errors
+    double m2 = 0;    // Sum of the squared deviations
+  };
+
+  const Application* m_app;
+  JobExecutionModel m_job_model;
+  SurrogateOptions m_options;
+  std::array<ErrorStatistics, NUMBER_OF_ESTIMATORS> m_errors;
+  std::size_t m_number_of_observations = 0;
+
+  //! \return the prediction in milliseconds (not positive if not available)
+  double evaluate_estimator(Estimator estimator, unsigned n_cores) const;
+};
+
+/*! Search of the number of cores on a simulator, calling the simulator only
+    for the probes whose predicted band contains the deadline. The other
+    probes are decided by the surrogate model, which is calibrated on each
+    simulator result.
+ */
+class SurrogateGuidedSearch {
+ public:
+  //! \return the execution time of the application with `n_cores` cores
+  using Simulator = std::function<TimeInstant(unsigned n_cores)>;
+
+  SurrogateGuidedSearch(const Application& app, Simulator simulator,
+                        const SurrogateOptions& options = SurrogateOptions());
+
+  //! \return true if the application with `n_cores` cores meets `deadline`
+  bool meets_deadline(unsigned n_cores, const TimeInstant& deadline);
+
+  /*! Bisect the minimum number of cores in [min_cores, max_cores] meeting
+      `deadline` (the time is assumed not to increase with the cores).
+      \return 0 if `max_cores` does not meet the deadline
+   */
+  unsigned find_min_cores(const TimeInstant& deadline, unsigned min_cores,
+                          unsigned max_cores);
+
+  //! \return the simulated time if available, the predicted one otherwise
+  TimeInstant get_time(unsigned n_cores) const;
+
+  std::size_t get_number_of_probes() const noexcept {
+    return m_number_of_probes;
+  }
+  std::size_t get_number_of_simulations() const noexcept {
+    return m_simulated_times.size();
+  }
+
+  const SurrogateModel& get_model() const noexcept { return m_model; }
+
+ private:
+  SurrogateModel m_model;
+  Simulator m_simulator;
+  std::map<unsigned, TimeInstant> m_simulated_times;
+  std::size_t m_number_of_probes = 0;
+
+  const TimeInstant& simulate(unsigned n_cores);
+};
+
+inline SurrogateModel::SurrogateModel(const Application& app,
+                                      const SurrogateOptions& options)
+    : m_app(&app), m_job_model(app), m_options(options) {}
+
+inline double SurrogateModel::evaluate_estimator(Estimator estimator,
+                                                 unsigned n_cores) const {
+  switch (estimator) {
+    case Estimator::ANALYTIC:
+      return m_app->compute_avg_execution_time(n_cores).to_milliseconds();
+    case Estimator::MACHINE_LEARNING:
+      return m_app->get_machine_learning_model().evaluateModel(n_cores);
+    case Estimator::ALPHA_BETA:
+      if (m_app->get_alpha() == 0 && m_app->get_beta() == 0) {
+        // Not fitted
+        return 0;
+      }
+      return m_app->get_alpha() / n_cores + m_app->get_beta();
+    case Estimator::JOB_MODEL:
+      return m_job_model.compute_execution_time(n_cores).to_milliseconds();
+  }
+  return 0;
+}
+
+inline SurrogateModel::Prediction SurrogateModel::predict(
+    unsigned n_cores) const {
+  bool found = false;
+  double best_estimate = 0, best_deviation = 0;
+  Estimator best_estimator = Estimator::ANALYTIC;
+
+  for (std::size_t i = 0; i < NUMBER_OF_ESTIMATORS; ++i) {
+    const auto estimator = static_cast<Estimator>(i);
+    const double predicted = evaluate_estimator(estimator, n_cores);
+    if (!(predicted > 0) || !std::isfinite(predicted)) {
+      continue;
+    }
+
+    // Bias corrected as soon as there is an observation, deviation measured
+    // (with the uncertainty of the mean) after enough observations
+    const ErrorStatistics& error = m_errors[i];
+    double deviation = m_options.prior_log_error;
+    if (error.count >= std::max<std::size_t>(m_options.min_observations, 2)) {
+      deviation = std::sqrt(error.m2 / (error.count - 1) *
+                            (1 + 1.0 / error.count));
+    }
+    const double estimate = predicted * std::exp(error.mean);
+
+    if (!found || deviation < best_deviation) {
+      found = true;
+      best_estimate = estimate;
+      best_deviation = deviation;
+      best_estimator = estimator;
+    }
+  }
+
+  if (!found) {
+    THROW_RUNTIME_ERROR("In surrogate model: no estimator is available");
+  }
+
+  const double margin = std::exp(m_options.confidence_z * best_deviation);
+  return Prediction{TimeInstant::from_milliseconds(best_estimate / margin),
+                    TimeInstant::from_milliseconds(best_estimate),
+                    TimeInstant::from_milliseconds(best_estimate * margin),
+                    best_estimator};
+}
+
+inline void SurrogateModel::add_observation(
+    unsigned n_cores, const TimeInstant& simulated_time) {
+  const double simulated = simulated_time.to_milliseconds();
+  if (!(simulated > 0)) {
+    return;
+  }
+
+  for (std::size_t i = 0; i < NUMBER_OF_ESTIMATORS; ++i) {
+    const double predicted =
+        evaluate_estimator(static_cast<Estimator>(i), n_cores);
+    if (!(predicted > 0) || !std::isfinite(predicted)) {
+      continue;
+    }
+
+    ErrorStatistics& error = m_errors[i];
+    const double log_error = std::log(simulated / predicted);
+    ++error.count;
+    const double delta = log_error - error.mean;
+    error.mean += delta / error.count;
+    error.m2 += delta * (log_error - error.mean);
+  }
+  ++m_number_of_observations;
+}
+
+inline SurrogateGuidedSearch::SurrogateGuidedSearch(
+    const Application& app, Simulator simulator,
+    const SurrogateOptions& options)
+    : m_model(app, options), m_simulator(std::move(simulator)) {
+  if (!m_simulator) {
+    THROW_RUNTIME_ERROR("In surrogate search: missing simulator");
+  }
+}
+
+inline const TimeInstant& SurrogateGuidedSearch::simulate(unsigned n_cores) {
+  const auto finder = m_simulated_times.find(n_cores);
+  if (finder != m_simulated_times.cend()) {
+    return finder->second;
+  }
+
+  const TimeInstant simulated_time = m_simulator(n_cores);
+  m_model.add_observation(n_cores, simulated_time);
+  return m_simulated_times.emplace(n_cores, simulated_time).first->second;
+}
+
+inline bool SurrogateGuidedSearch::meets_deadline(
+    unsigned n_cores, const TimeInstant& deadline) {
+  ++m_number_of_probes;
+
+  const auto finder = m_simulated_times.find(n_cores);
+  if (finder != m_simulated_times.cend()) {
+    return finder->second <= deadline;
+  }
+
+  const SurrogateModel::Prediction prediction = m_model.predict(n_cores);
+  if (prediction.upper <= deadline) {
+    return true;
+  }
+  if (prediction.lower > deadline) {
+    return false;
+  }
+
+  // Near the deadline: the simulator decides
+  return simulate(n_cores) <= deadline;
+}
+
+inline unsigned SurrogateGuidedSearch::find_min_cores(
+    const TimeInstant& deadline, unsigned min_cores, unsigned max_cores) {
+  min_cores = std::max(min_cores, 1u);
+  if (max_cores < min_cores || !meets_deadline(max_cores, deadline)) {
+    return 0;
+  }
+
+  // Invariant: `high` meets the deadline, the cores below `low` do not
+  unsigned low = min_cores, high = max_cores;
+  while (low < high) {
+    const unsigned middle = low + (high - low) / 2;
+    if (meets_deadline(middle, deadline)) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return high;
+}
+
+inline TimeInstant SurrogateGuidedSearch::get_time(unsigned n_cores) const {
+  const auto finder = m_simulated_times.find(n_cores);
+  if (finder != m_simulated_times.cend()) {
+    return finder->second;
+  }
+  return m_model.predict(n_cores).estimate;
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__SURROGATE_SEARCH__HPP
@@ -0,0 +1,169 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__TIME_INSTANT__HPP
+#define __OPT_COMMON__TIME_INSTANT__HPP
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace opt_common {
+
+/*! A time instant (or duration) as an integer number of microseconds.
+    Traces and deadlines are expressed in milliseconds: the conversions from
+    and to milliseconds are checked against overflow.
+ */
+class TimeInstant {
+ public:
+  using Rep = std::int64_t;
+  static constexpr Rep MICROSECONDS_PER_MILLISECOND = 1000;
+
+  constexpr TimeInstant() noexcept : m_microseconds(0) {}
+
+  static constexpr TimeInstant from_microseconds(Rep microseconds) noexcept {
+    return TimeInstant(microseconds);
+  }
+
+  //! \throw std::overflow_error if the value cannot be represented
+  template <typename Integer,
+            typename = std::enable_if_t<std::is_integral<Integer>::value>>
+  static TimeInstant from_milliseconds(Integer milliseconds);
+
+  //! \throw std::overflow_error if the value cannot be represented
+  static TimeInstant from_milliseconds(double milliseconds);
+
+  constexpr Rep count_microseconds() const noexcept { return m_microseconds; }
+
+  //! \return the time in milliseconds (the legacy floating representation)
+  constexpr double to_milliseconds() const noexcept {
+    return static_cast<double>(m_microseconds) / MICROSECONDS_PER_MILLISECOND;
+  }
+
+  constexpr TimeInstant& operator+=(const TimeInstant& other) noexcept {
+    m_microseconds += other.m_microseconds;
+    return *this;
+  }
+
+  constexpr TimeInstant& operator-=(const TimeInstant& other) noexcept {
+    m_microseconds -= other.m_microseconds;
+    return *this;
+  }
+
+  friend constexpr TimeInstant operator+(TimeInstant lhs,
+                                         const TimeInstant& rhs) noexcept {
+    return lhs += rhs;
+  }
+
+  friend constexpr TimeInstant operator-(TimeInstant lhs,
+                                         const TimeInstant& rhs) noexcept {
+    return lhs -= rhs;
+  }
+
+  friend constexpr TimeInstant operator*(Rep factor,
+                                         const TimeInstant& time) noexcept {
+    return TimeInstant(factor * time.m_microseconds);
+  }
+
+  friend constexpr TimeInstant operator*(const TimeInstant& time,
+                                         Rep factor) noexcept {
+    return TimeInstant(time.m_microseconds * factor);
+  }
+
+  friend constexpr TimeInstant operator/(const TimeInstant& time,
+                                         Rep divisor) noexcept {
+    return TimeInstant(time.m_microseconds / divisor);
+  }
+
+  friend constexpr bool operator==(const TimeInstant& lhs,
+                                   const TimeInstant& rhs) noexcept {
+    return lhs.m_microseconds == rhs.m_microseconds;
+  }
+  friend constexpr bool operator!=(const TimeInstant& lhs,
+                                   const TimeInstant& rhs) noexcept {
+    return lhs.m_microseconds != rhs.m_microseconds;
+  }
+  friend constexpr bool operator<(const TimeInstant& lhs,
+                                  const TimeInstant& rhs) noexcept {
+    return lhs.m_microseconds < rhs.m_microseconds;
+  }
+  friend constexpr bool operator>(const TimeInstant& lhs,
+                                  const TimeInstant& rhs) noexcept {
+    return lhs.m_microseconds > rhs.m_microseconds;
+  }
+  friend constexpr bool operator<=(const TimeInstant& lhs,
+                                   const TimeInstant& rhs) noexcept {
+    return lhs.m_microseconds <= rhs.m_microseconds;
+  }
+  friend constexpr bool operator>=(const TimeInstant& lhs,
+                                   const TimeInstant& rhs) noexcept {
+    return lhs.m_microseconds >= rhs.m_microseconds;
+  }
+
+ private:
+  Rep m_microseconds;
+
+  explicit constexpr TimeInstant(Rep microseconds) noexcept
+      : m_microseconds(microseconds) {}
+};
+
+template <typename Integer, typename>
+TimeInstant TimeInstant::from_milliseconds(Integer milliseconds) {
+  constexpr Rep max_milliseconds =
+      std::numeric_limits<Rep>::max() / MICROSECONDS_PER_MILLISECOND;
+  constexpr Rep min_milliseconds =
+      std::numeric_limits<Rep>::min() / MICROSECONDS_PER_MILLISECOND;
+
+  bool in_range;
+  if constexpr (std::is_signed<Integer>::value) {
+    const auto value = static_cast<std::intmax_t>(milliseconds);
+    in_range = value >= min_milliseconds && value <= max_milliseconds;
+  } else {
+    const auto value = static_cast<std::uintmax_t>(milliseconds);
+    in_range = value <= static_cast<std::uintmax_t>(max_milliseconds);
+  }
+
+  if (!in_range) {
+    throw std::overflow_error("Time instant: milliseconds out of range");
+  }
+  return TimeInstant(static_cast<Rep>(milliseconds) *
+                     MICROSECONDS_PER_MILLISECOND);
+}
+
+inline TimeInstant TimeInstant::from_milliseconds(double milliseconds) {
+  const double microseconds =
+      std::round(milliseconds * MICROSECONDS_PER_MILLISECOND);
+
+  // The bounds are exactly representable as double (powers of two)
+  if (!(microseconds >=
+            static_cast<double>(std::numeric_limits<Rep>::min()) &&
+        microseconds <
+            -static_cast<double>(std::numeric_limits<Rep>::min()))) {
+    throw std::overflow_error("Time instant: milliseconds out of range");
+  }
+  return TimeInstant(static_cast<Rep>(microseconds));
+}
+
+//! Print the time in milliseconds (as the legacy representation)
+inline std::ostream& operator<<(std::ostream& os, const TimeInstant& time) {
+  return os << time.to_milliseconds();
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__TIME_INSTANT__HPP
@@ -0,0 +1,268 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON__WORK_STEALING_SCHEDULER__HPP
+#define __OPT_COMMON__WORK_STEALING_SCHEDULER__HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace opt_common {
+
+/*! Pool of workers running fine-grained tasks.
+    Every worker has its own deque: it runs its tasks in LIFO order and, when
+    it has none, it steals the oldest task of another worker. Tasks can spawn
+    other tasks (nested parallelism); waiting for a TaskGroup runs tasks
+    instead of blocking, so a task can wait for its children.
+ */
+class WorkStealingScheduler {
+ public:
+  //! A set of tasks to wait for
+  class TaskGroup {
+   public:
+    explicit TaskGroup(WorkStealingScheduler* scheduler)
+        : m_scheduler(scheduler) {}
+
+    //! Wait for the tasks still running (their errors are ignored)
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void spawn(std::function<void()> function);
+
+    /*! Run tasks until all the tasks of the group are completed.
+        \throw the first exception thrown by a task of the group
+     */
+    void wait();
+
+   private:
+    friend class WorkStealingScheduler;
+
+    WorkStealingScheduler* m_scheduler;
+    std::atomic<std::size_t> m_pending{0};
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+    std::condition_variable m_completed;
+
+    void wait_completion() noexcept;
+  };
+
+  //! 0 workers means one for each hardware thread
+  explicit WorkStealingScheduler(unsigned n_workers = 0);
+
+  //! \note All the task groups must be completed
+  ~WorkStealingScheduler();
+
+  WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+  WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+  unsigned get_number_of_workers() const noexcept {
+    return static_cast<unsigned>(m_workers.size());
+  }
+
+ private:
+  struct Task {
+    std::function<void()> function;
+    TaskGroup* group;
+  };
+
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  //! The worker running on the current thread (if any)
+  struct CurrentWorker {
+    const WorkStealingScheduler* scheduler = nullptr;
+    std::size_t index = 0;
+  };
+
+  // One queue for each worker, the last one for the other threads
+  std::vector<std::unique_ptr<TaskQueue>> m_queues;
+  std::vector<std::thread> m_workers;
+
+  std::atomic<std::size_t> m_n_queued{0};
+  std::atomic<bool> m_stop{false};
+  std::mutex m_idle_mutex;
+  std::condition_variable m_idle;
+
+  static CurrentWorker& get_current_worker() noexcept {
+    thread_local CurrentWorker current_worker;
+    return current_worker;
+  }
+
+  //! \return the queue of the current thread
+  std::size_t get_current_queue() const noexcept;
+
+  void push(Task task);
+
+  //! Run one task, from the own queue or stolen from another one
+  //! \return false if there is no task to run
+  bool try_run_one(std::size_t own_queue);
+
+  void worker_loop(std::size_t index);
+};
+
+inline WorkStealingScheduler::WorkStealingScheduler(unsigned n_workers) {
+  if (n_workers == 0) {
+    n_workers = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  for (unsigned i = 0; i <= n_workers; ++i) {
+    m_queues.push_back(std::make_unique<TaskQueue>());
+  }
+  for (unsigned i = 0; i < n_workers; ++i) {
+    m_workers.emplace_back(&WorkStealingScheduler::worker_loop, this, i);
+  }
+}
+
+inline WorkStealingScheduler::~WorkStealingScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(m_idle_mutex);
+    m_stop = true;
+  }
+  m_idle.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+inline std::size_t WorkStealingScheduler::get_current_queue() const noexcept {
+  const CurrentWorker& current_worker = get_current_worker();
+  return current_worker.scheduler == this ? current_worker.index
+                                          : m_workers.size();
+}
+
+inline void WorkStealingScheduler::push(Task task) {
+  TaskQueue& queue = *m_queues[get_current_queue()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  ++m_n_queued;
+
+  // Synchronize with a worker going to sleep
+  { std::lock_guard<std::mutex> lock(m_idle_mutex); }
+  m_idle.notify_one();
+}
+
+inline bool WorkStealingScheduler::try_run_one(std::size_t own_queue) {
+  Task task;
+  bool found = false;
+
+  // The newest own task first (its data is likely still in cache)
+  {
+    TaskQueue& queue = *m_queues[own_queue];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      found = true;
+    }
+  }
+
+  // Otherwise steal the oldest task of another queue
+  for (std::size_t i = 1; !found && i < m_queues.size(); ++i) {
+    TaskQueue& queue = *m_queues[(own_queue + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      found = true;
+    }
+  }
+
+  if (!found) {
+    return false;
+  }
+  --m_n_queued;
+
+  TaskGroup* const group = task.group;
+  try {
+    task.function();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(group->m_mutex);
+    if (!group->m_error) {
+      group->m_error = std::current_exception();
+    }
+  }
+
+  // The group can be destroyed as soon as its waiter sees the last task
+  // completed: it is touched only while holding its mutex
+  std::lock_guard<std::mutex> lock(group->m_mutex);
+  if (--group->m_pending == 0) {
+    group->m_completed.notify_all();
+  }
+  return true;
+}
+
+inline void WorkStealingScheduler::worker_loop(std::size_t index) {
+  get_current_worker() = CurrentWorker{this, index};
+
+  while (!m_stop) {
+    if (!try_run_one(index)) {
+      std::unique_lock<std::mutex> lock(m_idle_mutex);
+      m_idle.wait(lock, [this]() { return m_stop || m_n_queued > 0; });
+    }
+  }
+}
+
+inline WorkStealingScheduler::TaskGroup::~TaskGroup() { wait_completion(); }
+
+inline void WorkStealingScheduler::TaskGroup::spawn(
+    std::function<void()> function) {
+  ++m_pending;
+  m_scheduler->push(Task{std::move(function), this});
+}
+
+inline void WorkStealingScheduler::TaskGroup::wait_completion() noexcept {
+  const std::size_t own_queue = m_scheduler->get_current_queue();
+  while (m_pending > 0) {
+    if (!m_scheduler->try_run_one(own_queue)) {
+      // The tasks left are running on other workers
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_completed.wait_for(lock, std::chrono::microseconds(100),
+                           [this]() { return m_pending == 0; });
+    }
+  }
+
+  // Wait for the last task to release the group
+  std::lock_guard<std::mutex> lock(m_mutex);
+}
+
+inline void WorkStealingScheduler::TaskGroup::wait() {
+  wait_completion();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_error) {
+    std::rethrow_exception(std::exchange(m_error, nullptr));
+  }
+}
+
+}  // namespace opt_common
+
+#endif  // __OPT_COMMON__WORK_STEALING_SCHEDULER__HPP
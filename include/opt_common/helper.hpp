@@ -17,19 +17,23 @@ limitations under the License.
 #ifndef __OPT_COMMON__HELPER__HPP
 #define __OPT_COMMON__HELPER__HPP
 #include <algorithm>
+#include <cassert>
+#include <charconv>
 #include <cstdint>
 #include <fstream>
+#include <opt_common/CompressedFile.hpp>
+#include <opt_common/TimeInstant.hpp>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 #define THROW_RUNTIME_ERROR(message) throw std::runtime_error(message)
 
 namespace opt_common {
 
-using TimeInstant = long double;
-
 using CSV_Line = std::vector<std::string>;
 using CSV_Data = std::vector<CSV_Line>;
 
@@ -44,10 +48,107 @@ inline std::string get_dagsim_command(const std::string& lua_filename,
   return com;
 }
 
+//! Split a line of a CSV file in its values
+inline CSV_Line parse_csv_line(std::string line) {
+  // Remove all '\r' from line
+  const auto new_end = std::remove(line.begin(), line.end(), '\r');
+  line.erase(new_end, line.end());
+
+  CSV_Line csv_row;
+
+  // Scan for value in line
+  while (line.empty() == false) {
+    // Trim whitespace
+    line.erase(0, line.find_first_not_of(' '));
+
+    const bool quoted = (line.at(0) == '"');
+    std::string::size_type index_sep;
+
+    if (quoted == true) {
+      const auto index_close_quote = line.find('"', 1);
+      index_sep = line.find(',', index_close_quote);
+    } else {
+      index_sep = line.find(',');
+    }
+
+    const std::string value = line.substr(0, index_sep);
+    csv_row.push_back(std::move(value));
+    line.erase(0, index_sep);
+
+    // Trim whitespace
+    line.erase(0, line.find_first_not_of(" ,"));
+  }
+
+  return csv_row;
+}
+
+/*! Call `handle_line(std::string_view)` for each row of a compressed CSV
+    file. The file is read and decompressed by a DecompressingReader while
+    the rows are handled, so the decompressed data is never held in memory
+    as a whole.
+    The rows before `offset` (in the decompressed data) are skipped.
+    \return the offset after the last row read (see read_csv_file_from_offset)
+ */
+template <typename Function>
+std::uint64_t for_each_compressed_line_from_offset(
+    const std::string& csv_namefile, Compression compression,
+    std::uint64_t offset, Function handle_line, bool read_incomplete_row) {
+  DecompressingReader reader(csv_namefile, compression);
+
+  std::uint64_t to_skip = offset;
+  std::string pending, chunk;
+  while (reader.read_chunk(&chunk)) {
+    if (to_skip >= chunk.size()) {
+      to_skip -= chunk.size();
+      continue;
+    }
+    pending.append(chunk, to_skip, std::string::npos);
+    to_skip = 0;
+
+    const std::string_view rows(pending);
+    std::string_view::size_type begin_row = 0, end_row;
+    while ((end_row = rows.find('\n', begin_row)) != std::string_view::npos) {
+      handle_line(rows.substr(begin_row, end_row - begin_row));
+      begin_row = end_row + 1;
+    }
+    pending.erase(0, begin_row);
+    offset += begin_row;
+  }
+
+  if (read_incomplete_row && !pending.empty()) {
+    offset += pending.size();
+    handle_line(std::string_view(pending));
+  }
+
+  return offset;
+}
+
+//! Read the rows of a compressed CSV file (see
+//! for_each_compressed_line_from_offset)
+inline std::uint64_t read_compressed_csv_file(const std::string& csv_namefile,
+                                              Compression compression,
+                                              std::uint64_t offset,
+                                              CSV_Data* output_data,
+                                              bool read_incomplete_row) {
+  output_data->clear();
+  return for_each_compressed_line_from_offset(
+      csv_namefile, compression, offset,
+      [output_data](std::string_view line) {
+        output_data->push_back(parse_csv_line(std::string(line)));
+      },
+      read_incomplete_row);
+}
+
 inline void read_csv_file(const std::string& csv_namefile,
                           CSV_Data* output_data) {
   using namespace std::string_literals;
 
+  const Compression compression = detect_compression(csv_namefile);
+  if (compression != Compression::NONE) {
+    read_compressed_csv_file(csv_namefile, compression, 0, output_data, true);
+    return;
+  }
+
   std::ifstream file(csv_namefile);
   if (file.fail()) {
     THROW_RUNTIME_ERROR("In read CSV file: cannot open file '"s + csv_namefile +
@@ -58,63 +159,254 @@ inline void read_csv_file(const std::string& csv_namefile,
 
   std::string line;
   while (std::getline(file, line)) {
-    // Remove all '\r' from line
-    const auto new_end = std::remove(line.begin(), line.end(), '\r');
-    line.erase(new_end, line.end());
+    output_data->push_back(parse_csv_line(std::move(line)));
+  }
+}
+
+/*! Call `handle_line(std::string_view)` for each row of a CSV file starting
+    from the byte `offset`, which must be the beginning of a row. The lines
+    are views on a buffer of the function: no line is kept after its call.
+    Unless `read_incomplete_row` is set, only the rows terminated by a new
+    line are read, so a file which is still being written can be read again
+    from the returned offset.
+    Compressed files (.gz, .zst) are decompressed from the beginning and
+    `offset` refers to the decompressed data.
+    \return the offset after the last row read
+ */
+template <typename Function>
+std::uint64_t for_each_line_from_offset(const std::string& csv_namefile,
+                                        std::uint64_t offset,
+                                        Function handle_line,
+                                        bool read_incomplete_row = false) {
+  using namespace std::string_literals;
+
+  const Compression compression = detect_compression(csv_namefile);
+  if (compression != Compression::NONE) {
+    return for_each_compressed_line_from_offset(
+        csv_namefile, compression, offset, std::move(handle_line),
+        read_incomplete_row);
+  }
+
+  std::ifstream file(csv_namefile, std::ios::binary);
+  if (file.fail()) {
+    THROW_RUNTIME_ERROR("In read CSV file: cannot open file '"s + csv_namefile +
+                        "'");
+  }
+
+  // Read everything has been appended after the offset
+  file.seekg(0, std::ios::end);
+  const std::uint64_t file_size = file.tellg();
+  if (file_size <= offset) {
+    return offset;
+  }
+  std::string appended(file_size - offset, '\0');
+  file.seekg(offset);
+  file.read(&appended[0], appended.size());
+  appended.resize(file.gcount());
+
+  // Ignore the last row if it is not complete yet
+  const bool complete_last_row =
+      read_incomplete_row && !appended.empty() && appended.back() != '\n';
+  if (complete_last_row) {
+    appended.push_back('\n');
+  }
+  const auto end_last_row = appended.rfind('\n');
+  if (end_last_row == std::string::npos) {
+    return offset;
+  }
 
-    CSV_Line csv_row;
+  const std::string_view rows(appended);
+  std::string_view::size_type begin_row = 0;
+  while (begin_row <= end_last_row) {
+    const auto end_row = rows.find('\n', begin_row);
+    handle_line(rows.substr(begin_row, end_row - begin_row));
+    begin_row = end_row + 1;
+  }
 
-    // Scan for value in line
-    while (line.empty() == false) {
-      // Trim whitespace
-      line.erase(0, line.find_first_not_of(' '));
+  return offset + end_last_row + (complete_last_row ? 0 : 1);
+}
 
-      const bool quoted = (line.at(0) == '"');
-      std::string::size_type index_sep;
+/*! Read the rows of a CSV file starting from the byte `offset` (see
+    for_each_line_from_offset).
+    \return the offset after the last row read
+ */
+inline std::uint64_t read_csv_file_from_offset(
+    const std::string& csv_namefile, std::uint64_t offset,
+    CSV_Data* output_data, bool read_incomplete_row = false) {
+  output_data->clear();
+  return for_each_line_from_offset(
+      csv_namefile, offset,
+      [output_data](std::string_view line) {
+        output_data->push_back(parse_csv_line(std::string(line)));
+      },
+      read_incomplete_row);
+}
 
-      if (quoted == true) {
-        const auto index_close_quote = line.find('"', 1);
-        index_sep = line.find(',', index_close_quote);
-      } else {
-        index_sep = line.find(',');
-      }
+/*! \return the first line of a (possibly compressed) file, without reading
+    the rest of the file (e.g. the header of a CSV file, see
+    read_first_line_of_file)
+ */
+inline std::string read_first_line(const std::string& namefile) {
+  return read_first_line_of_file(namefile, detect_compression(namefile));
+}
 
-      const std::string value = line.substr(0, index_sep);
-      csv_row.push_back(std::move(value));
-      line.erase(0, index_sep);
+//! Remove leading and trailing characters in `chars` from `str`.
+inline std::string_view trim_view(std::string_view str,
+                                  std::string_view chars = " ") noexcept {
+  const auto first = str.find_first_not_of(chars);
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = str.find_last_not_of(chars);
+  return str.substr(first, last - first + 1);
+}
 
-      // Trim whitespace
-      line.erase(0, line.find_first_not_of(" ,"));
+/*! Find the value at `index` in a line of a CSV file, without splitting the
+    whole line (the values are separated as in parse_csv_line).
+    \return false if the line has not enough values.
+ */
+inline bool get_csv_field(std::string_view line, std::size_t index,
+                          std::string_view* field) noexcept {
+  for (std::size_t i = 0;; ++i) {
+    line = trim_view(line, " \r");
+
+    std::string_view::size_type index_sep;
+    if (line.empty() == false && line.front() == '"') {
+      index_sep = line.find(',', line.find('"', 1));
+    } else {
+      index_sep = line.find(',');
     }
 
-    output_data->push_back(std::move(csv_row));
+    if (i == index) {
+      *field = trim_view(line.substr(0, index_sep), " \r");
+      return true;
+    }
+    if (index_sep == std::string_view::npos) {
+      return false;
+    }
+    line.remove_prefix(index_sep + 1);
   }
 }
 
-inline std::vector<int> parse_string_as_vector_of_numbers(std::string str) {
-  // str is in the form: "[1, 2, 3]" or "[]"
-  // TODO(biagio): to implement
+/*! Call `handle_line(std::string_view)` for each line of a (possibly
+    compressed) file. The file is read on other threads while the lines are
+    handled; no line is kept after its call.
+ */
+template <typename Function>
+void for_each_line(const std::string& namefile, Function handle_line) {
+  DecompressingReader reader(namefile, detect_compression(namefile));
+
+  std::string pending, chunk;
+  while (reader.read_chunk(&chunk)) {
+    pending.append(chunk);
+
+    const std::string_view lines(pending);
+    std::string_view::size_type begin_line = 0, end_line;
+    while ((end_line = lines.find('\n', begin_line)) !=
+           std::string_view::npos) {
+      handle_line(lines.substr(begin_line, end_line - begin_line));
+      begin_line = end_line + 1;
+    }
+    pending.erase(0, begin_line);
+  }
 
-  // Trim the string
-  str.erase(0, str.find_first_not_of(" []\""));
-  str.erase(str.find_last_not_of(" []\"") + 1);
+  if (pending.empty() == false) {
+    handle_line(std::string_view(pending));
+  }
+}
 
-  std::vector<int> numbers;
+/*! Parse an unsigned decimal number (surrounding blanks are ignored).
+    \return false if `str` is not a number or it does not fit in T.
+ */
+template <typename T>
+bool parse_number(std::string_view str, T* output) noexcept {
+  str = trim_view(str);
+  if (str.empty()) {
+    return false;
+  }
+
+  const char* const last = str.data() + str.size();
+  const auto result = std::from_chars(str.data(), last, *output);
+  return result.ec == std::errc() && result.ptr == last;
+}
+
+/*! Parse a list of numbers in the form "[1, 2, 3]" or "[]" (possibly quoted)
+    appending the numbers to `output` (any container with push_back).
+    The buffer is not cleared, so the caller can reuse its capacity.
+    \return false if the list is malformed (`output` may hold part of it).
+ */
+template <typename Container>
+bool parse_list_of_numbers(std::string_view str, Container* output) {
+  str = trim_view(str, " []\"");
 
   while (str.empty() == false) {
-    // Trim the string
-    str.erase(0, str.find_first_not_of(" "));
     const auto finder = str.find(',');
-    const std::string val = str.substr(0, finder);
-    const int num = std::stoi(val);
-    numbers.push_back(num);
-    str.erase(0, finder);
-    str.erase(0, str.find_first_not_of(", "));
+    typename Container::value_type num;
+    if (parse_number(str.substr(0, finder), &num) == false) {
+      return false;
+    }
+    output->push_back(num);
+
+    if (finder == std::string_view::npos) {
+      break;
+    }
+    str.remove_prefix(finder + 1);
+    if (trim_view(str).empty()) {
+      // Trailing comma
+      return false;
+    }
   }
 
+  return true;
+}
+
+inline std::vector<int> parse_string_as_vector_of_numbers(
+    const std::string& str) {
+  // str is in the form: "[1, 2, 3]" or "[]"
+  std::vector<int> numbers;
+  if (parse_list_of_numbers(str, &numbers) == false) {
+    THROW_RUNTIME_ERROR("Parsing list of numbers: malformed list '" + str +
+                        "'");
+  }
   return numbers;
 }
 
+//! \return `str` escaped to be written in a JSON string
+inline std::string json_escape(std::string_view str) {
+  static constexpr char hex_digits[] = "0123456789abcdef";
+
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          escaped += "\\u00";
+          escaped += hex_digits[(c >> 4) & 0xF];
+          escaped += hex_digits[c & 0xF];
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
 template <typename T>
 typename std::vector<T>::difference_type compute_maxmin_get_index_impl(
     const std::vector<T>& v, bool max) {
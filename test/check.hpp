@@ -0,0 +1,63 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON_TEST__CHECK__HPP
+#define __OPT_COMMON_TEST__CHECK__HPP
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+//! Stop the test if `condition` is false
+#define CHECK(condition)                                                   \
+  do {                                                                     \
+    if (!(condition)) {                                                    \
+      std::cerr << __FILE__ << ":" << __LINE__                             \
+                << ": check failed: " #condition << std::endl;             \
+      std::exit(EXIT_FAILURE);                                             \
+    }                                                                      \
+  } while (false)
+
+//! Stop the test if `lhs` and `rhs` differ more than `tolerance`
+#define CHECK_NEAR(lhs, rhs, tolerance)                                    \
+  do {                                                                     \
+    const double check_lhs = (lhs), check_rhs = (rhs);                     \
+    if (!(std::abs(check_lhs - check_rhs) <= (tolerance))) {               \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #lhs \
+                << " (" << check_lhs << ") near " #rhs << " ("            \
+                << check_rhs << ")" << std::endl;                          \
+      std::exit(EXIT_FAILURE);                                             \
+    }                                                                      \
+  } while (false)
+
+//! Stop the test if `statement` does not throw
+#define CHECK_THROWS(statement)                                            \
+  do {                                                                     \
+    bool check_thrown = false;                                             \
+    try {                                                                  \
+      statement;                                                           \
+    } catch (const std::exception&) {                                      \
+      check_thrown = true;                                                 \
+    }                                                                      \
+    if (!check_thrown) {                                                   \
+      std::cerr << __FILE__ << ":" << __LINE__                             \
+                << ": check failed: " #statement " did not throw"          \
+                << std::endl;                                              \
+      std::exit(EXIT_FAILURE);                                             \
+    }                                                                      \
+  } while (false)
+
+#endif  // __OPT_COMMON_TEST__CHECK__HPP
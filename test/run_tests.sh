@@ -0,0 +1,39 @@
+#!/bin/sh
+# Build and run the tests (from any directory):
+#   test/run_tests.sh [EXTRA_COMPILER_FLAGS...]
+# Each test/test_*.cpp is a program returning 0 if all its checks pass.
+# A test needing more flags (e.g. libraries) lists them on a line
+#   // Build flags: FLAGS...
+set -u
+
+ROOT_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=${BUILD_DIR:-$ROOT_DIR/_test_build}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -Wall -Wextra -O1 -g -fsanitize=address,undefined}
+
+# zstd is optional: the tests of compressed traces use it if installed
+ZSTD_FLAGS=
+if echo '#include <zstd.h>' | $CXX $CXXFLAGS "$@" -x c++ -fsyntax-only - \
+    > /dev/null 2>&1; then
+  ZSTD_FLAGS="-DOPT_COMMON_WITH_ZSTD -lzstd"
+fi
+
+mkdir -p "$BUILD_DIR"
+failed=0
+for source in "$ROOT_DIR"/test/test_*.cpp; do
+  name=$(basename "$source" .cpp)
+  test_flags=$(sed -n 's|^// Build flags: ||p' "$source")
+  eval "test_flags=\"$test_flags\""
+  if ! $CXX $CXXFLAGS "$@" -I"$ROOT_DIR/include" -I"$ROOT_DIR" "$source" \
+      $test_flags -o "$BUILD_DIR/$name" -pthread -lrt; then
+    echo "FAIL (build) $name"
+    failed=$((failed + 1))
+  elif ! "$BUILD_DIR/$name" > "$BUILD_DIR/$name.log" 2>&1; then
+    echo "FAIL $name (see $BUILD_DIR/$name.log)"
+    failed=$((failed + 1))
+  else
+    echo "ok   $name"
+  fi
+done
+
+[ "$failed" -eq 0 ]
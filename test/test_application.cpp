@@ -0,0 +1,179 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <opt_common/Application.hpp>
+#include <string>
+#include <utility>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::TimeInstant;
+
+namespace {
+
+Application load_reference(const opt_common_test::TemporaryDirectory& dir) {
+  opt_common_test::QuietStdout quiet;
+  const std::string input = opt_common_test::write_reference_trace(
+      dir.get_path());
+  return Application::create_application(input,
+                                         dir.get_path() + "/config.txt");
+}
+
+void check_reference(const Application& app) {
+  CHECK(app.get_application_id() == "app_1");
+  CHECK(app.get_all_stages().size() == 3);
+  CHECK(app.get_all_jobs().size() == 2);
+  CHECK_NEAR(app.compute_avg_execution_time(1).to_milliseconds(), 25191, 0);
+  CHECK_NEAR(app.compute_avg_execution_time(2).to_milliseconds(), 14181.5, 0);
+  CHECK_NEAR(app.get_real_execution_time().to_milliseconds(), 60000, 0);
+
+  // The dependencies live in the memory of the application
+  const auto& stage_2 = app.get_all_stages().at(2);
+  CHECK(stage_2.get_dependencies().size() == 2);
+  CHECK(app.get_all_jobs().at(0).get_id_stages().size() == 2);
+}
+
+void test_load() {
+  opt_common_test::TemporaryDirectory dir;
+  const Application app = load_reference(dir);
+  check_reference(app);
+
+  Application fitted = app;
+  fitted.set_alpha_beta(1, 4);
+  CHECK_NEAR(fitted.get_alpha(), 22304.33, 0.01);
+  CHECK_NEAR(fitted.get_beta(), 2886.67, 0.01);
+}
+
+// Assigned applications must stay valid after the source is destroyed
+void test_assignment() {
+  opt_common_test::TemporaryDirectory dir;
+
+  Application copy_assigned = load_reference(dir);
+  Application move_assigned = load_reference(dir);
+  {
+    auto source = std::make_unique<Application>(load_reference(dir));
+    copy_assigned = *source;
+    source.reset();
+  }
+  {
+    Application source = load_reference(dir);
+    move_assigned = std::move(source);
+  }
+  check_reference(copy_assigned);
+  check_reference(move_assigned);
+
+  // Self assignment and assignment over an empty application
+  copy_assigned = copy_assigned;
+  Application empty;
+  empty = move_assigned;
+  move_assigned = Application();
+  check_reference(copy_assigned);
+  check_reference(empty);
+  CHECK(move_assigned.get_all_stages().empty());
+}
+
+/*! Keep in `namefile` the content before `from` (e.g. the rows not written
+    yet by a running application).
+    \return the content removed
+ */
+std::string cut_file(const std::string& namefile, const std::string& from) {
+  std::ifstream ifs(namefile, std::ios::binary);
+  const std::string content((std::istreambuf_iterator<char>(ifs)),
+                            std::istreambuf_iterator<char>());
+  const auto position = content.find(from);
+  CHECK(position != std::string::npos);
+  opt_common_test::write_file(namefile, content.substr(0, position));
+  return content.substr(position);
+}
+
+// A running application is completed by the rows appended to its files
+void test_incremental_update() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  const std::string app_file = dir.get_path() + "/app.csv";
+  const std::string jobs_file = dir.get_path() + "/jobs.csv";
+  const std::string stages_file = dir.get_path() + "/stages.csv";
+  const std::string tasks_file = dir.get_path() + "/tasks.csv";
+
+  // Only the first job has run, a task row is being written
+  const std::string app_rest = cut_file(app_file, "app_1,61000");
+  const std::string jobs_rest = cut_file(jobs_file, "1,22000");
+  const std::string stages_rest = cut_file(stages_file, "2,s2");
+  const std::string tasks_rest =
+      cut_file(tasks_file, "57,3991,x,x,x,x,x,x,x,x,x,x,1");
+
+  opt_common_test::QuietStdout quiet;
+  Application app =
+      Application::create_application(input, dir.get_path() + "/config.txt");
+  CHECK(app.get_real_execution_time() == TimeInstant());
+  CHECK(app.get_all_jobs().size() == 1);
+  CHECK(app.get_all_stages().size() == 2);
+  CHECK(app.get_all_stages().at(1).get_number_of_tasks_times() == 0);
+  CHECK(app.update_from_appended_rows() == 0);
+
+  // Nothing new in the application file: still running
+  opt_common_test::append_file(tasks_file, tasks_rest.substr(0, 2));
+  CHECK(app.update_from_appended_rows() == 0);
+  CHECK(app.get_all_stages().at(1).get_number_of_tasks_times() == 0);
+
+  // The copies keep the rows read so far
+  const Application running = app;
+  opt_common_test::append_file(jobs_file, jobs_rest);
+  opt_common_test::append_file(stages_file, stages_rest);
+  opt_common_test::append_file(tasks_file, tasks_rest.substr(2));
+  opt_common_test::append_file(app_file, app_rest);
+  CHECK(app.update_from_appended_rows() == 1 + 1 + 1 + 5);
+  check_reference(app);
+  CHECK(app.update_from_appended_rows() == 0);
+  CHECK(running.get_real_execution_time() == TimeInstant());
+  CHECK(running.get_all_stages().size() == 2);
+}
+
+// A completed application has the tasks of all its stages
+void test_stage_without_tasks() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  const std::string config = dir.get_path() + "/config.txt";
+  const std::string tasks_file = dir.get_path() + "/tasks.csv";
+  cut_file(tasks_file, "x,x,x,x,1100,2959");
+
+  opt_common_test::QuietStdout quiet;
+  CHECK_THROWS(Application::create_application(input, config));
+
+  // Running: the tasks of the stage can still come
+  const std::string app_rest =
+      cut_file(dir.get_path() + "/app.csv", "app_1,61000");
+  Application app = Application::create_application(input, config);
+  CHECK(app.get_all_stages().size() == 3);
+  opt_common_test::append_file(dir.get_path() + "/app.csv", app_rest);
+  CHECK_THROWS(app.update_from_appended_rows());
+}
+
+}  // namespace
+
+int main() {
+  test_load();
+  test_assignment();
+  test_incremental_update();
+  test_stage_without_tasks();
+  return 0;
+}
@@ -0,0 +1,179 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <opt_common/Application.hpp>
+#include <opt_common/ApplicationHistory.hpp>
+#include <string>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::ApplicationHistory;
+
+namespace {
+
+std::string read_file(const std::string& namefile) {
+  std::ifstream ifs(namefile, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+}
+
+std::size_t count_runs(const std::string& index) {
+  return ApplicationHistory(index).get_profile("app_1").number_of_runs;
+}
+
+// Tasks of the stage 0 merged in the index (4 per run)
+std::uint64_t count_stage_0_tasks(const std::string& index) {
+  return ApplicationHistory(index)
+      .get_profile("app_1")
+      .stages.front()
+      .number_of_tasks_times;
+}
+
+void test_round_trip(const Application& app, const std::string& index) {
+  {
+    ApplicationHistory history(index);
+    CHECK(!history.has_application("app_1"));
+    CHECK(history.add_run(app, "run1"));
+    CHECK(history.add_run(app, "run2"));
+    CHECK(!history.add_run(app, "run2"));
+  }
+
+  // The replayed index has the same profile
+  ApplicationHistory history(index);
+  const auto profile = history.get_profile("app_1");
+  CHECK(profile.number_of_runs == 2);
+  CHECK_NEAR(profile.avg_real_execution_time.to_milliseconds(), 60000, 0);
+  CHECK(profile.stages.size() == 3);
+  for (const auto& stage : profile.stages) {
+    const auto& original = app.get_all_stages().at(stage.stage_id);
+    CHECK(stage.number_of_tasks_times ==
+          2 * original.get_number_of_tasks_times());
+    CHECK(stage.avg_time == original.get_avg_time());
+    CHECK(stage.min_time == original.get_min_time());
+    CHECK(stage.max_time == original.get_max_time());
+  }
+
+  Application updated = app;
+  CHECK(history.apply_profile(&updated) == 3);
+  CHECK(updated.compute_avg_execution_time(2) ==
+        app.compute_avg_execution_time(2));
+}
+
+// A record with its checksum, as ApplicationHistory writes it
+std::string seal(const std::string& record) {
+  std::uint32_t hash = 0x811c9dc5u;
+  for (const char c : record) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 0x01000193u;
+  }
+  char checksum[16];
+  std::snprintf(checksum, sizeof(checksum), ",%08x\n", hash);
+  return record + checksum;
+}
+
+// The records of `run` for the stage 0 of the reference trace
+std::string stage_0_record(const std::string& run) {
+  return seal("S," + run + ",app_1,0,4,4,13258000,4.8e13,1258000,4116000");
+}
+
+// An append interrupted in the middle of a record is skipped
+void test_torn_tail(const Application& app, const std::string& index) {
+  const std::string committed = read_file(index);
+  const std::string run_record = committed.substr(committed.rfind("\nR,") + 1);
+
+  // The run record cut in a number, with and without the end of line
+  for (const std::string& torn :
+       {run_record.substr(0, 10), run_record.substr(0, 16) + "\n"}) {
+    const std::string content = committed + stage_0_record("run3") + torn;
+    opt_common_test::write_file(index, content);
+    CHECK(count_runs(index) == 2);
+    CHECK(read_file(index) == content);  // Not truncated
+  }
+
+  // Another process appends after a torn record and stage records of an
+  // interrupted append of the same run
+  ApplicationHistory history(index);
+  opt_common_test::append_file(index, stage_0_record("run3") +
+                                          stage_0_record("run3") +
+                                          "S,run3,app_1,0,4");
+  CHECK(history.add_run(app, "run3"));
+  CHECK(read_file(index).find("S,run3,app_1,0,4S") == std::string::npos);
+  CHECK(count_runs(index) == 3);
+  CHECK(count_stage_0_tasks(index) == 3 * 4);
+
+  // Only the last stage records of the run are committed with it
+  opt_common_test::append_file(index, stage_0_record("run4") +
+                                          stage_0_record("run4"));
+  CHECK(history.add_run(app, "run4"));
+  CHECK(count_runs(index) == 4);
+  CHECK(count_stage_0_tasks(index) == 4 * 4);
+}
+
+// The count, the average and the sum of squares are weighted alike
+void test_recency_weighted(const Application& app,
+                           const opt_common_test::TemporaryDirectory& dir) {
+  const std::string index = dir.get_path() + "/weighted.idx";
+  ApplicationHistory history(index, 0.5);
+  CHECK(history.add_run(app, "run1"));
+  CHECK(history.add_run(app, "run2"));
+
+  // Two equal runs: 1.5 weighted runs of 4 tasks, rounded to 6 tasks times
+  const auto profile = history.get_profile("app_1", true);
+  for (const auto& stage : profile.stages) {
+    const auto& original = app.get_all_stages().at(stage.stage_id);
+    const auto count = original.get_number_of_tasks_times();
+    CHECK(stage.number_of_tasks_times == (3 * count + 1) / 2);
+    CHECK(stage.avg_time == original.get_avg_time());
+    CHECK_NEAR(stage.sum_of_squares / stage.number_of_tasks_times,
+               original.get_tasks_times_sum_of_squares() / count,
+               1e-9 * original.get_tasks_times_sum_of_squares());
+  }
+
+  Application updated = app;
+  CHECK(history.apply_profile(&updated, true) == 3);
+  CHECK(updated.compute_avg_execution_time(2) ==
+        app.compute_avg_execution_time(2));
+}
+
+void test_invalid_record(const std::string& index) {
+  // A record with a valid checksum and an invalid content
+  opt_common_test::append_file(index,
+                               seal("R,run5,app_1,not_a_number,0"));
+  CHECK_THROWS(ApplicationHistory history(index));
+}
+
+}  // namespace
+
+int main() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  const std::string index = dir.get_path() + "/history.idx";
+
+  opt_common_test::QuietStdout quiet;
+  const Application app = Application::create_application(
+      input, dir.get_path() + "/config.txt");
+
+  test_round_trip(app, index);
+  test_torn_tail(app, index);
+  test_recency_weighted(app, dir);
+  test_invalid_record(index);
+  return 0;
+}
@@ -0,0 +1,166 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <opt_common/Application.hpp>
+#include <opt_common/BatchOptimizer.hpp>
+#include <opt_common/CommandLineParser.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::BatchOptimizer;
+using opt_common::CommandLineParser;
+
+namespace {
+
+// The optimizations written are the optimizations read
+void test_manifest_round_trip() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string manifest = dir.get_path() + "/manifest.txt";
+  opt_common_test::write_file(manifest,
+                              "# input method options\n"
+                              "a.txt -f\n"
+                              "\n"
+                              "  b.txt -b --no-ml --hybrid --deadline 5000 "
+                              "-c cf\r\n");
+
+  const auto entries = BatchOptimizer::read_manifest(manifest);
+  CHECK(entries.size() == 2);
+  CHECK(entries[0].name_of_file == "a.txt");
+  CHECK(entries[0].optimize_method ==
+        CommandLineParser::OptimizeMethod::FAST_OPTIMIZATION);
+  CHECK(!entries[0].no_ml && !entries[0].hybrid);
+  CHECK(entries[0].deadline == 0 && entries[0].config_file.empty());
+
+  CHECK(entries[1].name_of_file == "b.txt");
+  CHECK(entries[1].optimize_method ==
+        CommandLineParser::OptimizeMethod::FAST_BISECT_OPTIMIZATION);
+  CHECK(entries[1].no_ml && entries[1].hybrid);
+  CHECK(entries[1].deadline == 5000 && entries[1].config_file == "cf");
+}
+
+// The options of the other modes are not optimizations
+void test_manifest_rejects_other_modes() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string manifest = dir.get_path() + "/manifest.txt";
+  for (const std::string line :
+       {"a.txt -f -j 8", "a.txt -f --max-in-flight 2", "a.txt -f --socket s",
+        "--batch other.txt", "--daemon", "a.txt", "a.txt -f --deadline"}) {
+    opt_common_test::write_file(manifest, "b.txt -f\n" + line + "\n");
+    CHECK_THROWS(BatchOptimizer::read_manifest(manifest));
+  }
+}
+
+/*! \return the result lines written by a run, sorted by index. The logs
+    are written on `log` (if not nullptr)
+ */
+std::vector<std::string> run_batch(
+    const std::vector<CommandLineParser::CommandLineOptions>& entries,
+    const std::string& config_file,
+    opt_common::WorkStealingScheduler* scheduler, std::size_t* errors,
+    std::ostream* log = nullptr) {
+  const BatchOptimizer batch(
+      config_file, [](Application* app,
+                      const CommandLineParser::CommandLineOptions&,
+                      std::ostream* app_log) {
+        std::ostringstream result;
+        result << app->get_deadline().to_milliseconds();
+        if (app_log != nullptr) {
+          *app_log << "\nOptimized " << result.str() << "\n";
+        }
+        return result.str();
+      });
+
+  std::ostringstream output;
+  *errors = batch.run(entries, 0, scheduler, &output, log);
+
+  std::vector<std::string> lines;
+  std::istringstream iss(output.str());
+  for (std::string line; std::getline(iss, line);) {
+    lines.push_back(line);
+  }
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+
+void test_run() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  const std::string manifest = dir.get_path() + "/manifest.txt";
+  opt_common_test::write_file(manifest,
+                              input + " -f\n" + input +
+                                  " -b --deadline 7000\n" + dir.get_path() +
+                                  "/missing.txt -f\n");
+  const auto entries = BatchOptimizer::read_manifest(manifest);
+
+  // Nothing is written on the standard output
+  std::ostringstream standard_output;
+  std::streambuf* const buffer = std::cout.rdbuf(standard_output.rdbuf());
+
+  // Concurrently and on the calling thread (no scheduler)
+  opt_common::WorkStealingScheduler scheduler(2);
+  for (auto* const run_scheduler :
+       {&scheduler, static_cast<opt_common::WorkStealingScheduler*>(nullptr)}) {
+    std::size_t errors;
+    std::ostringstream log;
+    const auto lines =
+        run_batch(entries, dir.get_path() + "/config.txt", run_scheduler,
+                  &errors, &log);
+    CHECK(errors == 1);
+    CHECK(lines.size() == 3);
+    CHECK(lines[0].find("{\"index\":0,\"input\":\"" + input +
+                        "\",\"status\":\"ok\",\"result\":\"50000\"") == 0);
+    CHECK(lines[1].find("{\"index\":1,") == 0);
+    CHECK(lines[1].find("\"result\":\"7000\"") != std::string::npos);
+    CHECK(lines[2].find("{\"index\":2,") == 0);
+    CHECK(lines[2].find("\"status\":\"error\",\"error\":\"") !=
+          std::string::npos);
+
+    // The log of each application is written at once, with its loading
+    const std::string log_str = log.str();
+    for (const std::string result : {"50000", "7000"}) {
+      const auto optimized = log_str.find("\nOptimized " + result + "\n");
+      CHECK(optimized != std::string::npos);
+      const auto loaded = log_str.rfind(" Optimizing configuration", optimized);
+      CHECK(loaded != std::string::npos);
+      CHECK(log_str.find("\nOptimized ", loaded) == optimized);
+    }
+  }
+  std::cout.rdbuf(buffer);
+  CHECK(standard_output.str().empty());
+
+  // A configuration which cannot be read fails its entries only
+  std::size_t errors;
+  const auto lines = run_batch(entries, dir.get_path() + "/missing_config",
+                               nullptr, &errors);
+  CHECK(errors == 3 && lines.size() == 3);
+}
+
+}  // namespace
+
+int main() {
+  test_manifest_round_trip();
+  test_manifest_rejects_other_modes();
+  test_run();
+  return 0;
+}
@@ -0,0 +1,132 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <opt_common/Application.hpp>
+#include <opt_common/ClusterSimulator.hpp>
+#include <opt_common/TimeInstant.hpp>
+#include <string>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::ClusterSimulator;
+using opt_common::TimeInstant;
+
+namespace {
+
+TimeInstant ms(double milliseconds) {
+  return TimeInstant::from_milliseconds(milliseconds);
+}
+
+// One stage of `tasks` tasks of 1000 ms each
+Application make_application(unsigned long tasks) {
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = 1;
+  spec.stages_per_job = 1;
+  spec.tasks_per_stage = tasks;
+  spec.task_time_jitter_ms = 0;
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  opt_common_test::QuietStdout quiet;
+  return Application::create_application(input,
+                                         dir.get_path() + "/config.txt");
+}
+
+// Two applications of 4 tasks arriving together on 2 single-core
+// containers: the first one served takes 2 waves (2000 ms), the other one
+// waits for it (4000 ms). The second one added has the earlier deadline.
+void test_fifo_and_edf() {
+  Application late = make_application(4);
+  late.set_deadline(ms(10000));
+  Application urgent = make_application(4);
+  urgent.set_deadline(ms(3000));
+
+  ClusterSimulator simulator(2);
+  simulator.add_application(late, TimeInstant());
+  simulator.add_application(urgent, TimeInstant());
+  CHECK(simulator.get_number_of_applications() == 2);
+
+  // By arrival (ties by addition): the urgent application misses
+  const auto fifo = simulator.run(ClusterSimulator::Policy::FIFO);
+  CHECK(fifo.applications.size() == 2);
+  CHECK(fifo.applications[0].completion_time == ms(2000));
+  CHECK(fifo.applications[1].completion_time == ms(4000));
+  CHECK(fifo.applications[1].deadline == ms(3000));
+  CHECK(!fifo.applications[0].deadline_missed);
+  CHECK(fifo.applications[1].deadline_missed);
+  CHECK(fifo.number_of_deadline_misses == 1);
+  CHECK(fifo.makespan == ms(4000));
+  CHECK_NEAR(fifo.utilization, 1, 1e-9);
+
+  // By deadline: both meet it
+  const auto edf = simulator.run(ClusterSimulator::Policy::EDF);
+  CHECK(edf.applications[0].completion_time == ms(4000));
+  CHECK(edf.applications[1].completion_time == ms(2000));
+  CHECK(edf.number_of_deadline_misses == 0);
+}
+
+// Weights 3 and 1 on 4 containers: 4 tasks on 3 cores take 2 waves
+// (2000 ms), then the other application (half done on 1 core) runs its
+// remaining wave on 4 cores in 500 ms
+void test_weighted_fair() {
+  Application heavy = make_application(4);
+  heavy.set_weight(3);
+  Application light = make_application(4);
+  light.set_weight(1);
+  light.set_deadline(ms(2400));
+
+  ClusterSimulator simulator(4);
+  simulator.add_application(light, TimeInstant());
+  simulator.add_application(heavy, TimeInstant());
+
+  const auto report = simulator.run(ClusterSimulator::Policy::WEIGHTED_FAIR);
+  CHECK(report.applications[0].completion_time == ms(2500));
+  CHECK(report.applications[1].completion_time == ms(2000));
+  CHECK(report.number_of_deadline_misses == 1);
+  CHECK(report.applications[0].deadline_missed);
+  CHECK(report.makespan == ms(2500));
+
+  // 8000 ms of tasks in 4 * 2500 ms of cores: the third core of the heavy
+  // application is idle in its second wave
+  CHECK_NEAR(report.utilization, 0.8, 1e-9);
+}
+
+// The cores of the containers count, the containers allocated do not
+void test_utilization() {
+  // 3 tasks on 2 containers of 2 cores: one wave, one core idle
+  ClusterSimulator simulator(2, 2);
+  simulator.add_application(make_application(3), ms(1000));
+
+  const auto report = simulator.run(ClusterSimulator::Policy::FIFO);
+  CHECK(report.applications[0].arrival_time == ms(1000));
+  CHECK(report.applications[0].completion_time == ms(2000));
+  CHECK(report.makespan == ms(1000));
+  CHECK_NEAR(report.utilization, 3.0 / 4, 1e-9);
+
+  CHECK_THROWS(ClusterSimulator(0));
+  CHECK_THROWS(ClusterSimulator(1, 0));
+}
+
+}  // namespace
+
+int main() {
+  test_fifo_and_edf();
+  test_weighted_fair();
+  test_utilization();
+  return 0;
+}
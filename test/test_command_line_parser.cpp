@@ -0,0 +1,99 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <opt_common/CommandLineParser.hpp>
+#include <string>
+#include <vector>
+#include "test/check.hpp"
+
+using opt_common::CommandLineParser;
+
+namespace {
+
+CommandLineParser::CommandLineOptions parse(std::vector<std::string> args) {
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(&arg[0]);
+  }
+  return CommandLineParser::parse_command_line(static_cast<int>(argv.size()),
+                                               argv.data());
+}
+
+void test_single_application() {
+  const auto options = parse({"opt", "input.txt", "-b", "--no-ml",
+                              "--hybrid", "--deadline", "5000", "-c", "cf"});
+  CHECK(options.name_of_file == "input.txt");
+  CHECK(options.optimize_method ==
+        CommandLineParser::OptimizeMethod::FAST_BISECT_OPTIMIZATION);
+  CHECK(options.no_ml && options.hybrid);
+  CHECK(options.deadline == 5000);
+  CHECK(options.config_file == "cf");
+  CHECK(!options.daemon_mode && !options.batch_mode);
+
+  CHECK_THROWS(parse({"opt", "input.txt", "-f", "--socket", "x"}));
+  CHECK_THROWS(parse({"opt", "input.txt", "-f", "-j", "8"}));
+  CHECK_THROWS(parse({"opt", "input.txt", "-f", "--max-in-flight", "2"}));
+  CHECK_THROWS(parse({"opt", "input.txt", "-f", "--deadline", "0"}));
+  CHECK_THROWS(parse({"opt", "input.txt", "-f", "--deadline"}));
+  CHECK_THROWS(parse({"opt", "input.txt", "-x"}));
+}
+
+void test_daemon() {
+  const auto options = parse({"opt", "--daemon", "--socket", "s", "-c", "cf"});
+  CHECK(options.daemon_mode);
+  CHECK(options.socket_path == "s");
+  CHECK(options.config_file == "cf");
+
+  CHECK_THROWS(parse({"opt", "--daemon", "--no-ml"}));
+  CHECK_THROWS(parse({"opt", "--daemon", "--deadline", "5"}));
+  CHECK_THROWS(parse({"opt", "--daemon", "-j", "4"}));
+}
+
+void test_batch() {
+  const auto options = parse({"opt", "--batch", "m.txt", "-j", "8",
+                              "--max-in-flight", "2", "-c", "cf"});
+  CHECK(options.batch_mode);
+  CHECK(options.manifest_file == "m.txt");
+  CHECK(options.number_of_threads == 8);
+  CHECK(options.max_in_flight == 2);
+  CHECK(options.config_file == "cf");
+
+  CHECK_THROWS(parse({"opt", "--batch"}));
+  CHECK_THROWS(parse({"opt", "--batch", "m.txt", "--deadline", "5"}));
+  CHECK_THROWS(parse({"opt", "--batch", "m.txt", "--hybrid"}));
+  CHECK_THROWS(parse({"opt", "--batch", "m.txt", "--socket", "s"}));
+  CHECK_THROWS(parse({"opt", "--batch", "m.txt", "-j", "x"}));
+}
+
+// The usage lists the options of each form
+void test_usage() {
+  CHECK(CommandLineParser::get_usage("opt") ==
+        "opt INPUT_FILE -f|-b [--no-ml] [--hybrid] [--deadline MS] "
+        "[-c CONFIG_FILE]\n"
+        "opt --daemon [--socket SOCKET_PATH] [-c CONFIG_FILE]\n"
+        "opt --batch MANIFEST_FILE [-j THREADS] [--max-in-flight N] "
+        "[-c CONFIG_FILE]\n");
+}
+
+}  // namespace
+
+int main() {
+  test_single_application();
+  test_daemon();
+  test_batch();
+  test_usage();
+  return 0;
+}
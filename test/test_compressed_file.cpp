@@ -0,0 +1,257 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Build flags: -DOPT_COMMON_WITH_ZLIB -lz $ZSTD_FLAGS
+// (run_tests.sh sets ZSTD_FLAGS when zstd.h is installed)
+
+#include <zlib.h>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <opt_common/Application.hpp>
+#include <opt_common/CompressedFile.hpp>
+#include <opt_common/helper.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+#ifdef OPT_COMMON_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+using opt_common::Application;
+using opt_common::Compression;
+
+namespace {
+
+std::string read_file(const std::string& namefile) {
+  std::ifstream ifs(namefile, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+}
+
+//! \return `content` as a gzip member
+std::string gzip(const std::string& content) {
+  z_stream stream{};
+  CHECK(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) == Z_OK);
+  std::string output(deflateBound(&stream, content.size()), '\0');
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+  stream.avail_in = static_cast<uInt>(content.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = static_cast<uInt>(output.size());
+  CHECK(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+  return output;
+}
+
+#ifdef OPT_COMMON_WITH_ZSTD
+//! \return `content` as a zstd frame with a checksum (as written by the
+//! zstd tool)
+std::string zstd(const std::string& content) {
+  ZSTD_CCtx* const context = ZSTD_createCCtx();
+  CHECK(!ZSTD_isError(
+      ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, 19)));
+  CHECK(!ZSTD_isError(
+      ZSTD_CCtx_setParameter(context, ZSTD_c_checksumFlag, 1)));
+  std::string output(ZSTD_compressBound(content.size()), '\0');
+  const std::size_t size = ZSTD_compress2(
+      context, &output[0], output.size(), content.data(), content.size());
+  ZSTD_freeCCtx(context);
+  CHECK(!ZSTD_isError(size));
+  output.resize(size);
+  return output;
+}
+#endif
+
+//! \return the rows of a CSV file (compressed or not)
+opt_common::CSV_Data read_rows(const std::string& namefile) {
+  opt_common::CSV_Data rows;
+  opt_common::read_csv_file(namefile, &rows);
+  return rows;
+}
+
+void test_detect_compression() {
+  CHECK(opt_common::detect_compression("tasks.csv.gz") == Compression::GZIP);
+  CHECK(opt_common::detect_compression("tasks.csv.zst") == Compression::ZSTD);
+  CHECK(opt_common::detect_compression("tasks.csv") == Compression::NONE);
+  CHECK(opt_common::detect_compression("gz") == Compression::NONE);
+}
+
+/*! A compressed trace is loaded as its plain text version, with the
+    compressed files written by `compress` (with the extension
+    `extension`)
+ */
+template <typename Compress>
+void check_compressed_trace(const std::string& extension, Compress compress) {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string plain_input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  const std::string config = dir.get_path() + "/config.txt";
+  for (const std::string name : {"app.csv", "jobs.csv", "stages.csv",
+                                 "tasks.csv"}) {
+    const std::string plain = dir.get_path() + "/" + name;
+    opt_common_test::write_file(plain + extension,
+                                compress(read_file(plain)));
+    CHECK(read_rows(plain + extension) == read_rows(plain));
+    CHECK(opt_common::read_first_line(plain + extension) ==
+          opt_common::read_first_line(plain));
+  }
+  const std::string input = dir.get_path() + "/compressed_input.txt";
+  opt_common_test::write_file(
+      input, "app.csv" + extension + " jobs.csv" + extension +
+                 " stages.csv" + extension + " tasks.csv" + extension +
+                 " app.lua infra.txt 50000\n");
+
+  opt_common_test::QuietStdout quiet;
+  const Application plain_app =
+      Application::create_application(plain_input, config);
+  const Application app = Application::create_application(input, config);
+  CHECK(app.get_all_stages().size() == 3);
+  CHECK(app.get_all_jobs().size() == 2);
+  CHECK(app.get_real_execution_time() == plain_app.get_real_execution_time());
+  for (const unsigned n_cores : {1, 2, 4}) {
+    CHECK(app.compute_avg_execution_time(n_cores) ==
+          plain_app.compute_avg_execution_time(n_cores));
+  }
+}
+
+// Rows longer than the chunks, and data much smaller than the rows it
+// decompresses to (the output of a chunk spans many output buffers)
+void check_large_file(const std::string& extension,
+                      std::string (*compress)(const std::string&)) {
+  opt_common_test::TemporaryDirectory dir;
+  std::string content;
+  for (unsigned i = 0; i < 200000; ++i) {
+    content += "x,x,x,x,1000,2000,x,x,x,x,x,x,x,x,x,x," +
+               std::to_string(i % 7) + "\n";
+  }
+  content += std::string(300000, 'y') + "\n";
+  const std::string plain = dir.get_path() + "/tasks.csv";
+  opt_common_test::write_file(plain, content);
+  opt_common_test::write_file(plain + extension, compress(content));
+  CHECK(read_rows(plain + extension) == read_rows(plain));
+}
+
+// The members of a gzip file are decompressed one after the other
+void test_concatenated_gzip_members() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string namefile = dir.get_path() + "/rows.csv.gz";
+  opt_common_test::write_file(namefile,
+                              gzip("a,b\n1,2\n") + gzip("3,") + gzip("4\n"));
+  const opt_common::CSV_Data expected{{"a", "b"}, {"1", "2"}, {"3", "4"}};
+  CHECK(read_rows(namefile) == expected);
+  CHECK(opt_common::read_first_line(namefile) == "a,b");
+}
+
+// Truncated or corrupted data is an error, not fewer rows
+void check_invalid_data(const std::string& extension,
+                        std::string (*compress)(const std::string&)) {
+  opt_common_test::TemporaryDirectory dir;
+  std::string content = "a,b\n";
+  for (unsigned i = 0; i < 10000; ++i) {
+    content += std::to_string(i) + "," + std::to_string(i * 7919 % 104729) +
+               "\n";
+  }
+  const std::string compressed = compress(content);
+  const std::string namefile = dir.get_path() + "/rows.csv" + extension;
+
+  opt_common_test::write_file(namefile,
+                              compressed.substr(0, compressed.size() / 2));
+  CHECK_THROWS(read_rows(namefile));
+
+  opt_common_test::write_file(namefile,
+                              compressed.substr(0, compressed.size() - 1));
+  CHECK_THROWS(read_rows(namefile));
+
+  std::string corrupted = compressed;
+  for (std::size_t i = compressed.size() / 3; i < compressed.size() / 2;
+       ++i) {
+    corrupted[i] = static_cast<char>(corrupted[i] ^ 0x5A);
+  }
+  opt_common_test::write_file(namefile, corrupted);
+  CHECK_THROWS(read_rows(namefile));
+
+  opt_common_test::write_file(namefile, content);  // Not compressed at all
+  CHECK_THROWS(read_rows(namefile));
+  CHECK_THROWS(opt_common::read_first_line(namefile));
+}
+
+/*! The rows of a growing compressed file are read from the offset saved
+    by the previous reading (in the decompressed data)
+ */
+void check_incremental_reads(const std::string& extension,
+                             std::string (*compress)(const std::string&)) {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string namefile = dir.get_path() + "/rows.csv" + extension;
+  std::vector<std::string> lines;
+  const auto handle_line = [&lines](std::string_view line) {
+    lines.emplace_back(line);
+  };
+
+  // The last row is being written
+  opt_common_test::write_file(namefile, compress("h\n1\n2\n3"));
+  std::uint64_t offset = opt_common::for_each_compressed_line_from_offset(
+      namefile, opt_common::detect_compression(namefile), 0, handle_line,
+      false);
+  CHECK(offset == 6);
+  CHECK((lines == std::vector<std::string>{"h", "1", "2"}));
+
+  lines.clear();
+  opt_common_test::write_file(namefile, compress("h\n1\n2\n34\n5\n6"));
+  offset = opt_common::for_each_compressed_line_from_offset(
+      namefile, opt_common::detect_compression(namefile), offset,
+      handle_line, false);
+  CHECK(offset == 11);
+  CHECK((lines == std::vector<std::string>{"34", "5"}));
+
+  // Nothing new
+  lines.clear();
+  CHECK(opt_common::for_each_compressed_line_from_offset(
+            namefile, opt_common::detect_compression(namefile), offset,
+            handle_line, false) == 11);
+  CHECK(lines.empty());
+
+  // The application has completed: the last row is complete
+  CHECK(opt_common::for_each_compressed_line_from_offset(
+            namefile, opt_common::detect_compression(namefile), offset,
+            handle_line, true) == 12);
+  CHECK((lines == std::vector<std::string>{"6"}));
+}
+
+}  // namespace
+
+int main() {
+  test_detect_compression();
+
+  check_compressed_trace(".gz", gzip);
+  check_large_file(".gz", gzip);
+  test_concatenated_gzip_members();
+  check_invalid_data(".gz", gzip);
+  check_incremental_reads(".gz", gzip);
+
+#ifdef OPT_COMMON_WITH_ZSTD
+  check_compressed_trace(".zst", zstd);
+  check_large_file(".zst", zstd);
+  check_invalid_data(".zst", zstd);
+  check_incremental_reads(".zst", zstd);
+#endif
+  return 0;
+}
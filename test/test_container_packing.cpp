@@ -0,0 +1,109 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <limits>
+#include <opt_common/ContainerPackingOptimizer.hpp>
+#include <opt_common/MachineLearningModel.hpp>
+#include <opt_common/TimeInstant.hpp>
+#include "test/check.hpp"
+
+using opt_common::ContainerPackingOptimizer;
+using opt_common::MachineLearningModel;
+using opt_common::TimeInstant;
+
+namespace {
+
+// A small type of 4 cores (cost 1) and a large one of 16 cores (cost 3)
+ContainerPackingOptimizer make_optimizer() {
+  ContainerPackingOptimizer optimizer;
+  optimizer.add_container_type({"small", 8, 4, 1});
+  optimizer.add_container_type({"large", 32, 16, 3});
+  optimizer.add_executor_shapes({2, 4}, {2, 4});
+  return optimizer;
+}
+
+void test_cheapest_packing() {
+  const ContainerPackingOptimizer optimizer = make_optimizer();
+
+  // 16 cores: 4 small containers (cost 4) or 1 large (cost 3)
+  const auto large = optimizer.find_cheapest_packing(16);
+  CHECK(large.container_type.name == "large");
+  CHECK(large.n_containers == 1);
+  CHECK(large.n_executors * large.executor_shape.cores >= 16);
+  CHECK_NEAR(large.cost, 3, 0);
+
+  // 4 cores: 1 small container
+  const auto small = optimizer.find_cheapest_packing(4);
+  CHECK(small.container_type.name == "small");
+  CHECK(small.n_containers == 1);
+  CHECK_NEAR(small.cost, 1, 0);
+
+  // Executors are not split: an executor of 6 GB and 2 cores fits once in
+  // a small container (8 GB), so 4 cores take 2 containers
+  ContainerPackingOptimizer by_memory;
+  by_memory.add_container_type({"small", 8, 4, 1});
+  by_memory.add_executor_shape({6, 2});
+  const auto packing = by_memory.find_cheapest_packing(4);
+  CHECK(packing.n_executors == 2 && packing.n_containers == 2);
+
+  const auto configuration = large.get_infrastructure_configuration();
+  CHECK(configuration.getContainter_cores() == 16);
+  CHECK(configuration.getExecutor_cores() ==
+        static_cast<int>(large.executor_shape.cores));
+
+  // Nothing fits, or no grid at all
+  ContainerPackingOptimizer empty;
+  CHECK_THROWS(empty.find_cheapest_packing(1));
+  empty.add_container_type({"tiny", 1, 1, 1});
+  empty.add_executor_shape({2, 2});
+  CHECK_THROWS(empty.find_cheapest_packing(1));
+  CHECK_THROWS(empty.add_executor_shape({0, 1}));
+}
+
+void test_deadline_packing() {
+  const ContainerPackingOptimizer optimizer = make_optimizer();
+
+  // deadline = chi_0 + chi_c / n: 1000 + 16000 / 16 = 2000 ms
+  const MachineLearningModel mlm(1000, 16000);
+  const auto packing = optimizer.find_cheapest_packing(
+      mlm, TimeInstant::from_milliseconds(2000));
+  CHECK(packing.n_executors * packing.executor_shape.cores >= 16);
+  CHECK(packing.container_type.name == "large");
+
+  // A loose deadline still needs a core
+  const auto loose = optimizer.find_cheapest_packing(
+      mlm, TimeInstant::from_milliseconds(1000000));
+  CHECK(loose.n_executors == 1);
+
+  // No slack, or more cores than can be counted
+  CHECK_THROWS(optimizer.find_cheapest_packing(
+      mlm, TimeInstant::from_milliseconds(1000)));
+  CHECK_THROWS(optimizer.find_cheapest_packing(
+      mlm, TimeInstant::from_milliseconds(500)));
+  CHECK_THROWS(optimizer.find_cheapest_packing(
+      MachineLearningModel(0, 1e300), TimeInstant::from_milliseconds(1)));
+  CHECK_THROWS(optimizer.find_cheapest_packing(
+      MachineLearningModel(std::numeric_limits<double>::quiet_NaN(), 1),
+      TimeInstant::from_milliseconds(1)));
+}
+
+}  // namespace
+
+int main() {
+  test_cheapest_packing();
+  test_deadline_packing();
+  return 0;
+}
@@ -0,0 +1,167 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <opt_common/Application.hpp>
+#include <opt_common/CsvSchema.hpp>
+#include <string>
+#include <string_view>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::CsvColumn;
+using opt_common::CsvRowDecoder;
+
+namespace {
+
+using Decoder = CsvRowDecoder<unsigned, std::string_view>;
+constexpr std::array<CsvColumn, 2> COLUMNS{{{"Stage ID", 0}, {"Name", 2}}};
+
+// The values written are the values decoded, by name or by position
+void test_round_trip() {
+  unsigned id;
+  std::string_view name;
+
+  Decoder legacy(COLUMNS);
+  CHECK(legacy.bind_header("c0,c1,c2"));
+  CHECK(legacy.decode("7,x,\"a, b\"", &id, &name));
+  CHECK(id == 7 && name == "\"a, b\"");
+
+  Decoder named(COLUMNS);
+  CHECK(named.bind_header("name , other,stage_id"));
+  CHECK(named.decode("s3,x,3", &id, &name));
+  CHECK(id == 3 && name == "s3");
+  CHECK(named.get_column_index(0) == 2 && named.get_column_index(1) == 0);
+
+  CHECK(named.decode("s3,x,3x", &id, &name) == false);
+  CHECK(named.get_error() == "has an invalid Stage ID '3x'");
+  CHECK(named.decode("s3,x", &id, &name) == false);
+  CHECK(named.get_error() == "has a row without the column 'Stage ID'");
+}
+
+// A header with some of the names is not read by position
+void test_partial_header() {
+  Decoder decoder(COLUMNS);
+  CHECK(decoder.bind_header("Stage ID,c1,c2") == false);
+  CHECK(decoder.get_error() == "has a header without the column 'Name'");
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  opt_common_test::write_file(dir.get_path() + "/stages.csv",
+                              "Stage ID,Stage Name,Parents,Tasks,A,B\n"
+                              "0,s0,\"[]\",4,x,y\n");
+  opt_common_test::QuietStdout quiet;
+  CHECK_THROWS(Application::create_application(
+      input, dir.get_path() + "/config.txt"));
+}
+
+void test_row_size() {
+  unsigned id;
+  std::string_view name;
+
+  Decoder decoder(COLUMNS, true);
+  CHECK(decoder.bind_header("c0,c1,c2"));
+  CHECK(decoder.decode("1,x,y", &id, &name));
+  CHECK(decoder.decode("1,x,y,z", &id, &name) == false);
+  CHECK(decoder.get_error() == "has different number of cols");
+  CHECK(decoder.decode("1,x", &id, &name) == false);
+
+  // As before the names, the jobs rows have the columns of the header
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  opt_common_test::append_file(dir.get_path() + "/jobs.csv",
+                               "2,61000,\"[]\",61000,extra\n");
+  opt_common_test::QuietStdout quiet;
+  CHECK_THROWS(Application::create_application(
+      input, dir.get_path() + "/config.txt"));
+}
+
+// Only the data rows count as appended
+void test_incremental_rows() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string jobs = dir.get_path() + "/jobs.csv";
+  opt_common_test::write_file(jobs, "Job ID,Submission Time\n");
+
+  using JobsDecoder = CsvRowDecoder<unsigned, unsigned>;
+  JobsDecoder decoder(std::array<CsvColumn, 2>{
+      {{"Job ID", 0}, {"Submission Time", 1}}});
+  std::size_t handled = 0;
+  const auto handle_row = [&](std::string_view) { ++handled; };
+
+  std::uint64_t offset = 0;
+  CHECK(opt_common::for_each_csv_row_from_offset(jobs, &offset, &decoder,
+                                                 handle_row) == 0);
+  CHECK(offset != 0);
+
+  opt_common_test::append_file(jobs, "\n\n");
+  CHECK(opt_common::for_each_csv_row_from_offset(jobs, &offset, &decoder,
+                                                 handle_row) == 0);
+
+  opt_common_test::append_file(jobs, "0,1000\n1,2000\n");
+  CHECK(opt_common::for_each_csv_row_from_offset(jobs, &offset, &decoder,
+                                                 handle_row) == 2);
+  CHECK(handled == 2);
+
+  // The header is read again (alone) when the reading starts in the middle
+  opt_common_test::write_file(jobs, "Submission Time,Job ID\n");
+  offset = 0;
+  CHECK(opt_common::for_each_csv_row_from_offset(jobs, &offset, &decoder,
+                                                 handle_row) == 0);
+  opt_common_test::append_file(jobs, "1000,5\n");
+  unsigned id = 0, time = 0;
+  CHECK(opt_common::for_each_csv_row_from_offset(
+            jobs, &offset, &decoder, [&](std::string_view line) {
+              CHECK(decoder.decode(line, &id, &time));
+            }) == 1);
+  CHECK(id == 5 && time == 1000);
+  CHECK(opt_common::read_first_line(jobs) == "Submission Time,Job ID");
+}
+
+// An update without new rows does not refit alpha and beta
+void test_update_without_rows() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  opt_common_test::QuietStdout quiet;
+  Application app =
+      Application::create_application(input, dir.get_path() + "/config.txt");
+  app.set_alpha_beta(1, 4);
+
+  opt_common_test::append_file(dir.get_path() + "/tasks.csv", "\n");
+  CHECK(app.update_from_appended_rows() == 0);
+
+  opt_common_test::append_file(
+      dir.get_path() + "/tasks.csv",
+      "x,x,x,x,1000,9000,x,x,x,x,x,x,x,x,x,x,1\n");
+  CHECK(app.update_from_appended_rows() == 1);
+  CHECK(std::abs(app.get_alpha() - 22304.33) > 1);
+}
+
+}  // namespace
+
+int main() {
+  test_round_trip();
+  test_partial_header();
+  test_row_size();
+  test_incremental_rows();
+  test_update_without_rows();
+  return 0;
+}
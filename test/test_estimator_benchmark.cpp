@@ -0,0 +1,136 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <opt_common/Application.hpp>
+#include <opt_common/EstimatorBenchmark.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::BenchmarkTrace;
+using opt_common::EstimatorBenchmark;
+using opt_common::EstimatorBenchmarkOptions;
+
+namespace {
+
+// The traces written are the traces read
+void test_manifest_round_trip() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string manifest = dir.get_path() + "/manifest.txt";
+  opt_common_test::write_file(manifest,
+                              "# input cores\n"
+                              "/data/a/input.txt 8\n"
+                              "\n"
+                              "  /data/b/input.txt\t16 \r\n");
+
+  const std::vector<BenchmarkTrace> corpus =
+      opt_common::read_benchmark_manifest(manifest);
+  CHECK(corpus.size() == 2);
+  CHECK(corpus[0].data_input_namefile == "/data/a/input.txt");
+  CHECK(corpus[0].recorded_cores == 8);
+  CHECK(corpus[1].data_input_namefile == "/data/b/input.txt");
+  CHECK(corpus[1].recorded_cores == 16);
+
+  for (const std::string line :
+       {"/data/a/input.txt", "/data/a/input.txt 0", "/data/a/input.txt 8x",
+        "/data/a/input.txt 8 9"}) {
+    opt_common_test::write_file(manifest, line + "\n");
+    CHECK_THROWS(opt_common::read_benchmark_manifest(manifest));
+  }
+}
+
+// A throwing estimator is unavailable on its trace, the others are not
+// affected
+void test_throwing_estimator() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  const std::string config = dir.get_path() + "/config.txt";
+
+  EstimatorBenchmarkOptions options;
+  options.repetitions = 2;
+  EstimatorBenchmark benchmark(options);
+  benchmark.add_estimator("throwing", [](const Application&, unsigned) {
+    THROW_RUNTIME_ERROR("estimator failed");
+    return 0.0;
+  });
+  benchmark.add_estimator("real", [](const Application& app, unsigned) {
+    return app.get_real_execution_time().to_milliseconds();
+  });
+
+  const std::vector<BenchmarkTrace> corpus{
+      {input, 4}, {input, 2}, {dir.get_path() + "/missing.txt", 4}};
+  const EstimatorBenchmark::Loader load =
+      [&config](const std::string& namefile) {
+        return Application::create_application(namefile, config);
+      };
+  opt_common::WorkStealingScheduler scheduler(2);
+  opt_common_test::QuietStdout quiet;
+  const EstimatorBenchmark::Report report =
+      benchmark.run(corpus, load, &scheduler);
+
+  CHECK(report.number_of_traces == 3);
+  CHECK(report.errors.size() == 1);
+  CHECK(report.estimators.size() == 5);
+
+  const EstimatorBenchmark::EstimatorStatistics& throwing =
+      report.estimators[3];
+  CHECK(throwing.name == "throwing");
+  CHECK(throwing.number_of_samples == 0);
+  CHECK(throwing.number_of_unavailable == 2);
+  CHECK(throwing.errors.size() == 2);
+  CHECK(throwing.errors[0].error == "estimator failed");
+
+  const EstimatorBenchmark::EstimatorStatistics& real = report.estimators[4];
+  CHECK(real.number_of_samples == 2);
+  CHECK(real.errors.empty());
+  CHECK_NEAR(real.mape, 0, 0);
+
+  // T(4) and T(2) against the real time of 60000 ms
+  const EstimatorBenchmark::EstimatorStatistics& analytic =
+      report.estimators[0];
+  CHECK(analytic.number_of_samples == 2);
+  CHECK_NEAR(analytic.max_error, (60000 - 8462.75) / 600, 0.01);
+  CHECK(report.get_cheapest_estimator(1) == &real);
+
+  // The same report on the calling thread (no scheduler)
+  const EstimatorBenchmark::Report sequential =
+      benchmark.run(corpus, load, nullptr);
+  CHECK(sequential.number_of_traces == 3);
+  CHECK(sequential.errors.size() == 1);
+  CHECK(sequential.estimators.size() == report.estimators.size());
+  for (std::size_t e = 0; e < report.estimators.size(); ++e) {
+    CHECK(sequential.estimators[e].name == report.estimators[e].name);
+    CHECK(sequential.estimators[e].number_of_samples ==
+          report.estimators[e].number_of_samples);
+    CHECK(sequential.estimators[e].number_of_unavailable ==
+          report.estimators[e].number_of_unavailable);
+    CHECK_NEAR(sequential.estimators[e].max_error,
+               report.estimators[e].max_error, 0);
+  }
+}
+
+}  // namespace
+
+int main() {
+  test_manifest_round_trip();
+  test_throwing_estimator();
+  return 0;
+}
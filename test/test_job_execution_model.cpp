@@ -0,0 +1,153 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <opt_common/Application.hpp>
+#include <opt_common/JobExecutionModel.hpp>
+#include <opt_common/TimeInstant.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <string>
+#include <vector>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::JobExecutionModel;
+using opt_common::TimeInstant;
+
+namespace {
+
+TimeInstant ms(double milliseconds) {
+  return TimeInstant::from_milliseconds(milliseconds);
+}
+
+/*! Write a completed trace of 30000 ms with 3 jobs:
+      job 0 from 2000 to 6000 ms, stages 0 and 1
+      job 1 from 4000 to 9000 ms, stages 1 (run by job 0) and 2
+      job 2 from 12000 to 15000 ms, stage 3
+    and the stage 4 of no job. The stages have 4, 2, 3, 1 and 2 tasks of
+    1000, 2000, 500, 3000 and 100 ms.
+    \return the input file
+ */
+std::string write_jobs_trace(const std::string& directory) {
+  opt_common_test::write_file(directory + "/app.csv",
+                              "AppID,Time\napp_1,1000\napp_1,31000\n");
+  opt_common_test::write_file(
+      directory + "/jobs.csv",
+      "Job ID,Submission Time,Stage IDs,Completion Time\n"
+      "1,4000,\"[1, 2]\",9000\n"
+      "0,2000,\"[0, 1]\",6000\n"
+      "2,12000,\"[3]\",15000\n");
+  opt_common_test::write_file(directory + "/stages.csv",
+                              "Stage ID,Stage Name,Parent IDs,Number of "
+                              "Tasks,A,B\n"
+                              "0,s0,\"[]\",4,x,y\n"
+                              "1,s1,\"[0]\",2,x,y\n"
+                              "2,s2,\"[1]\",3,x,y\n"
+                              "3,s3,\"[]\",1,x,y\n"
+                              "4,s4,\"[]\",2,x,y\n");
+
+  const unsigned long stage_tasks[] = {4, 2, 3, 1, 2};
+  const unsigned long task_times[] = {1000, 2000, 500, 3000, 100};
+  std::string tasks =
+      "c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15,c16\n";
+  for (unsigned stage_id = 0; stage_id < 5; ++stage_id) {
+    for (unsigned long t = 0; t < stage_tasks[stage_id]; ++t) {
+      tasks += "x,x,x,x,2000," + std::to_string(2000 + task_times[stage_id]) +
+               ",x,x,x,x,x,x,x,x,x,x," + std::to_string(stage_id) + "\n";
+    }
+  }
+  opt_common_test::write_file(directory + "/tasks.csv", tasks);
+  return opt_common_test::write_input_files(directory, 50000);
+}
+
+void test_hand_built_trace() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input = write_jobs_trace(dir.get_path());
+  Application app;
+  {
+    opt_common_test::QuietStdout quiet;
+    app = Application::create_application(input,
+                                           dir.get_path() + "/config.txt");
+  }
+  const JobExecutionModel model(app);
+
+  CHECK((model.get_job_ids() == std::vector<opt_common::Job::JobID>{0, 1, 2}));
+
+  // The driver idles from 9000 to 12000 ms; the jobs span 13000 ms of the
+  // 30000 ms of the run
+  CHECK(model.get_jobs_gap() == ms(3000));
+  CHECK(model.get_driver_overhead() == ms(17000));
+
+  // With 2 cores: job 0 runs 2 waves of the stage 0 and 1 of the stage 1,
+  // job 1 only 2 waves of the stage 2 (the stage 1 is counted once)
+  const auto durations = model.compute_job_durations(2);
+  CHECK(durations.size() == 3);
+  CHECK(durations[0] == ms(2000 + 2000));
+  CHECK(durations[1] == ms(1000));
+  CHECK(durations[2] == ms(3000));
+
+  // The stage 4 of no job runs after the jobs (1 wave of 100 ms)
+  CHECK(model.compute_execution_time(2) ==
+        ms(17000 + 3000 + 4000 + 1000 + 3000 + 100));
+
+  // With 1 core the stage 4 takes 2 waves
+  CHECK(model.compute_execution_time(1) ==
+        ms(17000 + 3000 + (4000 + 4000) + 1500 + 3000 + 200));
+
+  CHECK_THROWS(model.compute_job_durations(0));
+  CHECK_THROWS(model.compute_execution_time(0));
+}
+
+// More jobs than evaluated by a task of the scheduler
+void test_scheduler() {
+  opt_common_test::TraceSpec spec;
+  spec.number_of_jobs = 1000;
+  spec.stages_per_job = 2;
+  spec.tasks_per_stage = 5;
+  spec.recorded_cores = 2;
+  spec.jobs_gap_ms = 10;
+
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_synthetic_trace(dir.get_path(), spec);
+  Application app;
+  {
+    opt_common_test::QuietStdout quiet;
+    app = Application::create_application(input,
+                                           dir.get_path() + "/config.txt");
+  }
+  const JobExecutionModel model(app);
+  CHECK(model.get_job_ids().size() == spec.number_of_jobs);
+  CHECK(model.get_jobs_gap() == ms(10 * (spec.number_of_jobs - 1)));
+
+  opt_common::WorkStealingScheduler scheduler(4);
+  for (const unsigned n_cores : {1u, 2u, 3u, 8u}) {
+    const auto sequential = model.compute_job_durations(n_cores);
+    CHECK(sequential.size() == spec.number_of_jobs);
+    CHECK(model.compute_job_durations(n_cores, &scheduler) == sequential);
+    CHECK(model.compute_execution_time(n_cores, &scheduler) ==
+          model.compute_execution_time(n_cores));
+  }
+  CHECK_THROWS(model.compute_job_durations(0, &scheduler));
+}
+
+}  // namespace
+
+int main() {
+  test_hand_built_trace();
+  test_scheduler();
+  return 0;
+}
@@ -0,0 +1,173 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <opt_common/OptimizerService.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::CommandLineParser;
+using opt_common::OptimizerService;
+
+namespace {
+
+// An optimizer logging on the standard output, as the real ones do
+std::string optimize(Application* app,
+                     const CommandLineParser::CommandLineOptions& options) {
+  std::cout << "log of the optimization\n";
+  std::ostringstream result;
+  result << app->get_deadline().to_milliseconds()
+         << (options.no_ml ? " no-ml" : "");
+  return result.str();
+}
+
+// The answers are the only lines on the standard output
+void test_protocol(const std::string& input, const std::string& config) {
+  OptimizerService service(config, optimize);
+  std::istringstream requests("optimize " + input + " -f\n" +
+                              "optimize " + input + " -f --deadline 123\n" +
+                              "optimize " + input + " -f\n" +
+                              "evaluate " + input + " 2\n" +
+                              "evaluate " + input + " zero\n" +
+                              "optimize " + input + " -f --socket x\n" +
+                              "unknown\n" + "stats\n" + "quit\n" + "stats\n");
+
+  std::ostringstream answers;
+  std::streambuf* const stdout_buffer = std::cout.rdbuf(answers.rdbuf());
+  service.serve(&requests, &std::cout);
+  std::cout.rdbuf(stdout_buffer);
+
+  std::istringstream lines(answers.str());
+  std::string line;
+  const auto next_line = [&]() {
+    CHECK(std::getline(lines, line));
+    return line;
+  };
+  CHECK(next_line() == "OK 50000");
+  CHECK(next_line() == "OK 123");
+  CHECK(next_line() == "OK 50000");
+  CHECK(next_line().rfind("OK 14181.5 ", 0) == 0);
+  CHECK(next_line().rfind("ERROR ", 0) == 0);
+  CHECK(next_line().rfind("ERROR ", 0) == 0);
+  CHECK(next_line().rfind("ERROR ", 0) == 0);
+  CHECK(next_line() == "OK applications=1 hits=3 misses=1");
+  CHECK(next_line() == "OK");
+  CHECK(!std::getline(lines, line));  // Nothing after quit
+}
+
+// A changed input file is loaded again, the least recently used
+// application is dropped
+void test_cache(const std::string& directory) {
+  const std::string first_dir = directory + "/first";
+  const std::string second_dir = directory + "/second";
+  std::filesystem::create_directory(first_dir);
+  std::filesystem::create_directory(second_dir);
+  const std::string first = opt_common_test::write_reference_trace(first_dir);
+  const std::string second =
+      opt_common_test::write_reference_trace(second_dir);
+  const std::string config = first_dir + "/config.txt";
+
+  OptimizerService service(config, optimize, 1);
+  opt_common_test::QuietStdout quiet;
+  CHECK(service.handle_request("optimize " + first + " -f") == "OK 50000");
+  CHECK(service.handle_request("optimize " + first + " -f") == "OK 50000");
+  opt_common_test::write_input_files(first_dir, 700000);
+  CHECK(service.handle_request("optimize " + first + " -f") == "OK 700000");
+  CHECK(service.handle_request("stats") ==
+        "OK applications=1 hits=1 misses=2");
+
+  CHECK(service.handle_request("optimize " + second + " -f") == "OK 50000");
+  CHECK(service.handle_request("optimize " + first + " -f") == "OK 700000");
+  CHECK(service.handle_request("stats") ==
+        "OK applications=1 hits=1 misses=4");
+
+  CHECK_THROWS(OptimizerService(config, optimize, 0));
+}
+
+int connect_to(const std::string& socket_path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+  for (int attempt = 0; attempt < 500; ++attempt) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                  sizeof(address)) == 0) {
+      return fd;
+    }
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return -1;
+}
+
+void send_all(int fd, const std::string& data) {
+  CHECK(::write(fd, data.data(), data.size()) ==
+        static_cast<ssize_t>(data.size()));
+}
+
+// A client leaving without reading its answers must not stop the service
+void test_unix_socket(const std::string& input, const std::string& config,
+                      const std::string& directory) {
+  const std::string socket_path = directory + "/service.sock";
+  OptimizerService service(config, optimize);
+  std::thread server([&]() { service.serve_unix_socket(socket_path); });
+
+  const int leaving_client = connect_to(socket_path);
+  CHECK(leaving_client >= 0);
+  std::string requests;
+  for (int i = 0; i < 20000; ++i) {
+    requests += "stats\n";
+  }
+  send_all(leaving_client, requests);
+  ::close(leaving_client);
+
+  const int client = connect_to(socket_path);
+  CHECK(client >= 0);
+  send_all(client, "optimize " + input + " -f\nquit\n");
+  std::string answers;
+  char buffer[256];
+  ssize_t n_read;
+  while ((n_read = ::read(client, buffer, sizeof(buffer))) > 0) {
+    answers.append(buffer, n_read);
+  }
+  ::close(client);
+  server.join();
+  CHECK(answers == "OK 50000\nOK\n");
+}
+
+}  // namespace
+
+int main() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  const std::string config = dir.get_path() + "/config.txt";
+
+  test_protocol(input, config);
+  test_cache(dir.get_path());
+  test_unix_socket(input, config, dir.get_path());
+  return 0;
+}
@@ -0,0 +1,133 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <opt_common/Application.hpp>
+#include <opt_common/ParallelOptimizer.hpp>
+#include <opt_common/WorkStealingScheduler.hpp>
+#include <opt_common/configuration.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::ApplicationPipeline;
+using opt_common::PipelineResult;
+using opt_common::WorkStealingScheduler;
+
+namespace {
+
+bool contains(const std::string& text, const std::string& part) {
+  return text.find(part) != std::string::npos;
+}
+
+/*! Each application gets its result, or the error of the step that
+    failed; the logs are kept per application, off the standard output
+ */
+void test_pipelines() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string first_dir = dir.get_path() + "/first";
+  const std::string failing_dir = dir.get_path() + "/failing";
+  std::filesystem::create_directory(first_dir);
+  std::filesystem::create_directory(failing_dir);
+  const std::string first = opt_common_test::write_reference_trace(first_dir);
+  opt_common_test::write_reference_trace(failing_dir);
+  const std::string failing =
+      opt_common_test::write_input_files(failing_dir, 700000);
+
+  opt_common::Configuration configuration;
+  configuration.read_configuration_from_file(first_dir + "/config.txt");
+
+  const auto failing_deadline =
+      opt_common::TimeInstant::from_milliseconds(700000);
+  std::atomic<unsigned> searches{0};
+  ApplicationPipeline pipeline;
+  pipeline.load = [&configuration](const std::string& namefile,
+                                   std::ostream* log) {
+    return Application::create_application(
+        namefile, configuration, opt_common::TasksSamplingOptions(), log);
+  };
+  pipeline.alpha_beta_n1 = 1;
+  pipeline.alpha_beta_n2 = 4;
+  pipeline.search = [&](Application* app, unsigned initial_cores,
+                        WorkStealingScheduler* scheduler, std::ostream* log) {
+    ++searches;
+    *log << "search from " << initial_cores << " cores\n";
+    if (app->get_deadline() == failing_deadline) {
+      THROW_RUNTIME_ERROR("search failed");
+    }
+
+    // Nested tasks of the search
+    std::vector<double> times(4);
+    WorkStealingScheduler::TaskGroup group(scheduler);
+    for (unsigned n = 1; n <= times.size(); ++n) {
+      group.spawn([&times, app, n]() {
+        times[n - 1] = app->compute_avg_execution_time(n).to_milliseconds();
+      });
+    }
+    group.wait();
+
+    std::ostringstream result;
+    result << initial_cores << " " << static_cast<long>(app->get_alpha())
+           << " " << times[1];
+    return result.str();
+  };
+
+  const std::vector<std::string> inputs{first, dir.get_path() + "/missing",
+                                        failing, first};
+  WorkStealingScheduler scheduler(2);
+  std::ostringstream standard_output;
+  std::streambuf* const stdout_buffer =
+      std::cout.rdbuf(standard_output.rdbuf());
+  const std::vector<PipelineResult> results =
+      opt_common::run_application_pipelines(inputs, pipeline, &scheduler);
+  std::cout.rdbuf(stdout_buffer);
+
+  CHECK(standard_output.str().empty());
+  CHECK(searches == 3);
+  CHECK(results.size() == 4);
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    CHECK(results[i].data_input_namefile == inputs[i]);
+  }
+
+  for (const std::size_t i : {0, 3}) {
+    CHECK(results[i].error.empty());
+    CHECK(results[i].result == "4 22304 14181.5");
+    CHECK(contains(results[i].log, "Optimizing configuration"));
+    CHECK(contains(results[i].log, "Initial cores number: "));
+    CHECK(contains(results[i].log, "search from 4 cores"));
+  }
+
+  CHECK(!results[1].error.empty());
+  CHECK(results[1].result.empty());
+  CHECK(!contains(results[1].log, "search"));
+
+  CHECK(results[2].error == "search failed");
+  CHECK(results[2].result.empty());
+  CHECK(contains(results[2].log, "Initial cores number: "));
+  CHECK(contains(results[2].log, "search from "));
+}
+
+}  // namespace
+
+int main() {
+  test_pipelines();
+  return 0;
+}
@@ -0,0 +1,189 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <opt_common/Application.hpp>
+#include <opt_common/ParetoFrontier.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::ParetoFrontier;
+using opt_common::ParetoFrontierOptions;
+using opt_common::TimeInstant;
+
+namespace {
+
+/*! \return the reference trace (T(1) = 25191, T(2) = 14181.5,
+    T(3) = 11009.5, T(n >= 4) = 8462.75 ms) on containers of
+    `container_cores` cores, with the ML model (chi_0, chi_c)
+ */
+Application load_reference(const opt_common_test::TemporaryDirectory& dir,
+                           const std::string& chi_0, const std::string& chi_c,
+                           unsigned container_cores) {
+  const std::string input =
+      opt_common_test::write_reference_trace(dir.get_path());
+  opt_common_test::write_file(
+      dir.get_path() + "/infra.txt",
+      "app chi_0 chi_c cm em cc ec\napp_1 " + chi_0 + " " + chi_c + " 8 " +
+          std::to_string(8 / container_cores) + " " +
+          std::to_string(container_cores) + " 1\n");
+  opt_common_test::QuietStdout quiet;
+  return Application::create_application(input,
+                                         dir.get_path() + "/config.txt");
+}
+
+std::vector<unsigned> get_cores(const ParetoFrontier& frontier) {
+  std::vector<unsigned> cores;
+  for (const auto& point : frontier.get_points()) {
+    cores.push_back(point.n_cores);
+  }
+  return cores;
+}
+
+// A number of containers is represented by its greatest number of cores
+void test_container_grouping() {
+  opt_common_test::TemporaryDirectory dir;
+  const Application app = load_reference(dir, "1000", "200000", 2);
+  const ParetoFrontier frontier = ParetoFrontier::compute_pareto_frontier(app);
+
+  const auto& points = frontier.get_points();
+  CHECK(points.size() == 2);
+  CHECK(points[0].n_cores == 2 && points[0].n_containers == 1);
+  CHECK(points[1].n_cores == 4 && points[1].n_containers == 2);
+  CHECK(points[0].predicted_time == TimeInstant::from_milliseconds(14181.5));
+  CHECK(points[0].analytic_time == points[0].predicted_time);
+  CHECK(points[1].predicted_time == TimeInstant::from_milliseconds(8462.75));
+  CHECK_NEAR(points[0].ml_time, 101000, 0);
+  CHECK(!points[0].simulated && !points[1].simulated);
+  CHECK(frontier.get_number_of_simulations() == 0);
+
+  ParetoFrontierOptions options;
+  options.min_cores = 5;
+  options.max_cores = 4;
+  CHECK_THROWS(ParetoFrontier::compute_pareto_frontier(app, options));
+}
+
+/*! The more expensive candidates must reduce the analytic time; the ML
+    model, flat when not fitted, only breaks the ties
+ */
+void test_pruning() {
+  ParetoFrontierOptions options;
+  options.max_cores = 6;
+
+  opt_common_test::TemporaryDirectory flat_dir;
+  const Application flat = load_reference(flat_dir, "1000", "0", 1);
+  CHECK((get_cores(ParetoFrontier::compute_pareto_frontier(flat, options)) ==
+         std::vector<unsigned>{1, 2, 3, 4}));
+
+  // 5 and 6 cores have the time of 4 cores in the wave model
+  opt_common_test::TemporaryDirectory fitted_dir;
+  const Application fitted = load_reference(fitted_dir, "1000", "200000", 1);
+  CHECK((get_cores(ParetoFrontier::compute_pareto_frontier(fitted, options)) ==
+         std::vector<unsigned>{1, 2, 3, 4, 5, 6}));
+
+  // ML(4) = 51000, ML(5) = 41000 (-19.6%), ML(6) = 34333 ms (-32.7%)
+  options.min_relative_improvement = 0.2;
+  CHECK((get_cores(ParetoFrontier::compute_pareto_frontier(fitted, options)) ==
+         std::vector<unsigned>{1, 2, 3, 4, 6}));
+}
+
+// The simulator runs on the points left and can drop some of them
+void test_simulator() {
+  opt_common_test::TemporaryDirectory dir;
+  const Application app = load_reference(dir, "1000", "0", 1);
+  std::vector<unsigned> simulated_cores;
+  const ParetoFrontier frontier = ParetoFrontier::compute_pareto_frontier(
+      app, ParetoFrontierOptions(), [&](unsigned n_cores) {
+        simulated_cores.push_back(n_cores);
+        return n_cores == 3
+                   ? TimeInstant::from_milliseconds(20000)
+                   : app.compute_avg_execution_time(n_cores) +
+                         TimeInstant::from_milliseconds(1);
+      });
+
+  CHECK((simulated_cores == std::vector<unsigned>{1, 2, 3, 4}));
+  CHECK(frontier.get_number_of_simulations() == 4);
+  CHECK((get_cores(frontier) == std::vector<unsigned>{1, 2, 4}));
+  for (const auto& point : frontier.get_points()) {
+    CHECK(point.simulated);
+    CHECK(point.predicted_time ==
+          point.analytic_time + TimeInstant::from_milliseconds(1));
+  }
+}
+
+void test_find_cheapest_point() {
+  opt_common_test::TemporaryDirectory dir;
+  const Application app = load_reference(dir, "1000", "0", 1);
+  const ParetoFrontier frontier = ParetoFrontier::compute_pareto_frontier(app);
+  const auto find_cores = [&frontier](double deadline_ms) {
+    const auto* const point = frontier.find_cheapest_point(
+        TimeInstant::from_milliseconds(deadline_ms));
+    return point != nullptr ? point->n_cores : 0;
+  };
+
+  // A loose deadline is met by the cheapest point, one tighter than the
+  // fastest point by none
+  CHECK(find_cores(1e9) == 1);
+  CHECK(find_cores(25191) == 1);
+  CHECK(find_cores(25190.999) == 2);
+  CHECK(find_cores(12000) == 3);
+  CHECK(find_cores(8462.75) == 4);
+  CHECK(find_cores(8462.749) == 0);
+  CHECK(find_cores(0) == 0);
+
+  CHECK(ParetoFrontier().find_cheapest_point(TimeInstant()) == nullptr);
+}
+
+void test_output() {
+  opt_common_test::TemporaryDirectory dir;
+  const Application app = load_reference(dir, "1000", "200000", 2);
+  const ParetoFrontier frontier = ParetoFrontier::compute_pareto_frontier(app);
+
+  std::ostringstream csv;
+  csv.precision(3);
+  frontier.write_csv(&csv);
+  CHECK(csv.str() ==
+        "n_cores,n_containers,predicted_time,analytic_time,ml_time,"
+        "simulated\n"
+        "2,1,14181.5,14181.5,101000,0\n"
+        "4,2,8462.75,8462.75,51000,0\n");
+  CHECK(csv.precision() == 3);
+
+  std::ostringstream json;
+  frontier.write_json(&json);
+  CHECK(json.str() ==
+        "{\"application\": \"app_1\", \"points\": ["
+        "{\"n_cores\": 2, \"n_containers\": 1, \"predicted_time\": 14181.5, "
+        "\"analytic_time\": 14181.5, \"ml_time\": 101000, "
+        "\"simulated\": false}, "
+        "{\"n_cores\": 4, \"n_containers\": 2, \"predicted_time\": 8462.75, "
+        "\"analytic_time\": 8462.75, \"ml_time\": 51000, "
+        "\"simulated\": false}]}\n");
+}
+
+}  // namespace
+
+int main() {
+  test_container_grouping();
+  test_pruning();
+  test_simulator();
+  test_find_cheapest_point();
+  test_output();
+  return 0;
+}
@@ -0,0 +1,59 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <opt_common/InfrastructureConfiguration.hpp>
+#include <opt_common/ResourceModel.hpp>
+#include "test/check.hpp"
+
+using opt_common::InfrastructureConfiguration;
+using opt_common::ResourceVector;
+
+namespace {
+
+// On cores and memory it agrees with InfrastructureConfiguration
+void test_n_containers() {
+  // container memory, executor memory, container cores, executor cores
+  const InfrastructureConfiguration ic(16, 4, 8, 2);
+  const ResourceVector executor = opt_common::get_executor_resources(ic);
+  const ResourceVector container = opt_common::get_container_resources(ic);
+  for (unsigned cores : {0u, 1u, 2u, 7u, 8u, 9u, 64u, 1000u}) {
+    CHECK(opt_common::get_n_containers(executor, container, cores) ==
+          ic.get_n_containers(cores));
+  }
+
+  // The disk is the bottleneck: 3 executors take 2 containers
+  const ResourceVector disk_executor(2, 4, 100);
+  const ResourceVector disk_container(8, 16, 150);
+  CHECK(opt_common::get_n_containers(disk_executor, disk_container, 6) == 2);
+}
+
+void test_invalid_shares() {
+  const ResourceVector executor(2, 4, 1);
+  const ResourceVector container_without_disk(8, 16);
+  CHECK_THROWS(
+      opt_common::get_n_containers(executor, container_without_disk, 4));
+  CHECK_THROWS(
+      opt_common::get_n_containers(ResourceVector(0, 4), ResourceVector(8, 16),
+                                   4));
+}
+
+}  // namespace
+
+int main() {
+  test_n_containers();
+  test_invalid_shares();
+  return 0;
+}
@@ -0,0 +1,130 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cmath>
+#include <opt_common/Application.hpp>
+#include <opt_common/configuration.hpp>
+#include <sstream>
+#include <string>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::TasksSamplingOptions;
+
+namespace {
+
+constexpr unsigned NUMBER_OF_TASKS = 1000;
+
+// One stage whose task i takes (i + 1) ms: the first tasks are the
+// shortest, the average is 500.5 ms
+std::string write_trace(const std::string& directory) {
+  std::ostringstream tasks;
+  tasks << "c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15,c16\n";
+  for (unsigned i = 0; i < NUMBER_OF_TASKS; ++i) {
+    tasks << "x,x,x,x,1000," << 1001 + i << ",x,x,x,x,x,x,x,x,x,x,0\n";
+  }
+  opt_common_test::write_file(directory + "/tasks.csv", tasks.str());
+  opt_common_test::write_file(directory + "/app.csv",
+                              "AppID,Time\napp_1,1000\napp_1,200000\n");
+  opt_common_test::write_file(
+      directory + "/jobs.csv",
+      "Job ID,Submission Time,Stage IDs,Completion Time\n"
+      "0,1000,\"[0]\",199000\n");
+  opt_common_test::write_file(
+      directory + "/stages.csv",
+      "Stage ID,Stage Name,Parent IDs,Number of Tasks,A,B\n"
+      "0,s0,\"[]\"," + std::to_string(NUMBER_OF_TASKS) + ",x,y\n");
+  return opt_common_test::write_input_files(directory, 50000);
+}
+
+/*! Load the trace with many seeds: the estimates of the average must be
+    unbiased and the 95% intervals must contain the real average about 95
+    times out of 100
+ */
+void check_sampling(const std::string& input,
+                    const opt_common::Configuration& configuration,
+                    TasksSamplingOptions sampling) {
+  constexpr unsigned NUMBER_OF_SEEDS = 300;
+  constexpr double REAL_AVERAGE = (NUMBER_OF_TASKS + 1) / 2.0;
+
+  double sum_estimates = 0;
+  unsigned covered = 0;
+  for (unsigned seed = 0; seed < NUMBER_OF_SEEDS; ++seed) {
+    sampling.seed = seed;
+    const Application app =
+        Application::create_application(input, configuration, sampling);
+    CHECK(app.is_sampled());
+
+    const auto interval = app.get_stage_avg_time_interval(0);
+    sum_estimates += interval.estimate.to_milliseconds();
+    covered += interval.lower.to_milliseconds() <= REAL_AVERAGE &&
+               REAL_AVERAGE <= interval.upper.to_milliseconds();
+  }
+
+  // The standard error of the estimates is about 40 ms with 50 tasks
+  CHECK_NEAR(sum_estimates / NUMBER_OF_SEEDS, REAL_AVERAGE, 10);
+  const double coverage = static_cast<double>(covered) / NUMBER_OF_SEEDS;
+  CHECK(coverage > 0.9 && coverage < 0.99);
+}
+
+void test_invalid_options(const std::string& input,
+                          const opt_common::Configuration& configuration) {
+  TasksSamplingOptions rate_and_reservoir;
+  rate_and_reservoir.sampling_rate = 0.5;
+  rate_and_reservoir.reservoir_size = 10;
+  CHECK_THROWS(Application::create_application(input, configuration,
+                                               rate_and_reservoir));
+
+  TasksSamplingOptions small_reservoir;
+  small_reservoir.reservoir_size = 1;
+  CHECK_THROWS(
+      Application::create_application(input, configuration, small_reservoir));
+}
+
+}  // namespace
+
+int main() {
+  opt_common_test::TemporaryDirectory dir;
+  const std::string input = write_trace(dir.get_path());
+  opt_common::Configuration configuration;
+  configuration.read_configuration_from_file(dir.get_path() + "/config.txt");
+  opt_common_test::QuietStdout quiet;
+
+  // A full load is exact
+  const Application full =
+      Application::create_application(input, configuration);
+  CHECK(!full.is_sampled());
+  CHECK_NEAR(full.get_stage_avg_time_interval(0).estimate.to_milliseconds(),
+             500.5, 0.001);
+
+  TasksSamplingOptions by_rate;
+  by_rate.sampling_rate = 0.05;
+  check_sampling(input, configuration, by_rate);
+
+  TasksSamplingOptions by_reservoir;
+  by_reservoir.reservoir_size = 50;
+  check_sampling(input, configuration, by_reservoir);
+
+  // A stage with too few sampled tasks takes the minimum sample instead
+  TasksSamplingOptions tiny_rate;
+  tiny_rate.sampling_rate = 0.001;
+  tiny_rate.min_tasks_per_stage = 50;
+  check_sampling(input, configuration, tiny_rate);
+
+  test_invalid_options(input, configuration);
+  return 0;
+}
@@ -0,0 +1,175 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <opt_common/SharedApplicationCache.hpp>
+#include <set>
+#include <string>
+#include "test/check.hpp"
+#include "test/trace_fixture.hpp"
+
+using opt_common::Application;
+using opt_common::Configuration;
+using opt_common::SharedApplicationCache;
+using opt_common::SharedApplicationView;
+
+namespace {
+
+const Application::FileResources RESOURCES{
+    "app.csv", "jobs.csv", "stages.csv", "tasks.csv", "app.lua", "infra.txt"};
+
+std::set<std::string> list_segments() {
+  std::set<std::string> segments;
+  for (const auto& entry : std::filesystem::directory_iterator("/dev/shm")) {
+    const std::string name = entry.path().filename().string();
+    if (name.rfind("opt_common_app_", 0) == 0) {
+      segments.insert(entry.path().string());
+    }
+  }
+  return segments;
+}
+
+void check_view(const SharedApplicationView& view, double real_time_ms) {
+  CHECK(view.is_valid());
+  CHECK(view.get_application_id() == "app_1");
+  CHECK(view.get_number_of_stages() == 3);
+  CHECK(view.get_number_of_jobs() == 2);
+  CHECK_NEAR(view.compute_avg_execution_time(1).to_milliseconds(), 25191, 0);
+  CHECK_NEAR(view.compute_avg_execution_time(2).to_milliseconds(), 14181.5,
+             0);
+
+  const Application app =
+      view.create_application(RESOURCES, Configuration(), "50000");
+  CHECK_NEAR(app.get_real_execution_time().to_milliseconds(), real_time_ms, 0);
+  CHECK(app.get_all_stages().at(2).get_dependencies().size() == 2);
+  CHECK_NEAR(app.compute_avg_execution_time(2).to_milliseconds(), 14181.5, 0);
+}
+
+//! \return the process which built the segment `path` (in its header)
+std::int64_t read_builder_pid(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  CHECK(fd >= 0);
+  std::int64_t builder_pid = 0;
+  CHECK(::pread(fd, &builder_pid, sizeof(builder_pid), 16) ==
+        static_cast<ssize_t>(sizeof(builder_pid)));
+  ::close(fd);
+  return builder_pid;
+}
+
+// Overwrite the segment `path` from `offset` (or truncate it there)
+void damage_segment(const std::string& path, off_t offset, bool truncate) {
+  const int fd = ::open(path.c_str(), O_RDWR);
+  CHECK(fd >= 0);
+  if (truncate) {
+    CHECK(::ftruncate(fd, offset) == 0);
+  } else {
+    const std::string garbage(64, '\xff');
+    CHECK(::pwrite(fd, garbage.data(), garbage.size(), offset) ==
+          static_cast<ssize_t>(garbage.size()));
+  }
+  ::close(fd);
+}
+
+}  // namespace
+
+int main() {
+  opt_common_test::TemporaryDirectory dir;
+  opt_common_test::write_reference_trace(dir.get_path());
+  Configuration configuration;
+  configuration.read_configuration_from_file(dir.get_path() + "/config.txt");
+  opt_common_test::QuietStdout quiet;
+
+  const std::set<std::string> segments_before = list_segments();
+
+  // The first load parses and publishes the application, another process
+  // maps it
+  const Application parsed = SharedApplicationCache::load_application(
+      RESOURCES, configuration, "50000");
+  CHECK_NEAR(parsed.compute_avg_execution_time(1).to_milliseconds(), 25191,
+             0);
+  const pid_t child = ::fork();
+  if (child == 0) {
+    const Application app = SharedApplicationCache::load_application(
+        RESOURCES, configuration, "50000");
+    std::_Exit(app.compute_avg_execution_time(1).to_milliseconds() == 25191
+                   ? EXIT_SUCCESS
+                   : EXIT_FAILURE);
+  }
+  int status;
+  CHECK(::waitpid(child, &status, 0) == child && WIFEXITED(status) &&
+        WEXITSTATUS(status) == EXIT_SUCCESS);
+
+  const SharedApplicationView view =
+      SharedApplicationCache::map_application(RESOURCES, configuration);
+  check_view(view, 60000);
+
+  std::set<std::string> segments = list_segments();
+  CHECK(segments.size() == segments_before.size() + 1);
+  std::string segment;
+  for (const auto& name : segments) {
+    if (segments_before.count(name) == 0) {
+      segment = name;
+    }
+  }
+  CHECK(read_builder_pid(segment) == ::getpid());
+
+  // A new version of the trace replaces the segment, the old view stays
+  // valid
+  const std::string app_file = dir.get_path() + "/app.csv";
+  opt_common_test::write_file(app_file,
+                              "AppID,Time\napp_1,1000\napp_1,101000\n");
+  check_view(SharedApplicationCache::map_application(RESOURCES, configuration),
+             100000);
+  check_view(view, 60000);
+  CHECK(list_segments() == segments);
+
+  // Even of the same size, a nanosecond later
+  const auto modification_time = std::filesystem::last_write_time(app_file);
+  opt_common_test::write_file(app_file,
+                              "AppID,Time\napp_1,1000\napp_1,111000\n");
+  std::filesystem::last_write_time(
+      app_file, modification_time + std::chrono::nanoseconds(1));
+  check_view(SharedApplicationCache::map_application(RESOURCES, configuration),
+             110000);
+  opt_common_test::write_file(app_file,
+                              "AppID,Time\napp_1,1000\napp_1,101000\n");
+  check_view(SharedApplicationCache::map_application(RESOURCES, configuration),
+             100000);
+
+  // A truncated segment (with the header only) is replaced
+  damage_segment(segment, 256, true);
+  check_view(SharedApplicationCache::map_application(RESOURCES, configuration),
+             100000);
+
+  // A segment with offsets out of its bounds is replaced
+  damage_segment(segment, 32, false);
+  check_view(SharedApplicationCache::map_application(RESOURCES, configuration),
+             100000);
+
+  // A foreign segment is replaced
+  damage_segment(segment, 0, false);
+  check_view(SharedApplicationCache::map_application(RESOURCES, configuration),
+             100000);
+
+  CHECK(SharedApplicationCache::remove_application(RESOURCES, configuration));
+  CHECK(list_segments() == segments_before);
+  return 0;
+}
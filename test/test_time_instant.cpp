@@ -0,0 +1,119 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cstdint>
+#include <limits>
+#include <opt_common/TimeInstant.hpp>
+#include <sstream>
+#include <type_traits>
+#include "test/check.hpp"
+
+using opt_common::TimeInstant;
+
+namespace {
+
+constexpr TimeInstant::Rep MAX_MILLISECONDS =
+    std::numeric_limits<TimeInstant::Rep>::max() / 1000;
+constexpr TimeInstant::Rep MIN_MILLISECONDS =
+    std::numeric_limits<TimeInstant::Rep>::min() / 1000;
+
+// The integer milliseconds are exact up to the limits of the microseconds
+void test_from_integer_milliseconds() {
+  CHECK(TimeInstant::from_milliseconds(25).count_microseconds() == 25000);
+  CHECK(TimeInstant::from_milliseconds(-25).count_microseconds() == -25000);
+  CHECK(TimeInstant::from_milliseconds(60000ul).count_microseconds() ==
+        60000000);
+  CHECK(TimeInstant::from_milliseconds(MAX_MILLISECONDS).count_microseconds() ==
+        MAX_MILLISECONDS * 1000);
+  CHECK(TimeInstant::from_milliseconds(MIN_MILLISECONDS).count_microseconds() ==
+        MIN_MILLISECONDS * 1000);
+
+  CHECK_THROWS(TimeInstant::from_milliseconds(MAX_MILLISECONDS + 1));
+  CHECK_THROWS(TimeInstant::from_milliseconds(MIN_MILLISECONDS - 1));
+  CHECK_THROWS(TimeInstant::from_milliseconds(
+      std::numeric_limits<std::uint64_t>::max()));
+  CHECK_THROWS(TimeInstant::from_milliseconds(
+      static_cast<std::uint64_t>(MAX_MILLISECONDS) + 1));
+}
+
+// The floating milliseconds are rounded to the nearest microsecond (the
+// halves away from zero)
+void test_from_floating_milliseconds() {
+  CHECK(TimeInstant::from_milliseconds(0.25).count_microseconds() == 250);
+  CHECK(TimeInstant::from_milliseconds(0.0625).count_microseconds() == 63);
+  CHECK(TimeInstant::from_milliseconds(-0.0625).count_microseconds() == -63);
+  CHECK(TimeInstant::from_milliseconds(1.0004).count_microseconds() == 1000);
+  CHECK(TimeInstant::from_milliseconds(14181.5).count_microseconds() ==
+        14181500);
+  CHECK(TimeInstant::from_milliseconds(-9.2e15).count_microseconds() ==
+        static_cast<TimeInstant::Rep>(-9.2e18));
+
+  CHECK_THROWS(TimeInstant::from_milliseconds(9.3e15));
+  CHECK_THROWS(TimeInstant::from_milliseconds(-9.3e15));
+  CHECK_THROWS(TimeInstant::from_milliseconds(1e300));
+  CHECK_THROWS(TimeInstant::from_milliseconds(
+      std::numeric_limits<double>::infinity()));
+  CHECK_THROWS(TimeInstant::from_milliseconds(
+      std::numeric_limits<double>::quiet_NaN()));
+}
+
+void test_to_milliseconds() {
+  static_assert(
+      std::is_same<decltype(TimeInstant().to_milliseconds()), double>::value,
+      "the milliseconds are double");
+  static_assert(TimeInstant::from_microseconds(1500).to_milliseconds() == 1.5,
+                "constexpr conversion");
+
+  CHECK(TimeInstant().to_milliseconds() == 0);
+  CHECK(TimeInstant::from_microseconds(-250).to_milliseconds() == -0.25);
+  CHECK(TimeInstant::from_milliseconds(25191).to_milliseconds() == 25191);
+
+  std::ostringstream oss;
+  oss << TimeInstant::from_milliseconds(14181.5);
+  CHECK(oss.str() == "14181.5");
+}
+
+void test_arithmetic() {
+  constexpr TimeInstant one = TimeInstant::from_microseconds(1000);
+  constexpr TimeInstant three = TimeInstant::from_microseconds(3000);
+  static_assert((one + three).count_microseconds() == 4000, "sum");
+  static_assert((one - three).count_microseconds() == -2000, "difference");
+  static_assert((2 * three).count_microseconds() == 6000, "product");
+  static_assert((three * 2).count_microseconds() == 6000, "product");
+  static_assert((three / 2).count_microseconds() == 1500, "quotient");
+  static_assert((one / 3).count_microseconds() == 333, "truncated quotient");
+
+  TimeInstant time = one;
+  time += three;
+  CHECK(time == TimeInstant::from_milliseconds(4));
+  time -= one;
+  CHECK(time == three);
+
+  CHECK(one < three && one <= three && one <= one);
+  CHECK(three > one && three >= one && three >= three);
+  CHECK(one != three && !(one == three));
+  CHECK(!(one < one) && !(one > one));
+}
+
+}  // namespace
+
+int main() {
+  test_from_integer_milliseconds();
+  test_from_floating_milliseconds();
+  test_to_milliseconds();
+  test_arithmetic();
+  return 0;
+}
@@ -0,0 +1,202 @@
+// Copyright 2017 <Biagio Festa>
+
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __OPT_COMMON_TEST__TRACE_FIXTURE__HPP
+#define __OPT_COMMON_TEST__TRACE_FIXTURE__HPP
+#include <stdlib.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <opt_common/helper.hpp>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace opt_common_test {
+
+//! A new empty directory, removed with its files at the end of the scope
+class TemporaryDirectory {
+ public:
+  TemporaryDirectory() {
+    char name_template[] = "/tmp/opt_common_test_XXXXXX";
+    if (mkdtemp(name_template) == nullptr) {
+      THROW_RUNTIME_ERROR("In test: cannot create a temporary directory");
+    }
+    m_path = name_template;
+  }
+  ~TemporaryDirectory() {
+    std::error_code error;
+    std::filesystem::remove_all(m_path, error);
+  }
+
+  TemporaryDirectory(const TemporaryDirectory&) = delete;
+  TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+  const std::string& get_path() const noexcept { return m_path; }
+
+ private:
+  std::string m_path;
+};
+
+//! Discard what is written on the standard output in the scope (e.g. the
+//! logs of Application::create_application)
+struct QuietStdout {
+  std::streambuf* const buffer = std::cout.rdbuf(nullptr);
+  ~QuietStdout() { std::cout.rdbuf(buffer); }
+};
+
+inline void write_file(const std::string& namefile,
+                       const std::string& content) {
+  std::ofstream ofs(namefile, std::ios::binary | std::ios::trunc);
+  ofs << content;
+  if (!ofs) {
+    THROW_RUNTIME_ERROR("In test: cannot write the file '" + namefile + "'");
+  }
+}
+
+inline void append_file(const std::string& namefile,
+                        const std::string& content) {
+  std::ofstream ofs(namefile, std::ios::binary | std::ios::app);
+  ofs << content;
+}
+
+//! Write the configuration (data and lua files in `directory`) and the
+//! input file of a trace. \return the input file
+inline std::string write_input_files(const std::string& directory,
+                                     unsigned long deadline_ms) {
+  write_file(directory + "/config.txt",
+             directory + "\n" + directory + "/dagsim\n" + directory + "\n");
+  write_file(directory + "/infra.txt",
+             "app chi_0 chi_c cm em cc ec\n"
+             "app_1 1000 200000 8 2 4 1\n");
+  write_file(directory + "/input.txt",
+             "app.csv jobs.csv stages.csv tasks.csv app.lua infra.txt " +
+                 std::to_string(deadline_ms) + "\n");
+  return directory + "/input.txt";
+}
+
+/*! Write a small completed trace: 3 stages (0 -> 1 -> 2, 0 -> 2) of 4, 2
+    and 3 tasks in 2 jobs. With n cores the waves model gives
+      T(1) = 25191 ms, T(2) = 14181.5 ms, T(4) = 8462.75 ms
+    \return the input file (the configuration is `directory`/config.txt)
+ */
+inline std::string write_reference_trace(const std::string& directory) {
+  write_file(directory + "/app.csv", "AppID,Time\napp_1,1000\napp_1,61000\n");
+  write_file(directory + "/jobs.csv",
+             "Job ID,Submission Time,Stage IDs,Completion Time\n"
+             "0,1000,\"[0, 1]\",21000\n"
+             "1,22000,\"[2]\",60000\n");
+  write_file(directory + "/stages.csv",
+             "Stage ID,Stage Name,Parent IDs,Number of Tasks,A,B\n"
+             "0,s0,\"[]\",4,x,y\n"
+             "1,s1,\"[0]\",2,x,y\n"
+             "2,s2,\"[0, 1]\",3,x,y\n");
+  write_file(directory + "/tasks.csv",
+             "c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15,c16\n"
+             "x,x,x,x,1017,4348,x,x,x,x,x,x,x,x,x,x,0\n"
+             "x,x,x,x,1097,2355,x,x,x,x,x,x,x,x,x,x,0\n"
+             "x,x,x,x,1032,2514,x,x,x,x,x,x,x,x,x,x,0\n"
+             "x,x,x,x,1063,5179,x,x,x,x,x,x,x,x,x,x,0\n"
+             "x,x,x,x,1057,3991,x,x,x,x,x,x,x,x,x,x,1\n"
+             "x,x,x,x,1083,3637,x,x,x,x,x,x,x,x,x,x,1\n"
+             "x,x,x,x,1100,2959,x,x,x,x,x,x,x,x,x,x,2\n"
+             "x,x,x,x,1012,4010,x,x,x,x,x,x,x,x,x,x,2\n"
+             "x,x,x,x,1003,5662,x,x,x,x,x,x,x,x,x,x,2\n");
+  return write_input_files(directory, 50000);
+}
+
+//! Shape of a synthetic trace
+struct TraceSpec {
+  std::size_t number_of_jobs = 10;
+  std::size_t stages_per_job = 3;  // A chain in each job
+  std::size_t tasks_per_stage = 100;
+
+  //! Cores of the run: the tasks of a stage run in waves of this size
+  unsigned recorded_cores = 8;
+
+  //! The task times are uniform in [average - jitter, average + jitter]
+  unsigned long task_time_ms = 1000;
+  unsigned long task_time_jitter_ms = 200;
+
+  //! Time the driver idles between a job and the next one
+  unsigned long jobs_gap_ms = 0;
+
+  std::uint64_t seed = 1;
+};
+
+/*! Write a completed synthetic trace following `spec`: the jobs run one
+    after the other, the stages of a job one after the other.
+    \return the input file (the configuration is `directory`/config.txt)
+ */
+inline std::string write_synthetic_trace(const std::string& directory,
+                                         const TraceSpec& spec) {
+  std::mt19937_64 random_engine(spec.seed);
+  std::uniform_int_distribution<unsigned long> task_time(
+      spec.task_time_ms - std::min(spec.task_time_jitter_ms, spec.task_time_ms),
+      spec.task_time_ms + spec.task_time_jitter_ms);
+
+  std::ostringstream jobs, stages, tasks;
+  jobs << "Job ID,Submission Time,Stage IDs,Completion Time\n";
+  stages << "Stage ID,Stage Name,Parent IDs,Number of Tasks,A,B\n";
+  tasks << "c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15,c16\n";
+
+  const unsigned long application_start = 1000;
+  unsigned long now = application_start + 500;
+  std::size_t stage_id = 0;
+  for (std::size_t job_id = 0; job_id < spec.number_of_jobs; ++job_id) {
+    const unsigned long submission_time = now;
+    std::ostringstream stage_ids;
+    for (std::size_t s = 0; s < spec.stages_per_job; ++s, ++stage_id) {
+      stage_ids << (s == 0 ? "" : ", ") << stage_id;
+      stages << stage_id << ",s" << stage_id << ",\"["
+             << (s == 0 ? "" : std::to_string(stage_id - 1)) << "]\","
+             << spec.tasks_per_stage << ",x,y\n";
+
+      // Waves of tasks: a wave starts when the previous one is completed
+      for (std::size_t first = 0; first < spec.tasks_per_stage;
+           first += spec.recorded_cores) {
+        unsigned long wave_end = now;
+        const std::size_t last = std::min<std::size_t>(
+            first + spec.recorded_cores, spec.tasks_per_stage);
+        for (std::size_t t = first; t < last; ++t) {
+          const unsigned long finish = now + task_time(random_engine);
+          tasks << "x,x,x,x," << now << "," << finish
+                << ",x,x,x,x,x,x,x,x,x,x," << stage_id << "\n";
+          wave_end = std::max(wave_end, finish);
+        }
+        now = wave_end;
+      }
+    }
+    jobs << job_id << "," << submission_time << ",\"[" << stage_ids.str()
+         << "]\"," << now << "\n";
+    now += spec.jobs_gap_ms;
+  }
+
+  write_file(directory + "/app.csv", "AppID,Time\napp_1," +
+                                         std::to_string(application_start) +
+                                         "\napp_1," +
+                                         std::to_string(now + 500) + "\n");
+  write_file(directory + "/jobs.csv", jobs.str());
+  write_file(directory + "/stages.csv", stages.str());
+  write_file(directory + "/tasks.csv", tasks.str());
+  return write_input_files(directory, 50000);
+}
+
+}  // namespace opt_common_test
+
+#endif  // __OPT_COMMON_TEST__TRACE_FIXTURE__HPP